@@ -0,0 +1,93 @@
+// Texturas comprimidas em blocos (BC1/BC3, também chamados DXT1/DXT5)
+// As imagens são comprimidas antes da execução (--bake-textures) e gravadas com a
+// cadeia de mipmaps inteira em um arquivo KTX2 ao lado da imagem ("mercury.jpg.ktx2").
+// Na carga da cena, se o KTX2 corresponde ao conteúdo atual da imagem (hash gravado
+// nos metadados), os blocos vão direto para o glCompressedTexImage2D: sem decodificar
+// o JPEG/PNG e ocupando 1/8 (BC1) ou 1/4 (BC3) da memória de vídeo do RGBA8
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "Texture.h"
+
+// S3TC não faz parte do núcleo da OpenGL, mas está presente em todo driver de desktop
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+enum BlockFormat
+{
+	BLOCK_FORMAT_BC1,  // RGB, 8 bytes por bloco de 4x4 (4 bits por texel)
+	BLOCK_FORMAT_BC3   // RGBA, 16 bytes por bloco (alfa interpolado + cor BC1)
+};
+
+// Bytes de cada bloco de 4x4 texels
+size_t blockBytes(BlockFormat format);
+
+// Bytes de um nível width x height (blocos parciais nas bordas contam inteiros)
+size_t compressedLevelBytes(BlockFormat format, int width, int height);
+
+struct CompressedLevel
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> data;
+};
+
+// Imagem comprimida com a cadeia de mipmaps (nível 0 = tamanho original)
+struct CompressedImage
+{
+	BlockFormat format = BLOCK_FORMAT_BC1;
+	uint64_t sourceHash = 0;   // hash e tamanho da imagem de origem (validade do arquivo)
+	uint64_t sourceSize = 0;
+	std::vector<CompressedLevel> levels;
+
+	size_t totalBytes() const;
+};
+
+// Comprime blocos de 4x4 texels RGBA8 (64 bytes, linha a linha) em um bloco BC1/BC3
+void encodeBC1Block(const unsigned char* rgba, unsigned char* block);
+void encodeBC3Block(const unsigned char* rgba, unsigned char* block);
+
+// Descompressão de um bloco para 4x4 texels RGBA8 (usada na verificação)
+void decodeBC1Block(const unsigned char* block, unsigned char* rgba);
+void decodeBC3Block(const unsigned char* block, unsigned char* rgba);
+
+// Comprime uma imagem RGBA8 (com ou sem a cadeia de mipmaps, gerada pelo
+// generateMipChain com o filtro de caixa); os blocos são divididos entre as threads do pool padrão
+void compressImage(const unsigned char* rgba, int width, int height, BlockFormat format, bool mipmaps, CompressedImage& image);
+
+// Descomprime um nível para RGBA8 (width * height * 4 bytes)
+void decompressLevel(BlockFormat format, const CompressedLevel& level, std::vector<unsigned char>& rgba);
+
+// Arquivo KTX2 (Khronos): cabeçalho, índice dos níveis, descritor de formato e
+// metadados com o hash da imagem de origem; os níveis ficam do menor para o maior
+bool writeKTX2(const std::string& filePath, const CompressedImage& image);
+bool readKTX2(const std::string& filePath, CompressedImage& image);
+
+// Caminho do KTX2 correspondente à imagem ("<imagem>.ktx2")
+std::string compressedTexturePath(const std::string& imagePath);
+
+// Lê o KTX2 da imagem se ele existir e tiver sido gerado a partir do conteúdo atual dela
+bool loadCompressedTexture(const std::string& imagePath, CompressedImage& image);
+
+// Descarta os primeiros níveis até o maior caber em maxSize x maxSize (os blocos não são
+// redimensionados: fica o primeiro nível da cadeia que cabe); retorna quantos descartou
+int limitCompressedSize(CompressedImage& image, int maxSize);
+
+// Cria a textura com os blocos (todos os níveis se o sampler usa mipmaps) e
+// libera os dados da imagem; 0 se a imagem está vazia
+GLuint createCompressedTexture(const std::string& filePath, CompressedImage& image, const SamplerSettings& sampler = SamplerSettings());
+
+// Comprime cada imagem, grava o KTX2 ao lado dela e confere o arquivo relido
+// (blocos idênticos e PSNR do nível 0 contra a imagem original); retorna se todas passaram
+bool bakeTextures(const std::vector<std::string>& files);
@@ -0,0 +1,95 @@
+// Instrumentação de desenho: tamanho de cada malha carregada e conferência das
+// faixas de desenho contra o buffer que elas usam
+// Cada chamada de desenho é contada como triângulos enviados (o que foi pedido à
+// OpenGL) e triângulos reais (a parte da faixa que existe no buffer); a diferença
+// é trabalho desperdiçado (ou leitura além do fim do buffer)
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "Mesh.h"
+
+// Tamanho de uma malha no momento do carregamento
+struct MeshStats
+{
+	std::string name;
+	GLsizei vertexCount = 0;
+	GLsizei indexCount = 0;      // zero quando a malha não é indexada
+	GLsizei triangleCount = 0;   // do nível 0 (a malha completa)
+	int lodCount = 1;            // níveis de detalhe, contando o nível 0
+	size_t vertexBytes = 0;
+	size_t indexBytes = 0;
+	bool valid = true;           // faixas e índices dentro dos buffers
+};
+
+// Totais acumulados desde o último reset
+struct DrawTotals
+{
+	size_t frames = 0;
+	size_t drawCalls = 0;
+	size_t submittedTriangles = 0;
+	size_t realTriangles = 0;
+	size_t invalidDraws = 0;     // faixas fora do buffer (recortadas antes do desenho)
+	size_t textureBinds = 0;     // trocas de textura entre os desenhos
+	size_t instancedDraws = 0;   // desenhos instanciados (contados também em drawCalls)
+	size_t instances = 0;        // instâncias desenhadas por eles
+	size_t multiDraws = 0;       // envios indiretos (um glMultiDrawElementsIndirect cada)
+	size_t indirectCommands = 0; // comandos desses envios (contados também em drawCalls)
+	size_t visibleObjects = 0;   // objetos que passaram pelo recorte do tronco de visão
+	size_t culledObjects = 0;    // ... e que ficaram de fora (não desenhados)
+	size_t lodObjects[MAX_MESH_LODS] = {};  // objetos visíveis desenhados em cada nível de detalhe
+};
+
+class DrawStats
+{
+public:
+	// Registra a malha e confere suas faixas de material (as dos níveis de detalhe também)
+	// e, se houver, os índices (todos menores que a quantidade de vértices); retorna o
+	// identificador da malha
+	int registerMesh(const std::string& name, const MeshLayout& layout, size_t vertexBytes, const void* indexData, size_t indexBytes);
+
+	const MeshStats& mesh(int id) const { return meshes[id]; }
+
+	// Confere [first, first + count) contra o buffer da malha (índices ou vértices)
+	bool validateRange(int id, GLint first, GLsizei count) const;
+
+	// Conta uma chamada de desenho e devolve a quantidade de elementos que cabe no
+	// buffer, que é o que deve ser desenhado; o primeiro erro de cada malha é impresso.
+	// Um desenho instanciado (instances > 0) conta os triângulos de todas as instâncias
+	GLsizei recordDraw(int id, GLint first, GLsizei count, GLsizei instances = 0);
+
+	// Conta uma troca de textura (glBindTexture antes de um desenho)
+	void recordTextureBind() { totals.textureBinds++; }
+
+	// Conta um envio indireto com commands comandos (cada um passa também pelo recordDraw)
+	void recordMultiDraw(size_t commands) { totals.multiDraws++; totals.indirectCommands += commands; }
+
+	// Conta o resultado do recorte do tronco de visão de um frame
+	void recordCulling(size_t visible, size_t culled) { totals.visibleObjects += visible; totals.culledObjects += culled; }
+
+	// Conta os objetos visíveis de um frame em cada nível de detalhe
+	void recordLods(const size_t* objects)
+	{
+		for (int lod = 0; lod < MAX_MESH_LODS; lod++)
+			totals.lodObjects[lod] += objects[lod];
+	}
+
+	void endFrame() { totals.frames++; }
+
+	// Médias por frame desde o último reset
+	void report(std::ostream& out) const;
+	void reset() { totals = DrawTotals(); }
+
+	const DrawTotals& frameTotals() const { return totals; }
+
+private:
+	std::vector<MeshStats> meshes;
+	std::vector<bool> reportedInvalidDraw;
+	DrawTotals totals;
+};
@@ -0,0 +1,146 @@
+// Hierarquia de volumes envolventes (BVH) dinâmica sobre as caixas dos objetos no mundo
+// Árvore binária: cada folha guarda um objeto e cada nó interno a caixa que envolve os
+// dois filhos. A inserção procura o irmão que menos aumenta a soma das áreas das caixas
+// (heurística de área de superfície) e, na volta até a raiz, troca netos de lado quando
+// isso diminui a área; a árvore nunca é reconstruída inteira.
+// - Objetos parados que mudam a caixa no lugar (ex: giram) usam refit: a folha troca a
+//   caixa e os ancestrais são refeitos de uma vez, de baixo para cima, no próximo teste
+// - Objetos que se deslocam (ex: pelas curvas de Bézier) usam move: a folha guarda uma
+//   caixa com folga e só é retirada e reinserida quando o objeto sai dela
+// O recorte pelo tronco descarta subárvores inteiras e para de testar os planos que uma
+// caixa já tem inteiros do lado de dentro. Não usa a OpenGL
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "FrustumCuller.h"
+
+struct Aabb
+{
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+
+	// Caixa no mundo que envolve a caixa local transformada pela matriz de modelo (Arvo)
+	static Aabb transformed(const glm::mat4& model, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+	Aabb merged(const Aabb& other) const { return { glm::min(min, other.min), glm::max(max, other.max) }; }
+	bool contains(const Aabb& other) const;
+	float surfaceArea() const;
+};
+
+// Distância até a entrada do raio na caixa (0 se a origem está dentro) ou -1 se não acerta
+// antes de maxDistance; inverseDirection = 1 / direção, por componente
+float intersectRay(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance);
+
+class DynamicBVH
+{
+public:
+	// Árvore nova com o objeto i na caixa boxes[i], dividida de cima para baixo pela área
+	// (mais rápida e melhor que inserir um a um); leaves[i] recebe a folha do objeto i
+	void build(const std::vector<Aabb>& boxes, std::vector<int>& leaves);
+
+	// Folha nova com a caixa do objeto (índice do objeto do chamador); retorna a folha
+	int insert(const Aabb& box, int object);
+	void remove(int leaf);
+
+	// Caixa nova sem mudar a árvore (os ancestrais são refeitos no próximo cull/raycast)
+	void refit(int leaf, const Aabb& box);
+
+	// Caixa nova de um objeto que se desloca; retorna se a folha foi reinserida
+	bool move(int leaf, const Aabb& box);
+
+	// Refaz as caixas marcadas pelo refit (cull e raycast já chamam)
+	void refitPending();
+
+	// visible[objeto] = 1 se a caixa do objeto pode aparecer (uma posição por objeto
+	// inserido); retorna quantos podem
+	size_t cull(const Frustum& frustum, std::vector<unsigned char>& visible);
+
+	struct RayHit
+	{
+		int object = -1;  // -1: nenhum
+		float distance = 0.0f;
+	};
+
+	// Objeto mais próximo acertado pelo raio até maxDistance. exact (opcional) refina o
+	// teste de cada objeto cuja caixa o raio acerta: retorna se acertou e ajusta a distância
+	RayHit raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+		const std::function<bool(int object, float& distance)>& exact = nullptr);
+
+	size_t leafCount() const { return leaves; }
+	int height() const { return root < 0 ? 0 : nodes[root].height; }
+
+	// Soma das áreas dos nós internos dividida pela área da raiz (menor: árvore melhor)
+	float areaCost() const;
+
+	struct Counters
+	{
+		size_t refits = 0;
+		size_t moves = 0;
+		size_t reinserts = 0;
+		size_t frames = 0;
+	};
+
+	void endFrame() { counters.frames++; }
+
+	// Tamanho da árvore e médias por frame desde o último reset
+	void report(std::ostream& out) const;
+	void reset() { counters = Counters(); }
+
+private:
+	struct Node
+	{
+		Aabb box;        // nós internos: envolve os filhos; folhas: caixa do objeto com a folga do move
+		int parent = -1; // nós livres: próximo da lista livre
+		int child1 = -1;
+		int child2 = -1;
+		int height = 0;  // 0 nas folhas, -1 nos nós livres
+		int object = -1;
+		bool pending = false;  // caixa desatualizada (o refit marca a folha e os ancestrais)
+
+		bool isLeaf() const { return child1 < 0; }
+	};
+
+	struct StackEntry
+	{
+		int node;
+		unsigned planes;  // cull: planos que a caixa do pai não tem inteiros do lado de dentro
+		float distance;   // raycast: entrada do raio na caixa
+	};
+
+	int allocateNode();
+	struct BuildItem
+	{
+		Aabb box;
+		int object;
+	};
+
+	int buildRange(BuildItem* items, size_t count, std::vector<int>& leaves);
+	void freeNode(int index);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int findBestSibling(const Aabb& box) const;
+	void rotate(int index);
+	void updateFromChildren(int index);
+	void refitNode(int index);
+
+	std::vector<Node> nodes;
+	std::vector<Aabb> objectBoxes;  // por nó, só nas folhas: caixa do objeto (usada nos testes)
+	std::vector<StackEntry> stack;
+	int root = -1;
+	int freeList = -1;
+	size_t leaves = 0;
+	size_t objectSlots = 0;  // maior índice de objeto inserido + 1
+	Counters counters;
+};
+
+// Construção, recorte, raios e atualizações de cenas de 1 mil até maxObjects objetos,
+// conferidos contra a busca linear em todas as caixas: --bench-bvh [objetos]
+void benchmarkBVH(size_t maxObjects = 1000000);
@@ -0,0 +1,64 @@
+// Dados de câmera e luz compartilhados por todos os programas em um uniform buffer
+// O bloco FrameData (layout std140) é declarado igual nos shaders e ligado no mesmo
+// ponto de ligação; o renderizador atualiza o buffer uma vez por frame com um único
+// glBufferSubData, em vez de um glUniform* por programa (ou por objeto)
+
+#pragma once
+
+#include <cstddef>
+
+//GLAD
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+// Ponto de ligação do bloco FrameData
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+// Espelho do bloco no std140: mat4 ocupa 64 bytes e vec3 é alinhado como vec4
+struct FrameData
+{
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);
+	glm::mat4 viewProjection = glm::mat4(1.0f);
+	glm::vec4 cameraPos = glm::vec4(0.0f);   // xyz
+	glm::vec4 lightPos = glm::vec4(0.0f);    // xyz
+	glm::vec4 lightColor = glm::vec4(1.0f);  // rgb
+};
+static_assert(sizeof(FrameData) == 240, "FrameData precisa seguir o layout std140 do bloco");
+
+class FrameUniforms
+{
+public:
+	FrameUniforms() {}
+	~FrameUniforms();
+
+	FrameUniforms(const FrameUniforms&) = delete;
+	FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+	// Cria o buffer e o liga em FRAME_UNIFORMS_BINDING (precisa do contexto OpenGL)
+	void initialize();
+
+	// Libera o buffer (com o contexto ainda ativo)
+	void shutdown();
+
+	// Liga o bloco FrameData do programa ao ponto de ligação; avisa se o programa não
+	// tem o bloco ou se o tamanho dele não é o de FrameData
+	bool attach(const Shader& shader) const;
+
+	void setProjection(const glm::mat4& projection);
+	void setCamera(const glm::mat4& view, const glm::vec3& position);
+	void setLight(const glm::vec3& position, const glm::vec3& color);
+
+	// Envia o bloco inteiro (uma vez por frame, antes dos desenhos)
+	void upload();
+
+	const FrameData& values() const { return data; }
+
+private:
+	FrameData data;
+	GLuint buffer = 0;
+};
@@ -0,0 +1,62 @@
+// Recorte pelo tronco de visão (frustum culling)
+// Os limites de cada objeto no mundo ficam em arrays separados por componente (SoA):
+// a caixa alinhada aos eixos que envolve a caixa local transformada pela matriz de
+// modelo, e a esfera local transformada. O teste lê 4 (SSE2) ou 8 (AVX2) objetos por
+// vez contra os seis planos tirados de projection * view: o objeto sai se, para algum
+// plano, a esfera ou a caixa está inteira do lado de fora. Os dois testes são
+// conservadores, então um objeto visível nunca é recortado. Não usa a OpenGL
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Conjunto de instruções do teste (os três dão o mesmo resultado)
+enum CullSimd
+{
+	CULL_SIMD_SCALAR,
+	CULL_SIMD_SSE2,
+	CULL_SIMD_AVX2
+};
+
+// Melhor conjunto de instruções disponível no processador
+CullSimd bestCullSimd();
+const char* cullSimdName(CullSimd simd);
+
+// Planos do tronco (ax + by + cz + d >= 0 do lado de dentro, normais unitárias) na
+// ordem esquerda, direita, baixo, cima, perto, longe
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	static Frustum fromMatrix(const glm::mat4& viewProjection);
+};
+
+class FrustumCuller
+{
+public:
+	// Quantidade de objetos (os limites novos começam vazios, sempre visíveis)
+	void resize(size_t count);
+	size_t size() const { return count; }
+
+	// Limites do objeto index no mundo a partir dos limites locais e da matriz de modelo
+	void setBounds(size_t index, const glm::mat4& model, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+		const glm::vec3& sphereCenter, float sphereRadius);
+
+	// visible[i] = 1 se o objeto i pode aparecer; retorna quantos podem
+	size_t cull(const Frustum& frustum, std::vector<unsigned char>& visible, CullSimd simd = bestCullSimd()) const;
+
+private:
+	size_t count = 0;
+	// Capacidade múltipla de 8 (uma passada AVX2); as posições a mais nunca são escritas
+	std::vector<float> boxX, boxY, boxZ;           // centro da caixa
+	std::vector<float> extentX, extentY, extentZ;  // meia largura da caixa
+	std::vector<float> sphereX, sphereY, sphereZ, radius;
+};
+
+// Teste de 100 mil objetos (por padrão) espalhados ao redor de uma câmera com cada
+// conjunto de instruções, conferindo que todos recortam os mesmos: --bench-culling [objetos]
+void benchmarkFrustumCulling(size_t objects = 100000, int repetitions = 50);
@@ -0,0 +1,81 @@
+// Cópia do estado da OpenGL que muda entre os desenhos (programa, VAO, unidade de textura
+// ativa, texturas por unidade e alvo, uniforms escalares e vec3): os pedidos iguais ao
+// estado atual não chegam à OpenGL. Conta as trocas enviadas e as evitadas por frame.
+// Código que mexe no estado por fora (ex: envio de texturas, arrays de textura) deve ser
+// seguido de invalidate()
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "Shader.h"
+
+class GLStateCache
+{
+public:
+	// Esquece o estado conhecido: o próximo pedido de cada tipo é enviado
+	void invalidate();
+
+	// Cada função retorna se a troca foi enviada à OpenGL
+	bool useProgram(GLuint program);
+	bool bindVertexArray(GLuint vao);
+	bool bindTexture(GLenum unit, GLenum target, GLuint texture);  // unit: GL_TEXTURE0 + i
+
+	// Uniforms do programa atual (os valores de um programa se perdem ao trocar de programa)
+	bool set(const UniformInt& uniform, int value);
+	bool set(const UniformFloat& uniform, float value);
+	bool set(const UniformVec3& uniform, const float* value);
+
+	struct Counters
+	{
+		size_t programs = 0;
+		size_t vertexArrays = 0;
+		size_t activeUnits = 0;
+		size_t textures = 0;
+		size_t uniforms = 0;
+		size_t skipped = 0;  // pedidos iguais ao estado atual
+		size_t frames = 0;
+
+		size_t changes() const { return programs + vertexArrays + activeUnits + textures + uniforms; }
+	};
+
+	void endFrame() { counters.frames++; }
+
+	// Médias por frame desde o último reset
+	void report(std::ostream& out) const;
+	void reset() { counters = Counters(); }
+
+	const Counters& frameCounters() const { return counters; }
+
+private:
+	struct TextureBinding
+	{
+		GLenum unit;
+		GLenum target;
+		GLuint texture;
+	};
+
+	struct UniformValue
+	{
+		bool known = false;
+		float values[3] = {};
+	};
+
+	// Compara e guarda o valor do uniform; retorna se mudou
+	bool changeUniform(GLint location, const float* values, int count);
+
+	bool programKnown = false;
+	GLuint program = 0;
+	bool vertexArrayKnown = false;
+	GLuint vertexArray = 0;
+	bool activeUnitKnown = false;
+	GLenum activeUnit = GL_TEXTURE0;
+	std::vector<TextureBinding> textures;  // só as ligações conhecidas
+	std::vector<UniformValue> uniforms;    // por location
+	Counters counters;
+};
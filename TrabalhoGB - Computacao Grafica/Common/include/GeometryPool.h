@@ -0,0 +1,73 @@
+// Buffers de geometria compartilhados entre as malhas
+// As malhas com o mesmo layout de vértice são subalocadas em poucos buffers grandes
+// (blocos), cada um com um único VAO: desenhar malhas diferentes não troca de VAO, o
+// que permite enviar a cena inteira com um glMultiDrawElementsIndirect. Os índices
+// ficam sempre em 32 bits, relativos ao primeiro vértice da malha (baseVertex); as
+// malhas não indexadas recebem índices sequenciais
+
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "Mesh.h"
+
+class GeometryPool
+{
+public:
+	// Capacidade de cada bloco novo (um bloco maior é criado para uma malha que não caiba)
+	explicit GeometryPool(size_t blockVertexBytes = 8 * 1024 * 1024, size_t blockIndexBytes = 4 * 1024 * 1024);
+	~GeometryPool();
+
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+	// Posição da malha no pool: desenhar com glDrawElementsBaseVertex(..., GL_UNSIGNED_INT,
+	// (firstIndex + primeiro índice da faixa) * 4, baseVertex) com o vao vinculado
+	struct Allocation
+	{
+		GLuint vao = 0;
+		int block = -1;
+		GLint baseVertex = 0;
+		GLuint firstIndex = 0;
+		GLsizei indexCount = 0;
+	};
+
+	// Copia a malha para o primeiro bloco de mesmo layout com espaço livre (ou para um
+	// bloco novo); precisa do contexto OpenGL
+	Allocation add(const MeshLayout& layout, const void* vertexData, size_t vertexBytes, const void* indexData, size_t indexBytes);
+
+	size_t blockCount() const { return blocks.size(); }
+	size_t usedBytes() const;
+	size_t capacityBytes() const;
+
+	// Apaga os blocos (com o contexto ainda ativo)
+	void clear();
+
+	void report(std::ostream& out) const;
+
+private:
+	struct Block
+	{
+		GLuint vao = 0;
+		GLuint vbo = 0;
+		GLuint ebo = 0;
+		VertexFormat format = VERTEX_FORMAT_FLOAT;
+		GLenum texCoordType = GL_FLOAT;
+		size_t vertexCapacity = 0;  // bytes
+		size_t indexCapacity = 0;
+		size_t vertexUsed = 0;
+		size_t indexUsed = 0;
+		int meshes = 0;
+	};
+
+	Block& createBlock(const MeshLayout& layout, size_t vertexBytes, size_t indexBytes);
+
+	size_t blockVertexBytes;
+	size_t blockIndexBytes;
+	std::vector<Block> blocks;
+};
@@ -0,0 +1,96 @@
+// Desenho indireto: vários comandos de desenho em um buffer na GPU, enviados com um
+// único glMultiDrawElementsIndirect. Cada comando desenha uma faixa de índices do
+// GeometryPool com instanceCount instâncias; o baseInstance aponta para os dados do
+// comando no InstanceBuffer (matriz de modelo, desquantização, camada e material),
+// fazendo o papel do gl_DrawID, que exigiria a OpenGL 4.6. Os materiais ficam em uma
+// tabela (buffer de textura) lida no phong.fs pelo índice que vem da instância
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Layout exigido pela OpenGL para GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	GLuint count = 0;
+	GLuint instanceCount = 0;
+	GLuint firstIndex = 0;
+	GLint baseVertex = 0;
+	GLuint baseInstance = 0;
+};
+
+// Carrega o glMultiDrawElementsIndirect (OpenGL 4.3, fora do GLAD 4.0 do projeto) com
+// a função de carga da janela; sem ele não há desenho indireto (um glDrawElementsIndirect
+// por comando não serve: antes da 4.2 o baseInstance é ignorado)
+bool loadMultiDrawIndirect(GLADloadproc load);
+bool hasMultiDrawIndirect();
+
+class IndirectDrawBuffer
+{
+public:
+	IndirectDrawBuffer() {}
+	~IndirectDrawBuffer();
+
+	IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+	IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+
+	// Cria o buffer (precisa do contexto OpenGL)
+	void initialize();
+
+	// Libera o buffer (com o contexto ainda ativo)
+	void shutdown();
+
+	// Substitui os comandos (só quando a lista muda; os dados por instância vêm à parte)
+	void upload(const std::vector<DrawElementsIndirectCommand>& commands);
+
+	// Desenha count comandos a partir de first com o VAO vinculado (índices de 32 bits;
+	// exige hasMultiDrawIndirect())
+	void draw(size_t first, size_t count) const;
+
+private:
+	GLuint buffer = 0;
+};
+
+class MaterialTable
+{
+public:
+	MaterialTable() {}
+	~MaterialTable();
+
+	MaterialTable(const MaterialTable&) = delete;
+	MaterialTable& operator=(const MaterialTable&) = delete;
+
+	// Cria o buffer e a textura que o lê (precisa do contexto OpenGL)
+	void initialize();
+
+	// Libera o buffer e a textura (com o contexto ainda ativo)
+	void shutdown();
+
+	// Índice do material com esses coeficientes (iguais são reaproveitados)
+	int add(const glm::vec3& ka, const glm::vec3& kd, const glm::vec3& ks);
+
+	// Esvazia a tabela (os índices antigos deixam de valer)
+	void clear() { texels.clear(); }
+
+	size_t size() const { return texels.size() / TEXELS_PER_MATERIAL; }
+
+	// Envia a tabela: GL_RGBA32F, três texels por material (ka, kd, ks)
+	void upload();
+
+	// Liga a textura da tabela na unidade (o phong.fs lê com texelFetch)
+	void bind(GLenum unit) const;
+
+	static const int TEXELS_PER_MATERIAL = 3;
+
+private:
+	std::vector<glm::vec4> texels;
+	GLuint buffer = 0;
+	GLuint texture = 0;
+};
@@ -0,0 +1,58 @@
+// Dados por instância dos desenhos instanciados (glDrawElementsInstanced e indiretos)
+// A matriz de modelo, a desquantização da malha, a camada do array de textura e o
+// material de todas as instâncias do frame ficam em um único buffer de vértices, lido
+// com divisor 1 pelos atributos 4 a 9 do phong.vs. Cada grupo aponta esses atributos
+// para o seu trecho do buffer antes do desenho; nos desenhos indiretos o baseInstance
+// de cada comando faz esse papel
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+// Localizações dos atributos de instância no phong.vs (a matriz ocupa 4 localizações)
+const GLuint INSTANCE_ATTRIBUTE_MODEL = 4;
+const GLuint INSTANCE_ATTRIBUTE_SCALE = 8;
+const GLuint INSTANCE_ATTRIBUTE_OFFSET = 9;
+
+struct InstanceData
+{
+	glm::mat4 model = glm::mat4(1.0f);
+	glm::vec4 posScale = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);    // xyz; w: camada do array de textura
+	glm::vec4 posOffset = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);  // xyz; w: material na MaterialTable (-1: uniforms ka, kd, ks)
+};
+
+class InstanceBuffer
+{
+public:
+	InstanceBuffer() {}
+	~InstanceBuffer();
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+	// Cria o buffer (precisa do contexto OpenGL)
+	void initialize();
+
+	// Libera o buffer (com o contexto ainda ativo)
+	void shutdown();
+
+	// Envia as instâncias do frame. O armazenamento é trocado a cada envio (orphaning),
+	// para não esperar a GPU terminar de ler o frame anterior
+	void upload(const std::vector<InstanceData>& instances);
+
+	// Aponta os atributos de instância do VAO vinculado para as instâncias a partir de first
+	void point(size_t first) const;
+
+	size_t capacityBytes() const { return capacity; }
+
+private:
+	GLuint buffer = 0;
+	size_t capacity = 0;
+};
@@ -0,0 +1,37 @@
+// Arquivo mapeado em memória (somente leitura)
+// Evita copiar o conteúdo do disco para buffers intermediários: o parser lê
+// direto das páginas mapeadas pelo sistema operacional
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Mapeia o arquivo inteiro; retorna false se não foi possível abrir
+	bool open(const std::string& filePath);
+	void close();
+
+	bool isOpen() const { return opened; }
+	const char* data() const { return ptr; }
+	size_t size() const { return length; }
+	const char* begin() const { return ptr; }
+	const char* end() const { return ptr + length; }
+
+private:
+	const char* ptr = nullptr;
+	size_t length = 0;
+	bool opened = false;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,20 @@
+// Uso de memória do processo (RSS / working set)
+// Usado para relatar o pico de memória de cada carregamento de malha
+
+#pragma once
+
+#include <cstddef>
+
+// Memória residente atual do processo, em bytes (0 se indisponível)
+size_t currentRSS();
+
+// Maior memória residente desde o início do processo (ou desde resetPeakRSS)
+size_t peakRSS();
+
+// Reinicia o pico para o valor atual; nem todo sistema permite (no Windows
+// o pico só cresce), então retorna se conseguiu
+bool resetPeakRSS();
+
+// Devolve ao sistema a memória livre retida pelo alocador, quando possível,
+// para que medições seguidas não sejam afetadas pela anterior
+void releaseFreeMemory();
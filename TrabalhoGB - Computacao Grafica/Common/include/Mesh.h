@@ -0,0 +1,86 @@
+// Buffers de geometria prontos para a OpenGL
+// Converte a malha lida do .obj (floats) para o layout de vértice escolhido e
+// configura os atributos do VAO correspondentes ao phong.vs
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+//GLM
+#include <glm/glm.hpp>
+
+#include "OBJLoader.h"
+
+enum VertexFormat
+{
+	VERTEX_FORMAT_FLOAT,  // 44 bytes: posição, cor, textura e normal em GL_FLOAT
+	VERTEX_FORMAT_PACKED  // 16 bytes: posição unorm16, textura unorm16/half, normal 2_10_10_10
+};
+
+// Níveis de detalhe de uma malha, contando a malha completa (nível 0)
+const int MAX_MESH_LODS = 4;
+
+// Nível de detalhe simplificado: os índices ficam no mesmo buffer, depois dos do nível
+// anterior, e usam os mesmos vértices
+struct MeshLod
+{
+	float error = 0.0f;        // erro geométrico estimado, relativo ao raio da esfera envolvente
+	unsigned int first = 0;    // faixa de índices do nível
+	unsigned int count = 0;
+	std::vector<SubMesh> submeshes;  // faixas por material dentro da faixa do nível
+};
+
+// Descrição do conteúdo dos buffers (o que é preciso para configurar o VAO e desenhar)
+struct MeshLayout
+{
+	VertexFormat format = VERTEX_FORMAT_FLOAT;
+	GLsizei vertexCount = 0;
+	GLsizei indexCount = 0;                // zero quando a malha não é indexada
+	GLenum indexType = GL_UNSIGNED_INT;    // GL_UNSIGNED_SHORT ou GL_UNSIGNED_INT
+	GLenum texCoordType = GL_FLOAT;        // no formato compacto: GL_UNSIGNED_SHORT ou GL_HALF_FLOAT
+
+	// Desquantização da posição no vertex shader: posOffset + posScale * posição
+	glm::vec3 posScale = glm::vec3(1.0f);
+	glm::vec3 posOffset = glm::vec3(0.0f);
+
+	// Caixa envolvente das posições, em coordenadas do modelo
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+
+	// Esfera envolvente: centro da caixa e distância ao vértice mais afastado (recorte
+	// pelo tronco de visão; mais justa que a meia diagonal da caixa)
+	glm::vec3 sphereCenter = glm::vec3(0.0f);
+	float sphereRadius = 0.0f;
+
+	// Faixas de desenho por material (em índices, ou em vértices se não indexada)
+	std::vector<SubMesh> submeshes;
+
+	// Níveis 1 em diante (vazio: só a malha completa)
+	std::vector<MeshLod> lods;
+
+	// Índices (ou vértices) do nível 0; os dos níveis simplificados vêm depois
+	GLsizei baseElementCount() const;
+};
+
+struct MeshBuffers
+{
+	MeshLayout layout;
+	std::vector<unsigned char> vertexData;
+	std::vector<unsigned char> indexData;  // vazio quando a malha não é indexada
+};
+
+// Tamanho em bytes de um vértice no formato
+GLsizei vertexStride(VertexFormat format);
+
+// Converte a malha para o formato pedido (índices de 16 bits quando cabem)
+void buildMeshBuffers(const MeshData& mesh, VertexFormat format, MeshBuffers& buffers);
+
+// Configura os atributos do VAO vinculado para o VBO vinculado em GL_ARRAY_BUFFER
+void setupVertexAttributes(const MeshLayout& layout);
+
+// "float" ou "packed" (usado no sceneConfig.json)
+VertexFormat vertexFormatFromString(const std::string& name);
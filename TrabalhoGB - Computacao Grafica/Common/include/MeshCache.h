@@ -0,0 +1,83 @@
+// Cache binário de malhas processadas (arquivos ".meshcache" ao lado do .obj)
+// Guarda os buffers de vértices e índices já no formato da GPU. Na próxima
+// execução o arquivo é mapeado em memória e entregue direto ao glBufferData,
+// sem parsing. A entrada só vale se o hash do conteúdo do .obj, as opções do
+// carregador e a versão do formato do cache forem os mesmos. Os níveis de detalhe
+// (simplificação, a parte mais cara da preparação) também ficam no cache.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+// Incrementar sempre que o layout do arquivo ou o processamento da malha mudar
+const uint32_t MESH_CACHE_VERSION = 7;
+
+struct MeshCacheKey
+{
+	uint64_t sourceHash = 0;   // hash do conteúdo do .obj
+	uint64_t sourceSize = 0;
+	uint32_t optionsKey = 0;   // opções do carregador (índices, agrupar por material) + otimização + formato de vértice + níveis de detalhe
+};
+
+// Hash de 64 bits do conteúdo de um bloco de memória
+uint64_t hashBytes(const void* data, size_t size);
+
+MeshCacheKey makeMeshCacheKey(const MappedFile& objFile, const OBJLoadOptions& options, MeshOptimization optimization, VertexFormat format, int lodLevels);
+
+// Caminho do arquivo de cache correspondente ao .obj; cada combinação de opções
+// tem o seu arquivo, para que carregar o mesmo .obj de dois jeitos não invalide o outro
+std::string meshCachePath(const std::string& objPath, const MeshCacheKey& key);
+
+// Entrada do cache mapeada em memória; os ponteiros valem enquanto o objeto existir
+class MeshCacheEntry
+{
+public:
+	bool open(const std::string& cachePath, const MeshCacheKey& key);
+
+	MeshLayout layout;
+	const unsigned char* vertexData = nullptr;
+	size_t vertexBytes = 0;
+	const unsigned char* indexData = nullptr;
+	size_t indexBytes = 0;
+
+private:
+	MappedFile file;
+};
+
+// Grava a entrada (em arquivo temporário + rename, para nunca deixar um cache pela metade)
+bool saveMeshCache(const std::string& cachePath, const MeshCacheKey& key, const MeshBuffers& buffers);
+
+// Malha pronta para o envio à GPU, vinda do cache (mapeado) ou do parsing do .obj.
+// Não usa a OpenGL: pode ser preparada em uma thread de trabalho e enviada depois
+// pela thread que tem o contexto
+struct PreparedMesh
+{
+	MeshLayout layout;
+	const void* vertexData = nullptr;
+	size_t vertexBytes = 0;
+	const void* indexData = nullptr;
+	size_t indexBytes = 0;
+
+	bool fromCache = false;
+	bool cacheSaveFailed = false;
+	double seconds = 0.0;  // tempo de preparação (leitura + parsing ou cache)
+	size_t peakRSS = 0;    // pico de memória do processo ao fim da preparação (bytes)
+
+	// ACMR/ATVR da ordem original (só quando houve parsing) e da ordem final (nível 0)
+	bool hasOriginalStats = false;
+	VertexCacheStats originalStats;
+	VertexCacheStats stats;
+
+	MeshCacheEntry cacheEntry;  // dono dos dados quando fromCache
+	MeshBuffers buffers;        // dono dos dados quando veio do parsing
+};
+
+// Lê o .obj, gera até lodLevels níveis de detalhe (contando a malha completa; 1: nenhum),
+// otimiza a ordem dos triângulos e prepara os buffers no formato pedido, consultando e
+// atualizando o cache
+bool prepareMesh(const std::string& objPath, const OBJLoadOptions& options, MeshOptimization optimization, VertexFormat format, int lodLevels, bool useCache, PreparedMesh& prepared);
@@ -0,0 +1,88 @@
+// Otimização da ordem de triângulos e vértices de malhas indexadas
+// - cache de vértices pós-transformação: algoritmo de Tom Forsyth ("Linear-Speed
+//   Vertex Cache Optimisation"), que escolhe a cada passo o triângulo de maior
+//   pontuação entre os que usam vértices recém-transformados
+// - overdraw: a sequência otimizada é dividida em grupos nos pontos em que o cache
+//   recomeça, e os grupos voltados para fora da malha são desenhados primeiro
+//   (Sander, Nehab e Barczak, "Fast Triangle Reordering for Vertex Locality and
+//   Reduced Overdraw"), aceitando uma piora limitada do ACMR
+// - busca de vértices: os vértices são renumerados na ordem do primeiro uso
+// Cada trecho de material (SubMesh) é reordenado separadamente e mantém a sua faixa
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "OBJLoader.h"
+
+// Tamanho do cache FIFO usado para medir ACMR/ATVR
+const unsigned int VERTEX_CACHE_SIMULATION_SIZE = 16;
+
+enum MeshOptimization
+{
+	MESH_OPTIMIZATION_NONE,          // ordem original do exportador
+	MESH_OPTIMIZATION_VERTEX_CACHE,  // cache de vértices + busca de vértices
+	MESH_OPTIMIZATION_OVERDRAW       // cache de vértices + overdraw + busca de vértices
+};
+
+struct VertexCacheStats
+{
+	float acmr = 0.0f;  // vértices transformados por triângulo (ideal ~0.5, pior caso 3)
+	float atvr = 0.0f;  // vértices transformados por vértice único (ideal 1)
+};
+
+// Simula um cache FIFO de cacheSize entradas sobre a lista de índices
+template <typename Index>
+VertexCacheStats analyzeVertexCache(const Index* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIMULATION_SIZE)
+{
+	VertexCacheStats stats;
+	if (indexCount < 3 || vertexCount == 0)
+		return stats;
+
+	// Um vértice está no cache se entrou há menos de cacheSize falhas
+	std::vector<unsigned int> insertedAt(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	unsigned int misses = 0;
+	size_t uniqueVertices = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		Index v = indices[i];
+		if (!used[v])
+		{
+			used[v] = true;
+			uniqueVertices++;
+		}
+		else if (misses - insertedAt[v] < cacheSize)
+		{
+			continue;
+		}
+		misses++;
+		insertedAt[v] = misses;
+	}
+
+	stats.acmr = (float)misses / (float)(indexCount / 3);
+	stats.atvr = (float)misses / (float)uniqueVertices;
+	return stats;
+}
+
+VertexCacheStats analyzeVertexCache(const MeshData& mesh);
+
+// Reordena os triângulos para aproveitar o cache de vértices (algoritmo de Forsyth)
+void optimizeVertexCache(MeshData& mesh);
+
+// Reordena grupos de triângulos (já otimizados para o cache) para reduzir o overdraw;
+// threshold é a piora máxima aceita no ACMR de cada grupo (1.05 = 5%)
+void optimizeOverdraw(MeshData& mesh, float threshold = 1.05f);
+
+// Renumera os vértices na ordem do primeiro uso pelos índices (descarta os não usados)
+void optimizeVertexFetch(MeshData& mesh);
+
+// Aplica as etapas correspondentes ao modo (malhas não indexadas não são alteradas)
+void optimizeMesh(MeshData& mesh, MeshOptimization optimization);
+
+// "none", "vertexCache" ou "overdraw" (usado no sceneConfig.json)
+MeshOptimization meshOptimizationFromString(const std::string& name);
+
+// Compara ACMR/ATVR e tempo de cada modo de otimização nos arquivos
+void benchmarkMeshOptimizer(const std::vector<std::string>& files);
@@ -0,0 +1,47 @@
+// Simplificação de malhas indexadas por métrica de erro quádrica (Garland e Heckbert,
+// "Surface Simplification Using Quadric Error Metrics")
+// Cada vértice acumula os planos dos triângulos ao seu redor (ponderados pela área); uma
+// aresta colapsa levando um extremo até o outro, e o custo é a distância quadrática média
+// do ponto aos planos acumulados pelos dois. Os colapsos mais baratos vêm primeiro, até a
+// quantidade de triângulos pedida. Os vértices não mudam de posição nem ganham novos: os
+// níveis de detalhe usam o mesmo buffer de vértices da malha completa
+// - vértices na mesma posição com textura ou normal diferentes (costuras) só colapsam ao
+//   longo da costura, cada lado para o vértice do mesmo lado
+// - bordas, costuras e divisas entre materiais ganham planos perpendiculares à superfície
+//   que seguram o contorno; as pontas em que três ou mais delas se encontram não se movem
+// - colapsos que virariam um triângulo ou deixariam a malha não-variedade são recusados
+// Cada triângulo mantém o seu material (SubMesh). Não usa a OpenGL
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "OBJLoader.h"
+
+// Triângulos de cada nível em relação ao anterior
+const float MESH_LOD_REDUCTION = 0.5f;
+
+// Simplifica a malha (indexada) até targetTriangles triângulos, ou até não haver colapso
+// válido; indices e submeshes recebem o resultado (faixas a partir de 0) e o retorno é o
+// erro estimado relativo ao raio da esfera envolvente
+float simplifyMesh(const MeshData& mesh, size_t targetTriangles, std::vector<unsigned int>& indices, std::vector<SubMesh>& submeshes);
+
+// Gera até levels - 1 níveis simplificados (cada um com MESH_LOD_REDUCTION dos triângulos
+// do anterior; para quando a redução não passa de 80%) e aplica a otimização a todos os
+// níveis. Os índices dos níveis ficam depois dos do nível 0 em mesh.indices, descritos
+// em lods. Com levels <= 1 ou malha não indexada, é o mesmo que optimizeMesh
+void buildMeshLods(MeshData& mesh, int levels, MeshOptimization optimization, std::vector<MeshLod>& lods);
+
+// Nível a desenhar a partir do raio da esfera envolvente na tela (pixels): o mais simples
+// cujo erro (errors[nível] * projectedRadius) fica abaixo de maxErrorPixels. Para passar a
+// um nível mais simples que o atual o erro precisa ficar abaixo por uma margem
+// (hysteresis: 0.25 = 25%), para o objeto não alternar entre dois níveis na divisa
+int selectMeshLod(const float* errors, int count, int current, float projectedRadius, float maxErrorPixels, float hysteresis);
+
+// Gera os níveis de cada .obj e mede o erro de cada um (distância dos vértices da malha
+// completa até a superfície simplificada), conferindo faixas e índices: --check-lods [arquivos .obj]
+bool checkMeshLods(const std::vector<std::string>& files, int levels = MAX_MESH_LODS);
@@ -0,0 +1,98 @@
+// Geração da cadeia de mipmaps na CPU
+// Substitui o glGenerateMipmap, cujo filtro e custo dependem do driver. A média é
+// feita em luz linear (os canais de cor são sRGB; o alfa já é linear), com filtro de
+// caixa 2x2 ou Kaiser (sinc janelado de 8 taps, mais nítido). O filtro é separável:
+// cada linha de saída combina as linhas de origem na vertical e depois reduz na
+// horizontal, então só a imagem do nível seguinte fica inteira na memória.
+// A cadeia gerada é gravada ao lado da imagem ("mercury.jpg.mips") e reaproveitada
+// enquanto a imagem não mudar; o envio à GPU passa a ser uma cópia nível a nível.
+// Com um lado máximo, a imagem maior que ele é reduzida antes (filtro polifásico,
+// proporção mantida) e a cadeia reduzida vai para um arquivo próprio ("mercury.jpg.512.mips")
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Incrementar sempre que o layout do arquivo ou os filtros mudarem
+const uint32_t MIP_CHAIN_VERSION = 1;
+
+enum MipFilter
+{
+	MIP_FILTER_BOX,    // média de 2x2 texels
+	MIP_FILTER_KAISER  // sinc janelado por Kaiser, 8x8 texels
+};
+
+// Conjunto de instruções usado na geração (os três dão o mesmo resultado)
+enum MipSimd
+{
+	MIP_SIMD_SCALAR,
+	MIP_SIMD_SSE2,
+	MIP_SIMD_AVX2
+};
+
+// "box" ou "kaiser" (usado no sceneConfig.json)
+MipFilter mipFilterFromString(const std::string& name);
+const char* mipFilterName(MipFilter filter);
+
+// Melhor conjunto de instruções disponível no processador
+MipSimd bestMipSimd();
+const char* mipSimdName(MipSimd simd);
+
+struct MipLevel
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> data;  // width * height * channels bytes, linhas sem alinhamento
+};
+
+// Cadeia completa, do tamanho original (nível 0) até 1x1
+struct MipChain
+{
+	int channels = 4;  // 3 (RGB) ou 4 (RGBA)
+	MipFilter filter = MIP_FILTER_BOX;
+	uint64_t sourceHash = 0;  // hash e tamanho da imagem de origem (validade do arquivo)
+	uint64_t sourceSize = 0;
+	bool fromCache = false;
+	std::vector<MipLevel> levels;
+
+	size_t totalBytes() const;
+};
+
+// Gera a cadeia a partir de pixels RGB ou RGBA de 8 bits
+void generateMipChain(const unsigned char* pixels, int width, int height, int channels, MipFilter filter, MipChain& chain, MipSimd simd = bestMipSimd());
+
+// Tamanho da imagem reduzida para caber em maxSize x maxSize, mantendo a proporção
+// (o próprio tamanho se já cabe ou se maxSize = 0)
+void fitImageSize(int width, int height, int maxSize, int& fitWidth, int& fitHeight);
+
+// Redimensiona pixels RGB ou RGBA de 8 bits para outWidth x outHeight em luz linear, com
+// o sinc janelado do filtro Kaiser em fases (uma por texel de saída) para qualquer escala
+void resampleImage(const unsigned char* pixels, int width, int height, int channels, int outWidth, int outHeight, std::vector<unsigned char>& out, MipSimd simd = bestMipSimd());
+
+// Caminho do arquivo da cadeia correspondente à imagem ("<imagem>.mips", ou
+// "<imagem>.<maxSize>.mips" para a imagem reduzida)
+std::string mipChainPath(const std::string& imagePath, int maxSize = 0);
+
+// Grava a cadeia (em arquivo temporário próprio de cada chamada + rename, para nunca
+// deixar um arquivo pela metade, mesmo com duas gravações ao mesmo tempo)
+bool saveMipChain(const std::string& path, const MipChain& chain);
+
+// Lê a cadeia da imagem se o arquivo existir, tiver o filtro pedido e tiver sido
+// gerado a partir do conteúdo atual dela
+bool loadMipChain(const std::string& imagePath, MipFilter filter, MipChain& chain, int maxSize = 0);
+
+// Lê a cadeia do arquivo ou decodifica a imagem (reduzida a maxSize, se passar dele),
+// gera a cadeia e grava o arquivo. Não usa a OpenGL: pode rodar em uma thread de trabalho;
+// pedidos simultâneos da mesma imagem, filtro e limite efetivo (ex: amostragens
+// diferentes) geram a cadeia uma vez só e recebem cópias dela
+bool prepareMipChain(const std::string& imagePath, MipFilter filter, MipChain& chain, int maxSize = 0);
+
+// Compara as versões escalar, SSE2 e AVX2 (tempo e diferença máxima) nos dois filtros
+// e o tempo de decodificar + gerar contra o de ler o arquivo .mips
+void benchmarkMipChain(const std::vector<std::string>& files, int repetitions = 5);
+
+// Compara as versões do redimensionamento (tempo e diferença máxima) e a carga da
+// cadeia com e sem o lado máximo (primeira execução e seguintes, bytes)
+void benchmarkResample(const std::vector<std::string>& files, int maxSize, int repetitions = 5);
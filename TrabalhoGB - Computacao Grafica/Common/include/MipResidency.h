@@ -0,0 +1,113 @@
+// Residência dos níveis de mipmap na memória de vídeo (streaming progressivo)
+// Cada textura começa só com os níveis pequenos (lado de até tailSize texels), que
+// ficam sempre residentes. A cada frame os objetos visíveis informam o nível de que
+// precisam, estimado pelo tamanho projetado na tela; o agendador pede os níveis
+// maiores, do mais grosso para o mais fino, enquanto couberem no orçamento, e quando
+// falta espaço descarta os níveis pedidos há mais tempo. Os níveis residentes de uma
+// textura são sempre contíguos (do primeiro residente até o menor), como exige o
+// GL_TEXTURE_BASE_LEVEL. Não usa a OpenGL: o TextureStreamer aplica as decisões e o
+// --check-mip-residency confere o agendamento sem GPU
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+class MipResidency
+{
+public:
+	explicit MipResidency(size_t budgetBytes = 64 * 1024 * 1024, int tailSize = 128);
+
+	// Orçamento de memória de vídeo das texturas registradas (os níveis pequenos entram na conta)
+	void setBudget(size_t bytes) { budgetBytes = bytes; }
+	size_t budget() const { return budgetBytes; }
+
+	// Registra a textura com o tamanho do nível 0 e os bytes de cada nível, do maior para
+	// o menor; os níveis pequenos contam como residentes desde já. Retorna o identificador
+	int addTexture(int width, int height, const std::vector<size_t>& levelBytes);
+
+	// Tira a textura da conta (ex: a textura foi substituída por outra)
+	void removeTexture(int texture);
+
+	// Primeiro nível pequeno (enviado na criação da textura) e primeiro nível residente
+	int tailLevel(int texture) const { return textures[texture].tail; }
+	int firstResident(int texture) const { return textures[texture].first; }
+
+	// Bytes dos níveis residentes da textura (sem a carga em andamento)
+	size_t residentBytes(int texture) const;
+
+	// Nível necessário para a imagem width x height cobrir projectedPixels pixels na tela
+	// (fracionário; 0 = tamanho original). Supõe que a imagem inteira cobre o objeto de
+	// um lado ao outro
+	static float requiredLevel(int width, int height, float projectedPixels);
+
+	// Um objeto visível precisa do nível level (ou de um mais fino) neste frame
+	void require(int texture, float level);
+
+	// Decisões do agendador; os descartes valem imediatamente e as cargas só depois de loaded()
+	enum ActionType
+	{
+		MIP_LOAD,
+		MIP_EVICT
+	};
+
+	struct Action
+	{
+		ActionType type;
+		int texture;
+		int level;
+	};
+
+	// Decide os descartes e as cargas a partir dos pedidos do frame e começa o frame
+	// seguinte. As cargas novas somam até uploadBudget bytes (pelo menos uma, se couber
+	// no orçamento de memória) e cada textura tem no máximo uma carga em andamento
+	void schedule(size_t uploadBudget, std::vector<Action>& actions);
+
+	// A carga do nível terminou: ele passa a ser o primeiro residente
+	void loaded(int texture, int level);
+
+	struct Stats
+	{
+		size_t residentBytes = 0;  // níveis residentes + cargas em andamento
+		size_t budgetBytes = 0;
+		size_t requiredBytes = 0;  // com todos os níveis pedidos no último frame residentes
+		size_t fullBytes = 0;      // com todos os níveis de todas as texturas residentes
+		size_t loads = 0;          // desde o início
+		size_t evictions = 0;
+		int textures = 0;
+		int requested = 0;         // texturas pedidas no último frame
+		int satisfied = 0;         // ... que já tinham o nível pedido residente
+	};
+	Stats stats() const;
+
+	void report(std::ostream& out) const;
+
+private:
+	struct Texture
+	{
+		std::vector<size_t> levelBytes;
+		std::vector<uint64_t> lastNeeded;  // último frame em que cada nível foi pedido
+		int tail = 0;       // primeiro nível pequeno (sempre residente)
+		int first = 0;      // primeiro nível residente
+		int loading = -1;   // nível sendo enviado
+		int wanted = -1;    // nível mais fino pedido no frame (-1: nenhum pedido)
+		int lastWanted = -1;
+	};
+
+	// Descarta o nível residente pedido há mais tempo (entre os pedidos antes do frame
+	// limit); retorna false se nenhum pode ser descartado
+	bool evictOldest(uint64_t limit, std::vector<Action>& actions);
+
+	std::vector<Texture> textures;
+	size_t budgetBytes;
+	int tailSize;
+	size_t resident = 0;
+	uint64_t frame = 1;
+	size_t loadCount = 0;
+	size_t evictionCount = 0;
+};
+
+// Cenários do agendador (sem GPU) usados pelo --check-mip-residency; retorna se todos passaram
+bool checkMipResidency();
@@ -0,0 +1,84 @@
+// Carregador de malhas no formato Wavefront .obj
+// O arquivo é mapeado em memória e tokenizado no lugar, sem alocar strings por
+// linha; os números são convertidos com std::from_chars (independe do locale)
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Floats por vértice no buffer intercalado: posição (3), cor (3), textura (2), normal (3)
+const int OBJ_FLOATS_PER_VERTEX = 11;
+
+// Tamanho mínimo do arquivo para valer a pena o parsing em paralelo
+const size_t OBJ_PARALLEL_MIN_BYTES = 4 * 1024 * 1024;
+
+struct OBJLoadOptions
+{
+	// Deduplica as triplas v/vt/vn em vértices únicos + buffer de índices;
+	// se falso, gera um vértice por canto de face (para glDrawArrays)
+	bool indexed = true;
+
+	// Arquivos grandes são divididos em pedaços e lidos no pool de threads padrão.
+	// O resultado é idêntico ao do parser sequencial
+	bool parallel = true;
+
+	// Parser sequencial em duas passadas: a primeira só conta os registros para
+	// reservar a capacidade exata dos vetores (sem realocações nem a memória
+	// transitória do crescimento por push_back); se falso, lê em uma passada
+	bool countFirst = true;
+
+	// Junta as faces de cada material (usemtl) em um único trecho contínuo, na ordem
+	// do primeiro uso; se falso, as faces ficam na ordem do arquivo
+	bool groupByMaterial = true;
+};
+
+// Trecho da malha desenhado com um material: faixa de índices (ou de vértices,
+// se a malha não é indexada)
+struct SubMesh
+{
+	std::string material;    // nome do usemtl (vazio para faces antes do primeiro usemtl)
+	unsigned int first = 0;
+	unsigned int count = 0;
+
+	bool operator==(const SubMesh& other) const { return material == other.material && first == other.first && count == other.count; }
+};
+
+struct MeshData
+{
+	std::vector<float> vertices;        // OBJ_FLOATS_PER_VERTEX floats por vértice
+	std::vector<unsigned int> indices;  // vazio quando a malha não é indexada
+	std::vector<SubMesh> submeshes;     // cobrem todos os elementos, sem sobreposição
+
+	size_t vertexCount() const { return vertices.size() / OBJ_FLOATS_PER_VERTEX; }
+};
+
+// Lê o .obj e gera a malha (indexada ou não, conforme as opções)
+bool loadOBJMesh(const std::string& filePath, MeshData& mesh, const OBJLoadOptions& options = OBJLoadOptions());
+
+// Mesmo parsing, sobre um bloco de memória já carregado
+bool parseOBJMesh(const char* begin, const char* end, MeshData& mesh, const OBJLoadOptions& options, const std::string& sourceName);
+
+// Parsing em paralelo: pedaços alinhados em fim de linha são lidos no pool e
+// juntados em ordem por soma de prefixos (índices relativos resolvidos no fim)
+bool parseOBJMeshParallel(const char* begin, const char* end, MeshData& mesh, const OBJLoadOptions& options, const std::string& sourceName, ThreadPool& pool);
+
+// Lê o .obj e gera o buffer intercalado, um vértice por canto de face, na ordem do arquivo
+bool loadOBJBuffer(const std::string& filePath, std::vector<float>& vBuffer);
+
+// Implementação original (getline + istringstream + stoi), mantida como referência
+bool loadOBJBufferStream(const std::string& filePath, std::vector<float>& vBuffer);
+
+// Compara a vazão (MB/s) dos dois carregadores e confere se geram o mesmo buffer
+void benchmarkOBJLoaders(const std::vector<std::string>& files, int repetitions = 20);
+
+// Pico de memória e tempo do parser sequencial com e sem a passada de contagem,
+// sobre uma versão ampliada do .obj
+void benchmarkOBJMemory(const std::string& sourcePath, int copies);
+
+// Escalabilidade do parsing paralelo de 1 a N threads, sobre uma versão ampliada
+// do .obj (copies cópias, metade delas com índices negativos)
+void benchmarkOBJParallel(const std::string& sourcePath, int copies, unsigned int maxThreads);
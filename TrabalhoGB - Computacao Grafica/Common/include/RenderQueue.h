@@ -0,0 +1,54 @@
+// Fila de desenho ordenada por chave
+// Cada desenho recebe uma chave de 64 bits com os campos que mais custam trocar nos bits
+// mais altos: passo, programa, textura (ou material), malha e, por último, a profundidade
+// quantizada, da frente para trás (menos sobreposição de fragmentos dentro de um mesmo
+// estado). As chaves são ordenadas com radix sort LSD de 8 bits por passada, estável e
+// linear na quantidade de desenhos; as passadas em que todas as chaves têm o mesmo byte
+// são puladas. Não usa a OpenGL: o GLStateCache filtra as trocas ao enviar a fila
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Larguras dos campos da chave, do mais alto para o mais baixo (somam 64 bits)
+const int DRAW_KEY_PASS_BITS = 4;
+const int DRAW_KEY_PROGRAM_BITS = 8;
+const int DRAW_KEY_MATERIAL_BITS = 16;
+const int DRAW_KEY_MESH_BITS = 16;
+const int DRAW_KEY_DEPTH_BITS = 20;
+
+// Monta a chave; os campos são truncados à sua largura e a profundidade é quantizada em
+// [0, farDepth] (fora do intervalo fica no limite mais próximo)
+uint64_t makeDrawKey(unsigned pass, unsigned program, unsigned material, unsigned mesh, float depth, float farDepth);
+
+class RenderQueue
+{
+public:
+	struct Item
+	{
+		uint64_t key;
+		int index;  // desenho (ex: índice do objeto)
+	};
+
+	void clear() { queue.clear(); }
+	void push(uint64_t key, int index) { queue.push_back({ key, index }); }
+
+	// Ordena por chave (radix sort); desenhos de mesma chave mantêm a ordem de entrada
+	void sort();
+
+	const std::vector<Item>& items() const { return queue; }
+	size_t size() const { return queue.size(); }
+
+	// Radix sort LSD usado pelo sort(); scratch é redimensionado conforme a necessidade
+	static void radixSort(std::vector<Item>& items, std::vector<Item>& scratch);
+
+private:
+	std::vector<Item> queue;
+	std::vector<Item> scratch;
+};
+
+// Radix sort contra std::sort e std::stable_sort em draws desenhos com chaves de cena
+// (poucas texturas e malhas, profundidades variadas) e totalmente aleatórias: --bench-render-queue
+void benchmarkRenderQueue(size_t draws, int repetitions = 20);
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 //GLAD
 #include <glad/glad.h>
@@ -16,6 +17,38 @@
 
 using namespace std;
 
+// Uniforms resolvidos uma vez (Shader::uniform); o set() é só a chamada glUniform*.
+// Um uniform ausente fica com location -1, que a OpenGL ignora
+struct UniformInt
+{
+	GLint location = -1;
+	static bool accepts(GLenum type);  // int, bool e samplers
+	void set(int value) const { glUniform1i(location, value); }
+	void set(const GLint* values, GLsizei count) const { glUniform1iv(location, count, values); }
+};
+
+struct UniformFloat
+{
+	GLint location = -1;
+	static bool accepts(GLenum type) { return type == GL_FLOAT; }
+	void set(float value) const { glUniform1f(location, value); }
+};
+
+struct UniformVec3
+{
+	GLint location = -1;
+	static bool accepts(GLenum type) { return type == GL_FLOAT_VEC3; }
+	void set(float v1, float v2, float v3) const { glUniform3f(location, v1, v2, v3); }
+	void set(const float* v) const { glUniform3fv(location, 1, v); }
+};
+
+struct UniformMat4
+{
+	GLint location = -1;
+	static bool accepts(GLenum type) { return type == GL_FLOAT_MAT4; }
+	void set(const float* v) const { glUniformMatrix4fv(location, 1, GL_FALSE, v); }
+};
+
 class Shader
 {
 public:
@@ -95,6 +128,7 @@ public:
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
 
+		loadUniforms();
 	}
 	// Uses the current shader
 	void Use()
@@ -102,40 +136,80 @@ public:
 		glUseProgram(this->ID);
 	}
 
+	// Location do uniform ativo (-1 se o programa não usa o nome); arrays pelo nome sem o [0]
+	GLint location(const std::string& name) const;
+
+	// Handle do uniform para os caminhos quentes: confere o tipo declarado no shader e
+	// avisa se o uniform não existe ou tem outro tipo (o handle fica com location -1)
+	template <typename Handle>
+	Handle uniform(const std::string& name) const
+	{
+		Handle handle;
+		const ActiveUniform* found = find(name);
+		if (found == nullptr)
+			std::cout << "Uniform " << name << " nao esta ativo no programa " << this->ID << std::endl;
+		else if (!Handle::accepts(found->type))
+			std::cout << "Uniform " << name << " tem outro tipo no programa " << this->ID << std::endl;
+		else
+			handle.location = found->location;
+		return handle;
+	}
+
+	// Os set* por nome consultam a tabela de uniforms; ficam para os usos fora do frame
+
 	void setBool(const std::string& name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), (int)value);
+		glUniform1i(location(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1i(location(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(this->ID, name.c_str()), value);
+		glUniform1f(location(name), value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string& name, float v1, float v2) const
 	{
-		glUniform2f(glGetUniformLocation(this->ID, name.c_str()), v1, v2);
+		glUniform2f(location(name), v1, v2);
 	}
 
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string& name, float v1, float v2, float v3) const
 	{
-		glUniform3f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3);
+		glUniform3f(location(name), v1, v2, v3);
 	}
 
 	void setVec4(const std::string& name, float v1, float v2, float v3, float v4) const
 	{
-		glUniform4f(glGetUniformLocation(this->ID, name.c_str()), v1, v2, v3,v4);
+		glUniform4f(location(name), v1, v2, v3,v4);
 	}
 
 	void setMat4(const std::string& name, float *v) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(this->ID, name.c_str()), 1, GL_FALSE, v);
+		glUniformMatrix4fv(location(name), 1, GL_FALSE, v);
 	}
+
+	// Quantidade de uniforms ativos do programa
+	size_t uniformCount() const { return uniforms.size(); }
+
+private:
+	struct ActiveUniform
+	{
+		std::string name;
+		GLint location;
+		GLenum type;
+		GLint size;  // elementos, se for array
+	};
+
+	// Lê os uniforms ativos do programa ligado (GL_ACTIVE_UNIFORMS) para a tabela
+	void loadUniforms();
+
+	const ActiveUniform* find(const std::string& name) const;
+
+	std::vector<ActiveUniform> uniforms;  // ordenada por nome
 };
 
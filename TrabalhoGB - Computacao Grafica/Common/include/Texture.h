@@ -0,0 +1,162 @@
+// Texturas: decodificação das imagens (stb_image) e cache de texturas na GPU
+// O cache identifica cada textura pelo caminho canônico do arquivo mais os
+// parâmetros de amostragem, então objetos que usam a mesma imagem compartilham
+// uma única textura; cada aquisição conta uma referência e a textura é apagada
+// quando a última é liberada
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "MipChain.h"
+
+// Imagem decodificada na memória, ainda não enviada à GPU
+struct DecodedImage
+{
+	unsigned char* data = nullptr;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+};
+
+// Decodifica o arquivo (jpg, png, bmp...); pode rodar fora da thread do contexto OpenGL.
+// desiredChannels = 0 mantém os canais do arquivo; 4 converte para RGBA
+bool decodeImage(const std::string& filePath, DecodedImage& image, int desiredChannels = 0);
+
+// Libera os pixels da imagem decodificada
+void freeImage(DecodedImage& image);
+
+// Largura e altura da imagem lidas só do cabeçalho do arquivo (sem decodificar)
+bool readImageSize(const std::string& filePath, int& width, int& height);
+
+// Reduz a imagem (resampleImage) se algum lado passa de maxSize; retorna se reduziu
+bool limitImageSize(DecodedImage& image, int maxSize);
+
+struct CompressedImage;
+
+// Parâmetros de amostragem da textura (fazem parte da chave do cache)
+struct SamplerSettings
+{
+	GLint wrapS = GL_REPEAT;
+	GLint wrapT = GL_REPEAT;
+	GLint minFilter = GL_LINEAR;
+	GLint magFilter = GL_LINEAR;
+	bool mipmaps = true;
+	int maxSize = 0;  // lado máximo da imagem na GPU (0: tamanho original)
+
+	bool operator==(const SamplerSettings& other) const
+	{
+		return wrapS == other.wrapS && wrapT == other.wrapT && minFilter == other.minFilter
+			&& magFilter == other.magFilter && mipmaps == other.mipmaps && maxSize == other.maxSize;
+	}
+};
+
+// "repeat", "clamp" ou "mirror" (usado no sceneConfig.json)
+GLint textureWrapFromString(const std::string& name);
+
+// "linear", "nearest" ou "trilinear" (usado no sceneConfig.json)
+void applyTextureFilter(const std::string& name, SamplerSettings& sampler);
+
+// Cria a textura a partir da imagem decodificada e libera os pixels; 0 se a imagem é inválida
+GLuint createTexture(const std::string& filePath, DecodedImage& image, const SamplerSettings& sampler = SamplerSettings());
+
+// Cria a textura com os níveis da cadeia gerada na CPU (sem glGenerateMipmap) e
+// libera os dados da cadeia; 0 se a cadeia está vazia
+GLuint createTexture(const std::string& filePath, MipChain& chain, const SamplerSettings& sampler = SamplerSettings());
+
+// Bytes ocupados na GPU pela imagem (com a cadeia de mipmaps, se houver)
+size_t textureBytes(int width, int height, bool mipmaps);
+
+class TextureCache
+{
+public:
+	TextureCache() {}
+	~TextureCache();
+
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	// Chave do cache: caminho canônico + parâmetros de amostragem
+	static std::string key(const std::string& filePath, const SamplerSettings& sampler);
+
+	// Se a textura já está no cache (para não decodificar a imagem de novo)
+	bool contains(const std::string& filePath, const SamplerSettings& sampler) const;
+
+	// Retorna a textura do arquivo, decodificando e enviando só na primeira vez,
+	// e conta uma referência; 0 se o arquivo não pôde ser lido
+	GLuint acquire(const std::string& filePath, const SamplerSettings& sampler = SamplerSettings());
+
+	// Igual, com a imagem já decodificada (ex: em outra thread); os pixels são
+	// liberados mesmo quando a textura já estava no cache
+	GLuint acquire(const std::string& filePath, const SamplerSettings& sampler, DecodedImage& image);
+
+	// Igual, com a imagem comprimida lida do KTX2; os blocos são liberados mesmo
+	// quando a textura já estava no cache
+	GLuint acquire(const std::string& filePath, const SamplerSettings& sampler, CompressedImage& image);
+
+	// Igual, com a cadeia de mipmaps gerada na CPU; os níveis são liberados mesmo
+	// quando a textura já estava no cache
+	GLuint acquire(const std::string& filePath, const SamplerSettings& sampler, MipChain& chain);
+
+	// Se acquire(filePath) usa o KTX2 ao lado da imagem quando ele está atualizado (padrão: sim)
+	void setUseCompressed(bool use) { useCompressed = use; }
+	bool usesCompressed() const { return useCompressed; }
+
+	// Se os mipmaps das imagens não comprimidas são gerados na CPU (e guardados no
+	// arquivo .mips) em vez do glGenerateMipmap, e com qual filtro (padrão: sim, caixa)
+	void setCpuMipmaps(bool cpu, MipFilter filter) { cpuMipmaps = cpu; mipmapFilter = filter; }
+	bool usesCpuMipmaps() const { return cpuMipmaps; }
+	MipFilter mipFilter() const { return mipmapFilter; }
+
+	// Registra uma textura criada fora do cache (ex: enviada aos poucos pelo
+	// TextureStreamer) com references referências. Se a chave já estiver no cache, a
+	// textura nova é apagada e as referências vão para a existente; retorna a que ficou
+	GLuint adopt(const std::string& filePath, const SamplerSettings& sampler, GLuint texture, size_t size, int references, bool compressed);
+
+	// Atualiza os bytes de uma textura do cache (ex: níveis de mipmap enviados ou descartados)
+	void resize(GLuint texture, size_t size);
+
+	// Conta mais uma referência a uma textura do cache
+	void addReference(GLuint texture);
+
+	// Libera uma referência; a textura é apagada quando não restam referências
+	void release(GLuint texture);
+
+	// Apaga todas as texturas (ex: no encerramento, com o contexto ainda ativo)
+	void clear();
+
+	size_t textureCount() const { return entries.size(); }
+	size_t residentBytes() const { return bytes; }
+
+	// Quantas texturas foram criadas e quantas aquisições foram atendidas pelo cache
+	size_t uploads() const { return uploadCount; }
+	size_t hits() const { return hitCount; }
+
+	void report(std::ostream& out) const;
+
+private:
+	struct Entry
+	{
+		std::string key;
+		size_t bytes = 0;
+		int references = 0;
+	};
+
+	GLuint find(const std::string& key);
+	void insert(const std::string& key, GLuint texture, size_t size);
+
+	std::unordered_map<std::string, GLuint> textureOfKey;
+	std::unordered_map<GLuint, Entry> entries;
+	size_t bytes = 0;
+	size_t uploadCount = 0;
+	size_t hitCount = 0;
+	size_t compressedCount = 0;
+	bool useCompressed = true;
+	bool cpuMipmaps = true;
+	MipFilter mipmapFilter = MIP_FILTER_BOX;
+};
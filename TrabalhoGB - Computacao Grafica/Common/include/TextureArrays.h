@@ -0,0 +1,106 @@
+// Arrays de texturas (GL_TEXTURE_2D_ARRAY) montados na carga da cena
+// As imagens de mesmo tamanho, formato e amostragem viram camadas de um único array.
+// Os arrays ficam ligados em unidades fixas durante o frame inteiro e cada objeto
+// escolhe array e camada por uniform, então não há troca de textura entre os desenhos
+// (o que permite, depois, juntar vários objetos em um único desenho).
+// Imagens maiores que o tamanho máximo são reduzidas descartando os primeiros níveis
+// da cadeia de mipmaps, o que aproxima tamanhos diferentes (2048x2048 e 1024x1024
+// ficam no mesmo array com limite 1024); só a proporção não muda
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "CompressedTexture.h"
+#include "MipChain.h"
+#include "Texture.h"
+
+// Quantidade de arrays que o phong.fs aceita (uniform sampler2DArray textureArrays[8])
+const int MAX_TEXTURE_ARRAYS = 8;
+
+class TextureArrays
+{
+public:
+	TextureArrays() {}
+	~TextureArrays();
+
+	TextureArrays(const TextureArrays&) = delete;
+	TextureArrays& operator=(const TextureArrays&) = delete;
+
+	// Reduz as imagens até caberem em maxSize x maxSize (0: sem limite)
+	void setMaxSize(int size) { maxSize = size; }
+
+	// Adiciona a imagem (cadeia gerada na CPU ou KTX2); os dados passam para o
+	// empacotador. A mesma imagem e amostragem adicionada de novo só conta mais uma
+	// referência; retorna o identificador da imagem
+	int add(const std::string& filePath, const SamplerSettings& sampler, MipChain& chain);
+	int add(const std::string& filePath, const SamplerSettings& sampler, CompressedImage& image);
+
+	// Agrupa as imagens, cria até maxArrays arrays (os grupos com mais camadas primeiro)
+	// e envia as camadas. Os grupos que sobram viram texturas comuns no cache, com uma
+	// referência por add
+	void build(int maxArrays, TextureCache& cache);
+
+	// Onde a imagem ficou: array e camada, ou a textura comum (array -1)
+	struct Placement
+	{
+		int array = -1;
+		int layer = 0;
+		GLuint texture = 0;
+	};
+	const Placement& placement(int id) const { return entries[id].placement; }
+
+	// Liga os arrays nas unidades firstUnit, firstUnit + 1, ...
+	void bind(GLenum firstUnit) const;
+
+	size_t arrayCount() const { return arrays.size(); }
+	size_t residentBytes() const;
+
+	// Apaga os arrays (com o contexto ainda ativo)
+	void clear();
+
+	void report(std::ostream& out) const;
+
+private:
+	struct Entry
+	{
+		std::string filePath;
+		SamplerSettings sampler;
+		int references = 1;
+		bool compressed = false;
+		MipChain chain;
+		CompressedImage image;
+		int firstLevel = 0;  // primeiro nível usado (maior que 0 quando a imagem é reduzida)
+		Placement placement;
+	};
+
+	struct Array
+	{
+		GLuint texture = 0;
+		int width = 0;
+		int height = 0;
+		int levels = 0;
+		int layers = 0;
+		size_t bytes = 0;
+		bool compressed = false;
+	};
+
+	int addEntry(const std::string& filePath, const SamplerSettings& sampler, bool& added);
+
+	// Escolhe o primeiro nível (redução) e devolve a chave do grupo: formato, tamanho
+	// e níveis depois da redução, e amostragem
+	std::string groupKey(Entry& entry);
+
+	void upload(Array& array, const std::vector<int>& members);
+
+	int maxSize = 0;
+	std::vector<Entry> entries;
+	std::unordered_map<std::string, int> entryOfKey;
+	std::vector<Array> arrays;
+};
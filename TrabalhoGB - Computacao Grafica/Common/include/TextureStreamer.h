@@ -0,0 +1,151 @@
+// Carregamento assíncrono de texturas
+// A decodificação (ou a leitura do KTX2) roda nas threads de trabalho; a thread do
+// contexto OpenGL envia os texels aos poucos, a cada frame, através de um anel de
+// pixel buffer objects (PBO): os dados são copiados para um PBO livre e o
+// glTexSubImage2D lê do PBO, sem bloquear enquanto a GPU faz a cópia. Um fence por
+// PBO indica quando ele pode ser reaproveitado. As imagens não comprimidas chegam com
+// a cadeia de mipmaps gerada na CPU (arquivo .mips), se o cache assim estiver configurado.
+// Enquanto a textura não está
+// completa, os objetos usam uma textura de 1x1 branca.
+// Com o streaming de mipmaps, as texturas com cadeia completa (KTX2 ou .mips) ficam
+// prontas só com os níveis pequenos; os maiores chegam pelos mesmos PBOs quando algum
+// objeto precisa deles e saem quando falta espaço no orçamento (MipResidency). A cópia
+// da cadeia na memória principal fica com o streamer, de onde os níveis são reenviados
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//GLAD
+#include <glad/glad.h>
+
+#include "CompressedTexture.h"
+#include "MipResidency.h"
+#include "Texture.h"
+
+class TextureStreamer
+{
+public:
+	// ringSize PBOs de slotBytes bytes cada
+	explicit TextureStreamer(size_t ringSize = 4, size_t slotBytes = 1024 * 1024);
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// Cria os PBOs e a textura provisória (precisa do contexto OpenGL)
+	void initialize();
+
+	// Libera os PBOs, a textura provisória e as texturas ainda incompletas
+	void shutdown();
+
+	// Textura de 1x1 branca usada até a textura pedida ficar pronta
+	GLuint placeholder() const { return placeholderTexture; }
+
+	// Liga o streaming de mipmaps com budgetBytes de memória de vídeo para as texturas
+	// gerenciadas; vale para os pedidos feitos depois
+	void setMipStreaming(bool enabled, size_t budgetBytes);
+	bool streamsMips() const { return mipStreaming; }
+
+	// Pede a textura; a decodificação começa imediatamente em uma thread de trabalho,
+	// com as opções do cache (KTX2, mipmaps na CPU). Pedidos repetidos (mesmo arquivo e
+	// parâmetros) recebem o mesmo identificador
+	int request(const std::string& filePath, const SamplerSettings& sampler, const TextureCache& cache);
+
+	// Envia até byteBudget bytes de texels neste frame; as texturas que ficaram completas
+	// são registradas no cache (com uma referência por pedido) e entram em completed
+	struct Completed
+	{
+		int request;
+		GLuint texture;  // 0 se a imagem não pôde ser lida
+	};
+	void update(size_t byteBudget, TextureCache& cache, std::vector<Completed>& completed);
+
+	// O objeto que usa a textura do pedido ocupa projectedPixels pixels na tela neste frame
+	// (chamado entre um update e outro; sem efeito se a textura não é gerenciada)
+	void require(int request, float projectedPixels);
+
+	// Níveis residentes das texturas gerenciadas contra o orçamento
+	const MipResidency& residency() const { return mips; }
+
+	// Pedidos ainda não concluídos
+	size_t pendingCount() const { return pending; }
+
+	// Bytes enviados pelos PBOs desde o início
+	size_t uploadedBytes() const { return uploaded; }
+
+private:
+	enum JobState
+	{
+		JOB_DECODING,
+		JOB_UPLOADING,
+		JOB_DONE,
+		JOB_RESIDENT  // pronta, com os níveis gerenciados pelo MipResidency
+	};
+
+	struct Job
+	{
+		std::string filePath;
+		SamplerSettings sampler;
+		int references = 0;
+		JobState state = JOB_DECODING;
+		std::future<bool> decoded;
+		DecodedImage image;
+		CompressedImage compressed;
+		MipChain chain;      // níveis gerados na CPU (vazia: só o nível 0, da imagem)
+		bool isCompressed = false;
+		GLuint texture = 0;
+		size_t textureBytes = 0;
+		int level = 0;   // nível sendo enviado
+		int row = 0;     // próxima linha (ou linha de blocos, se comprimida)
+		int residency = -1;      // textura no MipResidency (-1: todos os níveis enviados de uma vez)
+		int loadingLevel = -1;   // nível maior sendo enviado depois de pronta
+	};
+
+	struct Slot
+	{
+		GLuint buffer = 0;
+		GLsync fence = 0;
+	};
+
+	// Aloca a textura (sem dados) quando a decodificação termina
+	void beginUpload(Job& job);
+
+	// Níveis a enviar (1 se os mipmaps ficam para o glGenerateMipmap)
+	static size_t levelCount(const Job& job);
+
+	// Envia a próxima faixa de linhas pelo próximo PBO livre; retorna os bytes enviados
+	// (zero se nenhum PBO está livre)
+	size_t uploadSlice(Job& job, size_t byteBudget);
+
+	void finish(Job& job, TextureCache& cache, std::vector<Completed>& completed, int id);
+
+	// Largura e altura do nível da cadeia (KTX2 ou .mips)
+	void levelSize(const Job& job, int level, int& width, int& height) const;
+
+	// Aplica as decisões do MipResidency e continua os envios dos níveis maiores
+	size_t updateResidency(size_t byteBudget, TextureCache& cache);
+
+	// Aloca (data nulo) ou libera (0x0) o nível da textura vinculada
+	void specifyLevel(const Job& job, int level, bool allocate);
+
+	size_t ringSize;
+	size_t slotBytes;
+	std::vector<Slot> ring;
+	size_t nextSlot = 0;
+	GLuint placeholderTexture = 0;
+
+	bool mipStreaming = false;
+	MipResidency mips;
+	std::vector<Job*> jobOfResidency;  // pedido de cada textura do MipResidency
+	std::vector<MipResidency::Action> actions;
+
+	std::vector<std::unique_ptr<Job>> jobs;
+	std::unordered_map<std::string, int> jobOfKey;
+	size_t pending = 0;
+	size_t uploaded = 0;
+};
@@ -0,0 +1,153 @@
+// Pool de threads simples: fila de tarefas + parallelFor
+// A thread que chama parallelFor também executa iterações, então chamadas
+// aninhadas (de dentro de uma tarefa do pool) não travam mesmo com o pool ocupado
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// threadCount = número de threads de trabalho (pode ser zero: tudo roda na thread chamadora)
+	explicit ThreadPool(unsigned int threadCount)
+	{
+		for (unsigned int i = 0; i < threadCount; i++)
+			workers.emplace_back([this] { workerLoop(); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		condition.notify_all();
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Threads de trabalho sugeridas: uma por núcleo, menos a thread principal
+	static unsigned int defaultThreadCount()
+	{
+		unsigned int hardware = std::thread::hardware_concurrency();
+		return hardware > 1 ? hardware - 1 : 0;
+	}
+
+	unsigned int size() const { return (unsigned int)workers.size(); }
+
+	// Enfileira uma tarefa; o resultado (ou o fim da execução) é obtido pelo future
+	template <typename F>
+	std::future<std::invoke_result_t<F>> submit(F func)
+	{
+		typedef std::invoke_result_t<F> Result;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+		std::future<Result> result = task->get_future();
+		if (workers.empty())
+		{
+			(*task)();
+			return result;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back([task] { (*task)(); });
+		}
+		condition.notify_one();
+		return result;
+	}
+
+	// Executa func(i) para i em [0, count) e espera todas as iterações terminarem
+	void parallelFor(size_t count, const std::function<void(size_t)>& func)
+	{
+		if (count == 0)
+			return;
+
+		struct State
+		{
+			std::atomic<size_t> next{ 0 };
+			std::atomic<size_t> done{ 0 };
+			size_t count = 0;
+			std::function<void(size_t)> func;
+			std::mutex mutex;
+			std::condition_variable finished;
+		};
+
+		std::shared_ptr<State> state = std::make_shared<State>();
+		state->count = count;
+		state->func = func;
+
+		auto work = [state]()
+		{
+			size_t i;
+			while ((i = state->next++) < state->count)
+			{
+				state->func(i);
+				if (++state->done == state->count)
+				{
+					std::lock_guard<std::mutex> lock(state->mutex);
+					state->finished.notify_all();
+				}
+			}
+		};
+
+		size_t helpers = std::min(count - 1, workers.size());
+		if (helpers > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (size_t i = 0; i < helpers; i++)
+					tasks.push_back(work);
+			}
+			condition.notify_all();
+		}
+
+		work();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait(lock, [&state] { return state->done == state->count; });
+	}
+
+private:
+	void workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (stopping && tasks.empty())
+					return;
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping = false;
+};
+
+// Pool compartilhado pela aplicação (criado no primeiro uso)
+inline ThreadPool& defaultThreadPool()
+{
+	static ThreadPool pool(ThreadPool::defaultThreadCount());
+	return pool;
+}
@@ -0,0 +1,822 @@
+#include "CompressedTexture.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+	// ---- Cor (bloco BC1) ----
+
+	inline uint16_t packRGB565(const float color[3])
+	{
+		int r = (int)(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		int g = (int)(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+		int b = (int)(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		return (uint16_t)((r << 11) | (g << 5) | b);
+	}
+
+	inline void unpackRGB565(uint16_t packed, int color[3])
+	{
+		int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	// Paleta do bloco: no modo de 4 cores (color0 > color1, ou sempre no BC3) as duas
+	// cores intermediárias ficam a 1/3 e 2/3; no modo de 3 cores, a intermediária fica
+	// no meio e o índice 3 é preto transparente
+	void colorPalette(uint16_t color0, uint16_t color1, bool fourColors, int palette[4][4])
+	{
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			if (fourColors)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = fourColors ? 255 : 0;
+	}
+
+	inline int colorDistance(const unsigned char* texel, const int color[4])
+	{
+		int dr = texel[0] - color[0], dg = texel[1] - color[1], db = texel[2] - color[2];
+		return dr * dr + dg * dg + db * db;
+	}
+
+	// Ordena as extremidades para o modo de 4 cores e escolhe o índice mais próximo de
+	// cada texel; retorna o erro quadrático total
+	int selectColorIndices(const unsigned char* rgba, uint16_t& color0, uint16_t& color1, uint32_t& indices)
+	{
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		int palette[4][4];
+		colorPalette(color0, color1, true, palette);
+
+		// Extremidades iguais caem no modo de 3 cores, em que o índice 3 é transparente
+		int usable = color0 == color1 ? 1 : 4;
+		indices = 0;
+		int error = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0, bestDistance = colorDistance(&rgba[i * 4], palette[0]);
+			for (int p = 1; p < usable; p++)
+			{
+				int distance = colorDistance(&rgba[i * 4], palette[p]);
+				if (distance < bestDistance)
+				{
+					best = p;
+					bestDistance = distance;
+				}
+			}
+			indices |= (uint32_t)best << (2 * i);
+			error += bestDistance;
+		}
+		return error;
+	}
+
+	// Mínimos quadrados: as extremidades que melhor reproduzem os texels com os índices atuais
+	bool refineEndpoints(const unsigned char* rgba, uint32_t indices, float endpoint0[3], float endpoint1[3])
+	{
+		static const float weightOfColor0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			float a = weightOfColor0[(indices >> (2 * i)) & 3];
+			float b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += a * rgba[i * 4 + c];
+				bx[c] += b * rgba[i * 4 + c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (fabs(determinant) < 1e-6f)
+			return false;
+
+		for (int c = 0; c < 3; c++)
+		{
+			endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+			endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+		}
+		return true;
+	}
+
+	inline void writeColorBlock(unsigned char* block, uint16_t color0, uint16_t color1, uint32_t indices)
+	{
+		block[0] = (unsigned char)(color0 & 0xFF);
+		block[1] = (unsigned char)(color0 >> 8);
+		block[2] = (unsigned char)(color1 & 0xFF);
+		block[3] = (unsigned char)(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+			block[4 + i] = (unsigned char)(indices >> (8 * i));
+	}
+
+	// Extremidades no eixo principal das cores (covariância + iteração de potência),
+	// recuadas 1/16 para dentro, seguidas de refinamento por mínimos quadrados
+	void encodeColorBlock(const unsigned char* rgba, unsigned char* block)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 3; c++)
+				mean[c] += rgba[i * 4 + c];
+		for (int c = 0; c < 3; c++)
+			mean[c] /= 16.0f;
+
+		float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };  // xx xy xz yy yz zz
+		for (int i = 0; i < 16; i++)
+		{
+			float dx = rgba[i * 4 + 0] - mean[0], dy = rgba[i * 4 + 1] - mean[1], dz = rgba[i * 4 + 2] - mean[2];
+			covariance[0] += dx * dx;
+			covariance[1] += dx * dy;
+			covariance[2] += dx * dz;
+			covariance[3] += dy * dy;
+			covariance[4] += dy * dz;
+			covariance[5] += dz * dz;
+		}
+
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			float largest = std::max(fabs(x), std::max(fabs(y), fabs(z)));
+			if (largest < 1e-6f)
+				break;
+			axis[0] = x / largest;
+			axis[1] = y / largest;
+			axis[2] = z / largest;
+		}
+
+		float minT = 0.0f, maxT = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = (rgba[i * 4 + 0] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		float endpoint0[3], endpoint1[3];
+		float lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		for (int c = 0; c < 3; c++)
+		{
+			endpoint0[c] = mean[c] + axis[c] * maxT / lengthSquared;
+			endpoint1[c] = mean[c] + axis[c] * minT / lengthSquared;
+			float inset = (endpoint0[c] - endpoint1[c]) / 16.0f;
+			endpoint0[c] -= inset;
+			endpoint1[c] += inset;
+		}
+
+		uint16_t color0 = packRGB565(endpoint0), color1 = packRGB565(endpoint1);
+		uint32_t indices;
+		int error = selectColorIndices(rgba, color0, color1, indices);
+
+		for (int iteration = 0; iteration < 2 && error > 0; iteration++)
+		{
+			if (!refineEndpoints(rgba, indices, endpoint0, endpoint1))
+				break;
+			uint16_t refined0 = packRGB565(endpoint0), refined1 = packRGB565(endpoint1);
+			uint32_t refinedIndices;
+			int refinedError = selectColorIndices(rgba, refined0, refined1, refinedIndices);
+			if (refinedError >= error)
+				break;
+			color0 = refined0;
+			color1 = refined1;
+			indices = refinedIndices;
+			error = refinedError;
+		}
+
+		writeColorBlock(block, color0, color1, indices);
+	}
+
+	void decodeColorBlock(const unsigned char* block, unsigned char* rgba, bool alwaysFourColors)
+	{
+		uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+		uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+		uint32_t indices = (uint32_t)block[4] | ((uint32_t)block[5] << 8) | ((uint32_t)block[6] << 16) | ((uint32_t)block[7] << 24);
+
+		int palette[4][4];
+		colorPalette(color0, color1, alwaysFourColors || color0 > color1, palette);
+		for (int i = 0; i < 16; i++)
+		{
+			const int* color = palette[(indices >> (2 * i)) & 3];
+			for (int c = 0; c < 4; c++)
+				rgba[i * 4 + c] = (unsigned char)color[c];
+		}
+	}
+
+	// ---- Alfa (primeira metade do bloco BC3) ----
+
+	// Modo de 8 valores (alpha0 > alpha1) ou de 6 valores + 0 e 255
+	void alphaPalette(int alpha0, int alpha1, int palette[8])
+	{
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		if (alpha0 > alpha1)
+		{
+			for (int i = 2; i < 8; i++)
+				palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1) / 7;
+		}
+		else
+		{
+			for (int i = 2; i < 6; i++)
+				palette[i] = ((6 - i) * alpha0 + (i - 1) * alpha1) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	void encodeAlphaBlock(const unsigned char* rgba, unsigned char* block)
+	{
+		int minAlpha = 255, maxAlpha = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			minAlpha = std::min(minAlpha, (int)rgba[i * 4 + 3]);
+			maxAlpha = std::max(maxAlpha, (int)rgba[i * 4 + 3]);
+		}
+
+		int palette[8];
+		alphaPalette(maxAlpha, minAlpha, palette);
+
+		uint64_t indices = 0;
+		for (int i = 0; i < 16 && maxAlpha > minAlpha; i++)
+		{
+			int alpha = rgba[i * 4 + 3];
+			int best = 0;
+			for (int p = 1; p < 8; p++)
+			{
+				if (abs(palette[p] - alpha) < abs(palette[best] - alpha))
+					best = p;
+			}
+			indices |= (uint64_t)best << (3 * i);
+		}
+
+		block[0] = (unsigned char)maxAlpha;
+		block[1] = (unsigned char)minAlpha;
+		for (int i = 0; i < 6; i++)
+			block[2 + i] = (unsigned char)(indices >> (8 * i));
+	}
+
+	void decodeAlphaBlock(const unsigned char* block, unsigned char* rgba)
+	{
+		int palette[8];
+		alphaPalette(block[0], block[1], palette);
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++)
+			indices |= (uint64_t)block[2 + i] << (8 * i);
+		for (int i = 0; i < 16; i++)
+			rgba[i * 4 + 3] = (unsigned char)palette[(indices >> (3 * i)) & 7];
+	}
+
+	// Copia o bloco de 4x4 que começa em (x, y); fora da imagem repete a borda
+	void gatherBlock(const unsigned char* rgba, int width, int height, int x, int y, unsigned char* block)
+	{
+		for (int by = 0; by < 4; by++)
+		{
+			int sy = std::min(y + by, height - 1);
+			for (int bx = 0; bx < 4; bx++)
+			{
+				int sx = std::min(x + bx, width - 1);
+				memcpy(&block[(by * 4 + bx) * 4], &rgba[((size_t)sy * width + sx) * 4], 4);
+			}
+		}
+	}
+
+	void compressLevel(const unsigned char* rgba, int width, int height, BlockFormat format, CompressedLevel& level)
+	{
+		level.width = width;
+		level.height = height;
+		level.data.resize(compressedLevelBytes(format, width, height));
+
+		int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+		size_t bytesPerBlock = blockBytes(format);
+		unsigned char* output = level.data.data();
+		defaultThreadPool().parallelFor(blocksY, [&](size_t by) {
+			unsigned char texels[64];
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				gatherBlock(rgba, width, height, bx * 4, (int)by * 4, texels);
+				unsigned char* block = output + (by * blocksX + bx) * bytesPerBlock;
+				if (format == BLOCK_FORMAT_BC3)
+					encodeBC3Block(texels, block);
+				else
+					encodeBC1Block(texels, block);
+			}
+		});
+	}
+
+	// ---- KTX2 ----
+
+	const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	// VkFormat dos blocos (sem sRGB: as texturas da cena são amostradas como lineares)
+	const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+	const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+
+	struct KTX2Header
+	{
+		unsigned char identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(KTX2Header) == 80, "cabecalho KTX2 deve ter 80 bytes");
+
+	struct KTX2LevelIndex
+	{
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	// Descritor de formato (Khronos Data Format, bloco básico): modelo BC1A ou BC3,
+	// bloco de 4x4, e uma amostra por plano de 64 bits
+	vector<uint32_t> dataFormatDescriptor(BlockFormat format)
+	{
+		const uint32_t KHR_DF_MODEL_BC1A = 128, KHR_DF_MODEL_BC3 = 130;
+		const uint32_t KHR_DF_PRIMARIES_BT709 = 1, KHR_DF_TRANSFER_LINEAR = 1;
+		const uint32_t KHR_DF_CHANNEL_BC1A_COLOR = 0, KHR_DF_CHANNEL_BC3_ALPHA = 15, KHR_DF_CHANNEL_BC3_COLOR = 0;
+
+		bool bc3 = format == BLOCK_FORMAT_BC3;
+		uint32_t sampleCount = bc3 ? 2 : 1;
+		uint32_t blockSize = 24 + 16 * sampleCount;
+
+		vector<uint32_t> words;
+		words.push_back(4 + blockSize);                       // tamanho total
+		words.push_back(0);                                   // vendor Khronos, descritor básico
+		words.push_back(2 | (blockSize << 16));               // versão 2
+		words.push_back((bc3 ? KHR_DF_MODEL_BC3 : KHR_DF_MODEL_BC1A) | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+		words.push_back(3 | (3 << 8));                        // bloco 4x4 (dimensão - 1)
+		words.push_back((uint32_t)blockBytes(format));       // bytes no plano 0
+		words.push_back(0);
+
+		auto addSample = [&words](uint32_t bitOffset, uint32_t channel) {
+			words.push_back(bitOffset | (63u << 16) | (channel << 24));
+			words.push_back(0);
+			words.push_back(0);
+			words.push_back(0xFFFFFFFFu);
+		};
+		if (bc3)
+		{
+			addSample(0, KHR_DF_CHANNEL_BC3_ALPHA);
+			addSample(64, KHR_DF_CHANNEL_BC3_COLOR);
+		}
+		else
+		{
+			addSample(0, KHR_DF_CHANNEL_BC1A_COLOR);
+		}
+		return words;
+	}
+
+	void appendKeyValue(vector<unsigned char>& data, const string& key, const string& value)
+	{
+		uint32_t length = (uint32_t)(key.size() + 1 + value.size() + 1);
+		const unsigned char* lengthBytes = (const unsigned char*)&length;
+		data.insert(data.end(), lengthBytes, lengthBytes + 4);
+		data.insert(data.end(), key.begin(), key.end());
+		data.push_back(0);
+		data.insert(data.end(), value.begin(), value.end());
+		data.push_back(0);
+		while (data.size() % 4 != 0)
+			data.push_back(0);
+	}
+
+	// Procura a chave nos metadados; o valor é texto terminado em zero
+	bool findKeyValue(const unsigned char* data, size_t size, const string& key, string& value)
+	{
+		size_t offset = 0;
+		while (offset + 4 <= size)
+		{
+			uint32_t length;
+			memcpy(&length, data + offset, 4);
+			offset += 4;
+			if (length > size - offset)
+				return false;
+
+			const char* entry = (const char*)data + offset;
+			size_t keyLength = strnlen(entry, length);
+			if (keyLength < length && key.compare(0, string::npos, entry, keyLength) == 0)
+			{
+				size_t valueLength = strnlen(entry + keyLength + 1, length - keyLength - 1);
+				value.assign(entry + keyLength + 1, valueLength);
+				return true;
+			}
+			offset += (length + 3) & ~(size_t)3;
+		}
+		return false;
+	}
+
+	inline size_t alignTo(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	double psnr(const vector<unsigned char>& original, const vector<unsigned char>& decoded, int channels)
+	{
+		double squaredError = 0.0;
+		size_t samples = 0;
+		for (size_t i = 0; i + 3 < original.size(); i += 4)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				double difference = (double)original[i + c] - (double)decoded[i + c];
+				squaredError += difference * difference;
+				samples++;
+			}
+		}
+		if (squaredError == 0.0)
+			return 99.0;
+		return 10.0 * log10(255.0 * 255.0 / (squaredError / samples));
+	}
+}
+
+size_t blockBytes(BlockFormat format)
+{
+	return format == BLOCK_FORMAT_BC3 ? 16 : 8;
+}
+
+size_t compressedLevelBytes(BlockFormat format, int width, int height)
+{
+	return (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4) * blockBytes(format);
+}
+
+size_t CompressedImage::totalBytes() const
+{
+	size_t total = 0;
+	for (const CompressedLevel& level : levels)
+		total += level.data.size();
+	return total;
+}
+
+void encodeBC1Block(const unsigned char* rgba, unsigned char* block)
+{
+	encodeColorBlock(rgba, block);
+}
+
+void encodeBC3Block(const unsigned char* rgba, unsigned char* block)
+{
+	encodeAlphaBlock(rgba, block);
+	encodeColorBlock(rgba, block + 8);
+}
+
+void decodeBC1Block(const unsigned char* block, unsigned char* rgba)
+{
+	decodeColorBlock(block, rgba, false);
+}
+
+void decodeBC3Block(const unsigned char* block, unsigned char* rgba)
+{
+	decodeColorBlock(block + 8, rgba, true);
+	decodeAlphaBlock(block, rgba);
+}
+
+void compressImage(const unsigned char* rgba, int width, int height, BlockFormat format, bool mipmaps, CompressedImage& image)
+{
+	image.format = format;
+	image.levels.clear();
+	if (!mipmaps)
+	{
+		image.levels.emplace_back();
+		compressLevel(rgba, width, height, format, image.levels.back());
+		return;
+	}
+
+	// Cadeia gerada na CPU (média em luz linear), um nível comprimido de cada vez
+	MipChain chain;
+	generateMipChain(rgba, width, height, 4, MIP_FILTER_BOX, chain);
+	for (MipLevel& level : chain.levels)
+	{
+		image.levels.emplace_back();
+		compressLevel(level.data.data(), level.width, level.height, format, image.levels.back());
+		level.data.clear();
+		level.data.shrink_to_fit();
+	}
+}
+
+void decompressLevel(BlockFormat format, const CompressedLevel& level, vector<unsigned char>& rgba)
+{
+	rgba.resize((size_t)level.width * level.height * 4);
+	int blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+	size_t bytesPerBlock = blockBytes(format);
+	unsigned char texels[64];
+	for (int by = 0; by < blocksY; by++)
+	{
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			const unsigned char* block = level.data.data() + ((size_t)by * blocksX + bx) * bytesPerBlock;
+			if (format == BLOCK_FORMAT_BC3)
+				decodeBC3Block(block, texels);
+			else
+				decodeBC1Block(block, texels);
+
+			// Só os texels dentro da imagem (blocos da borda podem sobrar)
+			for (int y = 0; y < 4 && by * 4 + y < level.height; y++)
+			{
+				int x0 = bx * 4;
+				int count = std::min(4, level.width - x0);
+				memcpy(&rgba[((size_t)(by * 4 + y) * level.width + x0) * 4], &texels[y * 16], (size_t)count * 4);
+			}
+		}
+	}
+}
+
+bool writeKTX2(const string& filePath, const CompressedImage& image)
+{
+	if (image.levels.empty())
+		return false;
+
+	vector<uint32_t> dfd = dataFormatDescriptor(image.format);
+
+	char hashText[32], sizeText[32];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)image.sourceHash);
+	snprintf(sizeText, sizeof(sizeText), "%llu", (unsigned long long)image.sourceSize);
+	vector<unsigned char> kvd;
+	appendKeyValue(kvd, "CGsourceHash", hashText);
+	appendKeyValue(kvd, "CGsourceSize", sizeText);
+	appendKeyValue(kvd, "KTXwriter", "TrabalhoGB --bake-textures");
+
+	KTX2Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(header.identifier));
+	header.vkFormat = image.format == BLOCK_FORMAT_BC3 ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	header.typeSize = 1;
+	header.pixelWidth = (uint32_t)image.levels[0].width;
+	header.pixelHeight = (uint32_t)image.levels[0].height;
+	header.faceCount = 1;
+	header.levelCount = (uint32_t)image.levels.size();
+	header.dfdByteOffset = (uint32_t)(sizeof(header) + sizeof(KTX2LevelIndex) * image.levels.size());
+	header.dfdByteLength = (uint32_t)(dfd.size() * sizeof(uint32_t));
+	header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+	header.kvdByteLength = (uint32_t)kvd.size();
+
+	// Níveis do menor para o maior, alinhados ao tamanho do bloco
+	vector<KTX2LevelIndex> levelIndex(image.levels.size());
+	size_t offset = header.kvdByteOffset + header.kvdByteLength;
+	for (size_t i = image.levels.size(); i-- > 0;)
+	{
+		offset = alignTo(offset, blockBytes(image.format));
+		levelIndex[i].byteOffset = offset;
+		levelIndex[i].byteLength = image.levels[i].data.size();
+		levelIndex[i].uncompressedByteLength = image.levels[i].data.size();
+		offset += image.levels[i].data.size();
+	}
+
+	string tempPath = filePath + ".tmp";
+	{
+		ofstream out(tempPath, ios::binary | ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)levelIndex.data(), levelIndex.size() * sizeof(KTX2LevelIndex));
+		out.write((const char*)dfd.data(), header.dfdByteLength);
+		out.write((const char*)kvd.data(), kvd.size());
+
+		size_t written = header.kvdByteOffset + header.kvdByteLength;
+		const char padding[16] = { 0 };
+		for (size_t i = image.levels.size(); i-- > 0;)
+		{
+			out.write(padding, levelIndex[i].byteOffset - written);
+			out.write((const char*)image.levels[i].data.data(), image.levels[i].data.size());
+			written = levelIndex[i].byteOffset + levelIndex[i].byteLength;
+		}
+		if (!out.good())
+			return false;
+	}
+
+	error_code error;
+	filesystem::rename(tempPath, filePath, error);
+	if (error)
+	{
+		filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool readKTX2(const string& filePath, CompressedImage& image)
+{
+	MappedFile file;
+	if (!file.open(filePath) || file.size() < sizeof(KTX2Header))
+		return false;
+
+	const unsigned char* data = (const unsigned char*)file.data();
+	KTX2Header header;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0 || header.supercompressionScheme != 0 ||
+		header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1)
+		return false;
+
+	if (header.vkFormat == VK_FORMAT_BC1_RGB_UNORM_BLOCK)
+		image.format = BLOCK_FORMAT_BC1;
+	else if (header.vkFormat == VK_FORMAT_BC3_UNORM_BLOCK)
+		image.format = BLOCK_FORMAT_BC3;
+	else
+		return false;
+
+	// levelCount 0 significa "gerar os mipmaps na carga": não é o caso dos arquivos gerados aqui
+	size_t levelCount = header.levelCount;
+	if (levelCount == 0 || levelCount > 32 || sizeof(header) + levelCount * sizeof(KTX2LevelIndex) > file.size())
+		return false;
+
+	image.sourceHash = 0;
+	image.sourceSize = 0;
+	if ((size_t)header.kvdByteOffset + header.kvdByteLength <= file.size())
+	{
+		string value;
+		if (findKeyValue(data + header.kvdByteOffset, header.kvdByteLength, "CGsourceHash", value))
+			image.sourceHash = strtoull(value.c_str(), nullptr, 16);
+		if (findKeyValue(data + header.kvdByteOffset, header.kvdByteLength, "CGsourceSize", value))
+			image.sourceSize = strtoull(value.c_str(), nullptr, 10);
+	}
+
+	image.levels.assign(levelCount, CompressedLevel());
+	for (size_t i = 0; i < levelCount; i++)
+	{
+		KTX2LevelIndex level;
+		memcpy(&level, data + sizeof(header) + i * sizeof(KTX2LevelIndex), sizeof(level));
+
+		int width = std::max(1, (int)(header.pixelWidth >> i));
+		int height = std::max(1, (int)(header.pixelHeight >> i));
+		if (level.byteLength != compressedLevelBytes(image.format, width, height) ||
+			level.byteOffset > file.size() || level.byteLength > file.size() - level.byteOffset)
+			return false;
+
+		image.levels[i].width = width;
+		image.levels[i].height = height;
+		image.levels[i].data.assign(data + level.byteOffset, data + level.byteOffset + level.byteLength);
+	}
+	return true;
+}
+
+string compressedTexturePath(const string& imagePath)
+{
+	return imagePath + ".ktx2";
+}
+
+bool loadCompressedTexture(const string& imagePath, CompressedImage& image)
+{
+	string path = compressedTexturePath(imagePath);
+	if (!filesystem::exists(path))
+		return false;
+
+	MappedFile source;
+	if (!source.open(imagePath) || !readKTX2(path, image))
+		return false;
+
+	// Imagem alterada depois da compressão: o arquivo não vale mais
+	if (image.sourceSize != source.size() || image.sourceHash != hashBytes(source.data(), source.size()))
+	{
+		image.levels.clear();
+		return false;
+	}
+	return true;
+}
+
+int limitCompressedSize(CompressedImage& image, int maxSize)
+{
+	size_t dropped = 0;
+	while (maxSize > 0 && dropped + 1 < image.levels.size() &&
+		std::max(image.levels[dropped].width, image.levels[dropped].height) > maxSize)
+		dropped++;
+	image.levels.erase(image.levels.begin(), image.levels.begin() + dropped);
+	return (int)dropped;
+}
+
+GLuint createCompressedTexture(const string& filePath, CompressedImage& image, const SamplerSettings& sampler)
+{
+	if (image.levels.empty())
+	{
+		cout << "Failed to load texture " << filePath << endl;
+		return 0;
+	}
+
+	GLuint texID;
+	glGenTextures(1, &texID);
+	glBindTexture(GL_TEXTURE_2D, texID);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrapT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+
+	// Os mipmaps já vêm prontos no arquivo (não há glGenerateMipmap para formatos comprimidos)
+	GLenum internalFormat = image.format == BLOCK_FORMAT_BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	size_t levelCount = sampler.mipmaps ? image.levels.size() : 1;
+	for (size_t i = 0; i < levelCount; i++)
+	{
+		const CompressedLevel& level = image.levels[i];
+		glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, internalFormat, level.width, level.height, 0, (GLsizei)level.data.size(), level.data.data());
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levelCount - 1);
+
+	image.levels.clear();
+	image.levels.shrink_to_fit();
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texID;
+}
+
+bool bakeTextures(const vector<string>& files)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	cout << left << setw(44) << "Arquivo" << right << setw(12) << "tamanho" << setw(8) << "bloco"
+		<< setw(12) << "RGBA8 KB" << setw(12) << "KTX2 KB" << setw(8) << "razao" << setw(10) << "PSNR dB"
+		<< setw(10) << "ms" << "  verificacao" << endl;
+
+	bool allPassed = true;
+	for (const string& file : files)
+	{
+		MappedFile source;
+		DecodedImage decoded;
+		if (!source.open(file) || !decodeImage(file, decoded, 4))
+		{
+			cout << "Erro ao tentar ler o arquivo " << file << endl;
+			allPassed = false;
+			continue;
+		}
+
+		int width = decoded.width, height = decoded.height;
+		vector<unsigned char> original(decoded.data, decoded.data + (size_t)width * height * 4);
+		freeImage(decoded);
+
+		// BC3 só quando a imagem tem alfa de verdade; senão BC1 (metade do tamanho)
+		bool hasAlpha = false;
+		for (size_t i = 3; i < original.size() && !hasAlpha; i += 4)
+			hasAlpha = original[i] != 255;
+		BlockFormat format = hasAlpha ? BLOCK_FORMAT_BC3 : BLOCK_FORMAT_BC1;
+
+		Clock::time_point start = Clock::now();
+		CompressedImage compressed;
+		compressImage(original.data(), width, height, format, true, compressed);
+		compressed.sourceHash = hashBytes(source.data(), source.size());
+		compressed.sourceSize = source.size();
+		double milliseconds = chrono::duration<double, milli>(Clock::now() - start).count();
+
+		// Relê o arquivo gravado: os blocos têm que voltar idênticos e a imagem tem que ser reconhecida como atual
+		string outputPath = compressedTexturePath(file);
+		CompressedImage reloaded;
+		bool passed = writeKTX2(outputPath, compressed) && loadCompressedTexture(file, reloaded) &&
+			reloaded.format == compressed.format && reloaded.levels.size() == compressed.levels.size();
+		for (size_t i = 0; passed && i < compressed.levels.size(); i++)
+			passed = reloaded.levels[i].data == compressed.levels[i].data;
+
+		vector<unsigned char> roundTrip;
+		decompressLevel(format, compressed.levels[0], roundTrip);
+		double quality = psnr(original, roundTrip, hasAlpha ? 4 : 3);
+
+		size_t uncompressedBytes = textureBytes(width, height, true);
+		size_t compressedBytes = compressed.totalBytes();
+		cout << left << setw(44) << file << right << setw(12) << (to_string(width) + "x" + to_string(height))
+			<< setw(8) << (format == BLOCK_FORMAT_BC3 ? "BC3" : "BC1")
+			<< setw(12) << uncompressedBytes / 1024 << setw(12) << compressedBytes / 1024
+			<< setw(7) << fixed << setprecision(1) << (double)uncompressedBytes / compressedBytes << "x"
+			<< setw(10) << quality << setw(10) << milliseconds << defaultfloat << setprecision(6)
+			<< "  " << (passed ? "ok" : "FALHOU") << endl;
+		allPassed = allPassed && passed;
+	}
+	return allPassed;
+}
@@ -0,0 +1,164 @@
+#include "DrawStats.h"
+
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+namespace
+{
+	// Elementos endereçáveis pelas faixas: índices, ou vértices se a malha não é indexada
+	inline GLsizei elementCount(const MeshStats& mesh)
+	{
+		return mesh.indexCount > 0 ? mesh.indexCount : mesh.vertexCount;
+	}
+
+	template <typename Index>
+	size_t countIndicesOutOfRange(const Index* indices, size_t count, size_t vertexCount)
+	{
+		size_t outOfRange = 0;
+		for (size_t i = 0; i < count; i++)
+			outOfRange += (indices[i] >= vertexCount);
+		return outOfRange;
+	}
+}
+
+int DrawStats::registerMesh(const string& name, const MeshLayout& layout, size_t vertexBytes, const void* indexData, size_t indexBytes)
+{
+	MeshStats stats;
+	stats.name = name;
+	stats.vertexCount = layout.vertexCount;
+	stats.indexCount = layout.indexCount;
+	stats.triangleCount = layout.baseElementCount() / 3;
+	stats.lodCount = 1 + (int)layout.lods.size();
+	stats.vertexBytes = vertexBytes;
+	stats.indexBytes = indexBytes;
+
+	int id = (int)meshes.size();
+	meshes.push_back(stats);
+	reportedInvalidDraw.push_back(false);
+	MeshStats& mesh = meshes.back();
+
+	// O tamanho dos buffers tem que bater com as quantidades do layout
+	size_t indexSize = layout.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	if (vertexBytes != (size_t)layout.vertexCount * vertexStride(layout.format) || indexBytes != (size_t)layout.indexCount * indexSize)
+	{
+		cout << "Malha " << name << ": tamanho dos buffers (" << vertexBytes << " + " << indexBytes
+			<< " bytes) nao corresponde a " << layout.vertexCount << " vertices e " << layout.indexCount << " indices" << endl;
+		mesh.valid = false;
+	}
+
+	if (indexData != nullptr && layout.indexCount > 0)
+	{
+		size_t outOfRange = layout.indexType == GL_UNSIGNED_SHORT
+			? countIndicesOutOfRange((const GLushort*)indexData, layout.indexCount, layout.vertexCount)
+			: countIndicesOutOfRange((const GLuint*)indexData, layout.indexCount, layout.vertexCount);
+		if (outOfRange > 0)
+		{
+			cout << "Malha " << name << ": " << outOfRange << " indice(s) apontam alem dos " << layout.vertexCount << " vertices" << endl;
+			mesh.valid = false;
+		}
+	}
+
+	if (elementCount(mesh) % 3 != 0)
+	{
+		cout << "Malha " << name << ": " << elementCount(mesh) << " elementos nao formam triangulos completos" << endl;
+		mesh.valid = false;
+	}
+
+	auto validateSubMeshes = [&](const vector<SubMesh>& submeshes) {
+		for (const SubMesh& submesh : submeshes)
+		{
+			if (!validateRange(id, (GLint)submesh.first, (GLsizei)submesh.count) || submesh.count % 3 != 0)
+			{
+				cout << "Malha " << name << ": faixa do material \"" << submesh.material << "\" [" << submesh.first << ", "
+					<< submesh.first + submesh.count << ") invalida para " << elementCount(mesh) << " elementos" << endl;
+				mesh.valid = false;
+			}
+		}
+	};
+	validateSubMeshes(layout.submeshes);
+	for (size_t l = 0; l < layout.lods.size(); l++)
+	{
+		const MeshLod& lod = layout.lods[l];
+		if (!validateRange(id, (GLint)lod.first, (GLsizei)lod.count) || lod.count % 3 != 0)
+		{
+			cout << "Malha " << name << ": nivel de detalhe " << l + 1 << " [" << lod.first << ", "
+				<< lod.first + lod.count << ") invalido para " << elementCount(mesh) << " elementos" << endl;
+			mesh.valid = false;
+		}
+		validateSubMeshes(lod.submeshes);
+	}
+	return id;
+}
+
+bool DrawStats::validateRange(int id, GLint first, GLsizei count) const
+{
+	if (id < 0 || id >= (int)meshes.size())
+		return false;
+	return first >= 0 && count >= 0 && (size_t)first + (size_t)count <= (size_t)elementCount(meshes[id]);
+}
+
+GLsizei DrawStats::recordDraw(int id, GLint first, GLsizei count, GLsizei instances)
+{
+	size_t copies = instances > 0 ? (size_t)instances : 1;
+	totals.drawCalls++;
+	if (instances > 0)
+	{
+		totals.instancedDraws++;
+		totals.instances += instances;
+	}
+	totals.submittedTriangles += count / 3 * copies;
+	if (validateRange(id, first, count))
+	{
+		totals.realTriangles += count / 3 * copies;
+		return count;
+	}
+
+	// Recorta a faixa ao que existe no buffer (nada, se a malha é desconhecida)
+	totals.invalidDraws++;
+	GLsizei available = 0;
+	if (id >= 0 && id < (int)meshes.size() && first >= 0)
+		available = std::max(0, std::min(count, elementCount(meshes[id]) - first));
+	totals.realTriangles += available / 3 * copies;
+
+	if (id >= 0 && id < (int)meshes.size() && !reportedInvalidDraw[id])
+	{
+		cout << "Desenho invalido de " << meshes[id].name << ": [" << first << ", " << (size_t)first + count
+			<< ") com " << elementCount(meshes[id]) << " elementos no buffer" << endl;
+		reportedInvalidDraw[id] = true;
+	}
+	return available;
+}
+
+void DrawStats::report(ostream& out) const
+{
+	if (totals.frames == 0)
+		return;
+
+	double frames = (double)totals.frames;
+	double wasted = totals.submittedTriangles > 0
+		? 100.0 * (double)(totals.submittedTriangles - totals.realTriangles) / (double)totals.submittedTriangles
+		: 0.0;
+	out << fixed << setprecision(0) << "Por frame: " << totals.drawCalls / frames << " draw calls, "
+		<< totals.submittedTriangles / frames << " triangulos enviados, " << totals.realTriangles / frames << " reais ("
+		<< setprecision(1) << wasted << "% desperdicados), " << setprecision(0) << totals.textureBinds / frames << " troca(s) de textura";
+	if (totals.instancedDraws > 0)
+		out << ", " << setprecision(0) << totals.instances / frames << " instancias em " << totals.instancedDraws / frames << " desenho(s) instanciado(s)";
+	if (totals.multiDraws > 0)
+		out << ", " << setprecision(0) << totals.indirectCommands / frames << " comando(s) em " << totals.multiDraws / frames << " envio(s) indireto(s)";
+	if (totals.visibleObjects + totals.culledObjects > 0)
+		out << ", " << setprecision(0) << totals.visibleObjects / frames << " objeto(s) visivel(is) e " << totals.culledObjects / frames << " recortado(s)";
+	size_t simplifiedObjects = 0;
+	for (int lod = 1; lod < MAX_MESH_LODS; lod++)
+		simplifiedObjects += totals.lodObjects[lod];
+	if (simplifiedObjects > 0)
+	{
+		out << ", objetos por nivel de detalhe:";
+		for (int lod = 0; lod < MAX_MESH_LODS; lod++)
+			out << (lod == 0 ? " " : " / ") << setprecision(0) << totals.lodObjects[lod] / frames;
+	}
+	if (totals.invalidDraws > 0)
+		out << ", " << setprecision(0) << totals.invalidDraws / frames << " desenho(s) invalido(s)";
+	out << defaultfloat << setprecision(6) << endl;
+}
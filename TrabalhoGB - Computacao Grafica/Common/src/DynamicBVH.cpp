@@ -0,0 +1,745 @@
+#include "DynamicBVH.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <iomanip>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+
+namespace
+{
+	// Folga da caixa de um objeto reinserido pelo move: fração do tamanho da caixa mais o
+	// deslocamento do último move repetido MOVE_PREDICTION vezes na direção do movimento
+	const float MOVE_MARGIN = 0.1f;
+	const float MOVE_PREDICTION = 4.0f;
+
+	const unsigned ALL_PLANES = (1u << 6) - 1;
+
+	// Teste de uma caixa contra os planos marcados em planes: retorna false se a caixa está
+	// inteira do lado de fora de algum e tira de planes os que ela tem inteiros do lado de dentro
+	bool testPlanes(const Frustum& frustum, const Aabb& box, unsigned& planes)
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			if (!(planes & (1u << p)))
+				continue;
+			const glm::vec4& plane = frustum.planes[p];
+
+			// Vértice mais à frente e mais atrás da caixa na direção da normal
+			float farthest = plane.x * (plane.x >= 0.0f ? box.max.x : box.min.x) + plane.y * (plane.y >= 0.0f ? box.max.y : box.min.y)
+				+ plane.z * (plane.z >= 0.0f ? box.max.z : box.min.z) + plane.w;
+			if (farthest < 0.0f)
+				return false;
+			float nearest = plane.x * (plane.x >= 0.0f ? box.min.x : box.max.x) + plane.y * (plane.y >= 0.0f ? box.min.y : box.max.y)
+				+ plane.z * (plane.z >= 0.0f ? box.min.z : box.max.z) + plane.w;
+			if (nearest >= 0.0f)
+				planes &= ~(1u << p);
+		}
+		return true;
+	}
+}
+
+Aabb Aabb::transformed(const glm::mat4& model, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	// Centro transformado e meia largura pelos valores absolutos da parte 3x3, como no setBounds
+	glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+	glm::vec3 halfSize = 0.5f * (boundsMax - boundsMin);
+	const glm::vec4& column0 = model[0];
+	const glm::vec4& column1 = model[1];
+	const glm::vec4& column2 = model[2];
+	const glm::vec4& column3 = model[3];
+	glm::vec3 worldCenter(column0.x * center.x + column1.x * center.y + column2.x * center.z + column3.x,
+		column0.y * center.x + column1.y * center.y + column2.y * center.z + column3.y,
+		column0.z * center.x + column1.z * center.y + column2.z * center.z + column3.z);
+	glm::vec3 extent(std::fabs(column0.x) * halfSize.x + std::fabs(column1.x) * halfSize.y + std::fabs(column2.x) * halfSize.z,
+		std::fabs(column0.y) * halfSize.x + std::fabs(column1.y) * halfSize.y + std::fabs(column2.y) * halfSize.z,
+		std::fabs(column0.z) * halfSize.x + std::fabs(column1.z) * halfSize.y + std::fabs(column2.z) * halfSize.z);
+	return { worldCenter - extent, worldCenter + extent };
+}
+
+bool Aabb::contains(const Aabb& other) const
+{
+	return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+		&& max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+}
+
+float Aabb::surfaceArea() const
+{
+	glm::vec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+float intersectRay(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+	// Intervalo do raio dentro das três faixas entre os planos da caixa
+	float enter = 0.0f, leave = maxDistance;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t1 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+		float t2 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+		enter = std::max(enter, std::min(t1, t2));
+		leave = std::min(leave, std::max(t1, t2));
+	}
+	return enter <= leave ? enter : -1.0f;
+}
+
+int DynamicBVH::allocateNode()
+{
+	if (freeList < 0)
+	{
+		nodes.emplace_back();
+		objectBoxes.emplace_back();
+		return (int)nodes.size() - 1;
+	}
+	int index = freeList;
+	freeList = nodes[index].parent;
+	nodes[index] = Node();
+	return index;
+}
+
+void DynamicBVH::freeNode(int index)
+{
+	nodes[index].parent = freeList;
+	nodes[index].height = -1;
+	freeList = index;
+}
+
+void DynamicBVH::build(const vector<Aabb>& boxes, vector<int>& leafOfObject)
+{
+	nodes.clear();
+	objectBoxes.clear();
+	freeList = -1;
+	root = -1;
+	leaves = boxes.size();
+	objectSlots = boxes.size();
+	leafOfObject.assign(boxes.size(), -1);
+	if (boxes.empty())
+		return;
+
+	nodes.reserve(2 * boxes.size() - 1);
+	objectBoxes.reserve(2 * boxes.size() - 1);
+	// Caixas copiadas junto com o objeto: as divisões reordenam memória contínua
+	vector<BuildItem> items(boxes.size());
+	for (size_t i = 0; i < items.size(); i++)
+		items[i] = { boxes[i], (int)i };
+	root = buildRange(items.data(), items.size(), leafOfObject);
+}
+
+int DynamicBVH::buildRange(BuildItem* items, size_t count, vector<int>& leafOfObject)
+{
+	if (count == 1)
+	{
+		int leaf = allocateNode();
+		nodes[leaf].box = items[0].box;
+		nodes[leaf].object = items[0].object;
+		objectBoxes[leaf] = items[0].box;
+		leafOfObject[items[0].object] = leaf;
+		return leaf;
+	}
+
+	// Divide pelo eixo em que os centros mais se espalham, na fronteira entre faixas de
+	// centros (bins) que dá a menor soma área x quantidade dos dois lados
+	const int BINS = 16;
+	glm::vec3 centerMin(FLT_MAX), centerMax(-FLT_MAX);
+	for (size_t i = 0; i < count; i++)
+	{
+		const Aabb& box = items[i].box;
+		glm::vec3 center = box.min + box.max;
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+	glm::vec3 spread = centerMax - centerMin;
+	int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+
+	size_t middle = 0;
+	if (spread[axis] > 0.0f)
+	{
+		float binScale = BINS / spread[axis];
+		auto binOf = [&](const BuildItem& item) {
+			const Aabb& box = item.box;
+			return std::min(BINS - 1, (int)((box.min[axis] + box.max[axis] - centerMin[axis]) * binScale));
+		};
+
+		Aabb binBoxes[BINS];
+		size_t binCounts[BINS] = {};
+		for (size_t i = 0; i < count; i++)
+		{
+			int bin = binOf(items[i]);
+			binBoxes[bin] = binCounts[bin]++ == 0 ? items[i].box : binBoxes[bin].merged(items[i].box);
+		}
+
+		// Custo da esquerda acumulado da esquerda para a direita, o da direita ao contrário
+		float leftCost[BINS];
+		Aabb accumulated;
+		size_t side = 0;
+		for (int bin = 0; bin < BINS - 1; bin++)
+		{
+			if (binCounts[bin] > 0)
+				accumulated = side == 0 ? binBoxes[bin] : accumulated.merged(binBoxes[bin]);
+			side += binCounts[bin];
+			leftCost[bin] = side == 0 ? 0.0f : accumulated.surfaceArea() * side;
+		}
+		int bestSplit = -1;
+		float bestCost = FLT_MAX;
+		side = 0;
+		for (int bin = BINS - 1; bin > 0; bin--)
+		{
+			if (binCounts[bin] > 0)
+				accumulated = side == 0 ? binBoxes[bin] : accumulated.merged(binBoxes[bin]);
+			side += binCounts[bin];
+			float cost = leftCost[bin - 1] + (side == 0 ? 0.0f : accumulated.surfaceArea() * side);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = bin;
+			}
+		}
+
+		middle = std::partition(items, items + count, [&](const BuildItem& item) { return binOf(item) < bestSplit; }) - items;
+	}
+
+	// Todos do mesmo lado (centros iguais ou num bin só): metade pela posição do centro
+	if (middle == 0 || middle == count)
+	{
+		middle = count / 2;
+		std::nth_element(items, items + middle, items + count, [&](const BuildItem& a, const BuildItem& b) {
+			return a.box.min[axis] + a.box.max[axis] < b.box.min[axis] + b.box.max[axis];
+		});
+	}
+
+	int node = allocateNode();
+	int child1 = buildRange(items, middle, leafOfObject);
+	int child2 = buildRange(items + middle, count - middle, leafOfObject);
+	nodes[node].child1 = child1;
+	nodes[node].child2 = child2;
+	nodes[child1].parent = node;
+	nodes[child2].parent = node;
+	updateFromChildren(node);
+	return node;
+}
+
+int DynamicBVH::insert(const Aabb& box, int object)
+{
+	int leaf = allocateNode();
+	nodes[leaf].box = box;
+	nodes[leaf].object = object;
+	objectBoxes[leaf] = box;
+	insertLeaf(leaf);
+	leaves++;
+	objectSlots = std::max(objectSlots, (size_t)object + 1);
+	return leaf;
+}
+
+void DynamicBVH::remove(int leaf)
+{
+	removeLeaf(leaf);
+	freeNode(leaf);
+	leaves--;
+}
+
+void DynamicBVH::insertLeaf(int leaf)
+{
+	if (root < 0)
+	{
+		root = leaf;
+		nodes[leaf].parent = -1;
+		return;
+	}
+
+	int sibling = findBestSibling(nodes[leaf].box);
+
+	// Nó novo no lugar do irmão, com o irmão e a folha como filhos
+	int oldParent = nodes[sibling].parent;
+	int newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if (oldParent < 0)
+		root = newParent;
+	else if (nodes[oldParent].child1 == sibling)
+		nodes[oldParent].child1 = newParent;
+	else
+		nodes[oldParent].child2 = newParent;
+
+	for (int index = newParent; index >= 0; index = nodes[index].parent)
+	{
+		updateFromChildren(index);
+		rotate(index);
+	}
+}
+
+void DynamicBVH::removeLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = -1;
+		return;
+	}
+
+	// O irmão toma o lugar do pai, que sai da árvore
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+	freeNode(parent);
+	nodes[sibling].parent = grandParent;
+	if (grandParent < 0)
+	{
+		root = sibling;
+		return;
+	}
+	if (nodes[grandParent].child1 == parent)
+		nodes[grandParent].child1 = sibling;
+	else
+		nodes[grandParent].child2 = sibling;
+
+	for (int index = grandParent; index >= 0; index = nodes[index].parent)
+	{
+		updateFromChildren(index);
+		rotate(index);
+	}
+}
+
+void DynamicBVH::updateFromChildren(int index)
+{
+	Node& node = nodes[index];
+	const Node& child1 = nodes[node.child1];
+	const Node& child2 = nodes[node.child2];
+	node.box = child1.box.merged(child2.box);
+	node.height = 1 + std::max(child1.height, child2.height);
+	node.pending = child1.pending || child2.pending;
+}
+
+int DynamicBVH::findBestSibling(const Aabb& box) const
+{
+	// Custo de pendurar a folha ao lado de um nó: a área do nó novo (caixa do nó com a da
+	// folha) mais o quanto cresce a caixa de cada ancestral. Desce pelo filho de menor custo
+	// mínimo possível e para quando nenhum filho pode mais baixar o melhor custo achado.
+	// Custos iguais (ex: muitas caixas iguais, que cabem em qualquer nó) desempatam pela
+	// profundidade mais a altura do irmão: a árvore cresce por baixo e continua baixa,
+	// em vez de cada folha nova virar irmã da raiz
+	float boxArea = box.surfaceArea();
+	glm::vec3 boxCenter = 0.5f * (box.min + box.max);
+	int index = root;
+	float area = nodes[root].box.surfaceArea();
+	float directCost = nodes[root].box.merged(box).surfaceArea();
+	float inheritedCost = 0.0f;
+	int depth = 0;
+	int bestSibling = root;
+	float bestCost = directCost;
+	int bestRank = nodes[root].height;
+	auto consider = [&](int candidate, float cost, int rank) {
+		if (cost < bestCost || (cost == bestCost && rank < bestRank))
+		{
+			bestSibling = candidate;
+			bestCost = cost;
+			bestRank = rank;
+		}
+	};
+	while (!nodes[index].isLeaf())
+	{
+		consider(index, directCost + inheritedCost, depth + nodes[index].height);
+		inheritedCost += directCost - area;
+
+		int children[2] = { nodes[index].child1, nodes[index].child2 };
+		float lowerCost[2], childArea[2], childDirectCost[2];
+		bool childLeaf[2];
+		for (int c = 0; c < 2; c++)
+		{
+			const Node& child = nodes[children[c]];
+			childLeaf[c] = child.isLeaf();
+			childDirectCost[c] = child.box.merged(box).surfaceArea();
+			childArea[c] = child.box.surfaceArea();
+			lowerCost[c] = FLT_MAX;
+			if (childLeaf[c])
+				consider(children[c], childDirectCost[c] + inheritedCost, depth + 1);
+			else
+			{
+				// Abaixo do filho, o nó novo tem pelo menos a área da folha
+				lowerCost[c] = inheritedCost + childDirectCost[c] + std::min(boxArea - childArea[c], 0.0f);
+			}
+		}
+
+		if (childLeaf[0] && childLeaf[1])
+			break;
+		if (bestCost < lowerCost[0] && bestCost < lowerCost[1])
+			break;
+		if (lowerCost[0] == lowerCost[1] && !childLeaf[0])
+		{
+			// Os dois filhos já contêm a folha: o de centro mais perto e, entre iguais, o mais baixo
+			glm::vec3 offset0 = 0.5f * (nodes[children[0]].box.min + nodes[children[0]].box.max) - boxCenter;
+			glm::vec3 offset1 = 0.5f * (nodes[children[1]].box.min + nodes[children[1]].box.max) - boxCenter;
+			lowerCost[0] = glm::dot(offset0, offset0);
+			lowerCost[1] = glm::dot(offset1, offset1);
+			if (lowerCost[0] == lowerCost[1])
+			{
+				lowerCost[0] = (float)nodes[children[0]].height;
+				lowerCost[1] = (float)nodes[children[1]].height;
+			}
+		}
+
+		int next = lowerCost[0] < lowerCost[1] && !childLeaf[0] ? 0 : 1;
+		index = children[next];
+		depth++;
+		area = childArea[next];
+		directCost = childDirectCost[next];
+	}
+	return bestSibling;
+}
+
+void DynamicBVH::rotate(int a)
+{
+	// Troca um filho de a por um neto do outro lado quando a caixa do filho que recebe a
+	// troca diminui (a caixa de a não muda); fica com a troca que mais diminui
+	if (nodes[a].height < 2)
+		return;
+
+	int children[2] = { nodes[a].child1, nodes[a].child2 };
+	int bestChild = -1, bestGrandChild = -1;
+	float bestGain = 0.0f;
+	for (int side = 0; side < 2; side++)
+	{
+		int child = children[side], other = children[1 - side];
+		if (nodes[other].isLeaf())
+			continue;
+		float otherArea = nodes[other].box.surfaceArea();
+		int grandChildren[2] = { nodes[other].child1, nodes[other].child2 };
+		for (int g = 0; g < 2; g++)
+		{
+			float gain = otherArea - nodes[child].box.merged(nodes[grandChildren[1 - g]].box).surfaceArea();
+			if (gain > bestGain)
+			{
+				bestGain = gain;
+				bestChild = child;
+				bestGrandChild = grandChildren[g];
+			}
+		}
+	}
+	if (bestChild < 0)
+		return;
+
+	int other = nodes[bestGrandChild].parent;
+	if (nodes[a].child1 == bestChild)
+		nodes[a].child1 = bestGrandChild;
+	else
+		nodes[a].child2 = bestGrandChild;
+	if (nodes[other].child1 == bestGrandChild)
+		nodes[other].child1 = bestChild;
+	else
+		nodes[other].child2 = bestChild;
+	nodes[bestChild].parent = other;
+	nodes[bestGrandChild].parent = a;
+	updateFromChildren(other);
+	updateFromChildren(a);
+}
+
+void DynamicBVH::refit(int leaf, const Aabb& box)
+{
+	nodes[leaf].box = box;
+	objectBoxes[leaf] = box;
+	counters.refits++;
+
+	// Marca até o primeiro ancestral já marcado (os de cima dele também estão)
+	for (int index = leaf; index >= 0 && !nodes[index].pending; index = nodes[index].parent)
+		nodes[index].pending = true;
+}
+
+bool DynamicBVH::move(int leaf, const Aabb& box)
+{
+	Node& node = nodes[leaf];
+	Aabb& objectBox = objectBoxes[leaf];
+	glm::vec3 displacement = 0.5f * (box.min + box.max - objectBox.min - objectBox.max);
+	objectBox = box;
+	counters.moves++;
+	if (node.box.contains(box))
+		return false;
+
+	removeLeaf(leaf);
+	glm::vec3 margin = MOVE_MARGIN * (box.max - box.min);
+	glm::vec3 ahead = MOVE_PREDICTION * displacement;
+	nodes[leaf].box.min = box.min - margin + glm::min(ahead, glm::vec3(0.0f));
+	nodes[leaf].box.max = box.max + margin + glm::max(ahead, glm::vec3(0.0f));
+	insertLeaf(leaf);
+	counters.reinserts++;
+	return true;
+}
+
+void DynamicBVH::refitPending()
+{
+	if (root >= 0 && nodes[root].pending)
+		refitNode(root);
+}
+
+void DynamicBVH::refitNode(int index)
+{
+	Node& node = nodes[index];
+	node.pending = false;
+	if (node.isLeaf())
+		return;
+	if (nodes[node.child1].pending)
+		refitNode(node.child1);
+	if (nodes[node.child2].pending)
+		refitNode(node.child2);
+	nodes[index].box = nodes[nodes[index].child1].box.merged(nodes[nodes[index].child2].box);
+}
+
+size_t DynamicBVH::cull(const Frustum& frustum, vector<unsigned char>& visible)
+{
+	refitPending();
+	visible.assign(objectSlots, 0);
+	if (root < 0)
+		return 0;
+
+	// Subárvores com todos os planos garantidos (planes = 0) são visíveis sem testes
+	size_t visibleCount = 0;
+	stack.clear();
+	stack.push_back({ root, ALL_PLANES, 0.0f });
+	while (!stack.empty())
+	{
+		StackEntry entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry.node];
+		if (entry.planes != 0 && !testPlanes(frustum, node.isLeaf() ? objectBoxes[entry.node] : node.box, entry.planes))
+			continue;
+
+		if (node.isLeaf())
+		{
+			visible[node.object] = 1;
+			visibleCount++;
+			continue;
+		}
+		stack.push_back({ node.child1, entry.planes, 0.0f });
+		stack.push_back({ node.child2, entry.planes, 0.0f });
+	}
+	return visibleCount;
+}
+
+DynamicBVH::RayHit DynamicBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+	const function<bool(int object, float& distance)>& exact)
+{
+	refitPending();
+	RayHit hit;
+	if (root < 0)
+		return hit;
+
+	// Desce primeiro pelo filho que o raio acerta antes; caixas que começam depois do
+	// acerto mais próximo até agora ficam de fora
+	glm::vec3 inverseDirection = 1.0f / direction;
+	float closest = maxDistance;
+	float rootDistance = intersectRay(nodes[root].box, origin, inverseDirection, closest);
+	if (rootDistance < 0.0f)
+		return hit;
+
+	stack.clear();
+	stack.push_back({ root, 0, rootDistance });
+	while (!stack.empty())
+	{
+		StackEntry entry = stack.back();
+		stack.pop_back();
+		if (entry.distance > closest)
+			continue;
+		const Node& node = nodes[entry.node];
+
+		if (node.isLeaf())
+		{
+			float distance = intersectRay(objectBoxes[entry.node], origin, inverseDirection, closest);
+			if (distance < 0.0f || (exact && !exact(node.object, distance)))
+				continue;
+			if (distance < closest || (hit.object < 0 && distance <= closest))
+			{
+				closest = distance;
+				hit.object = node.object;
+				hit.distance = distance;
+			}
+			continue;
+		}
+
+		float distance1 = intersectRay(nodes[node.child1].box, origin, inverseDirection, closest);
+		float distance2 = intersectRay(nodes[node.child2].box, origin, inverseDirection, closest);
+		StackEntry first = { node.child1, 0, distance1 }, second = { node.child2, 0, distance2 };
+		if (distance2 >= 0.0f && (distance1 < 0.0f || distance2 < distance1))
+			std::swap(first, second);
+		if (second.distance >= 0.0f)
+			stack.push_back(second);
+		if (first.distance >= 0.0f)
+			stack.push_back(first);
+	}
+	return hit;
+}
+
+float DynamicBVH::areaCost() const
+{
+	if (root < 0 || nodes[root].isLeaf())
+		return 0.0f;
+	double internalArea = 0.0;
+	for (const Node& node : nodes)
+	{
+		if (node.height > 0)
+			internalArea += node.box.surfaceArea();
+	}
+	float rootArea = nodes[root].box.surfaceArea();
+	return rootArea > 0.0f ? (float)(internalArea / rootArea) : 0.0f;
+}
+
+void DynamicBVH::report(ostream& out) const
+{
+	out << "BVH: " << leaves << " folha(s), altura " << height() << ", custo de area " << fixed << setprecision(1) << areaCost();
+	if (counters.frames > 0)
+	{
+		double frames = (double)counters.frames;
+		out << setprecision(0) << "; por frame: " << counters.refits / frames << " reajuste(s), " << counters.moves / frames
+			<< " movimento(s), " << setprecision(1) << counters.reinserts / frames << " reinsercao(oes)";
+	}
+	out << defaultfloat << setprecision(6) << endl;
+}
+
+namespace
+{
+	// Referências do benchmark: todas as caixas testadas uma a uma
+	size_t linearCull(const vector<Aabb>& boxes, const Frustum& frustum, vector<unsigned char>& visible)
+	{
+		size_t visibleCount = 0;
+		visible.assign(boxes.size(), 0);
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			unsigned planes = ALL_PLANES;
+			visible[i] = testPlanes(frustum, boxes[i], planes) ? 1 : 0;
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+
+	DynamicBVH::RayHit linearRaycast(const vector<Aabb>& boxes, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
+	{
+		DynamicBVH::RayHit hit;
+		glm::vec3 inverseDirection = 1.0f / direction;
+		float closest = maxDistance;
+		for (size_t i = 0; i < boxes.size(); i++)
+		{
+			float distance = intersectRay(boxes[i], origin, inverseDirection, closest);
+			if (distance >= 0.0f && (distance < closest || hit.object < 0))
+			{
+				closest = distance;
+				hit.object = (int)i;
+				hit.distance = distance;
+			}
+		}
+		return hit;
+	}
+}
+
+void benchmarkBVH(size_t maxObjects)
+{
+	typedef chrono::high_resolution_clock Clock;
+	auto milliseconds = [](Clock::time_point start) { return chrono::duration<double, milli>(Clock::now() - start).count(); };
+
+	// Caixas em um cubo de lado 400 ao redor da câmera (o tronco da cena, como no
+	// --bench-culling); o lado das caixas diminui com a quantidade para a sobreposição
+	// entre elas ficar parecida
+	glm::mat4 projection = glm::perspective(glm::radians(39.6f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::fromMatrix(projection * view);
+	const int rays = 200;
+	const float rayDistance = 1000.0f;
+
+	cout << "Tempos em ms; custo de area da arvore inserida uma a uma e da construida; na construida: recorte e raios" << endl;
+	cout << "contra a busca linear, mover e reajustar 10% dos objetos" << endl;
+	cout << right << setw(9) << "objetos" << setw(10) << "insercao" << setw(8) << "custo" << setw(12) << "construcao" << setw(8) << "custo" << setw(8) << "altura"
+		<< setw(10) << "recorte" << setw(10) << "linear" << setw(10) << "visiveis" << setw(10) << "raios" << setw(10) << "linear"
+		<< setw(10) << "mover" << setw(12) << "reinseridos" << setw(10) << "reajustar" << setw(8) << "igual" << endl;
+	for (size_t objects = 1000; objects <= maxObjects; objects *= 10)
+	{
+		mt19937 random(11);
+		float side = 3.0f * std::cbrt(100000.0f / (float)objects);
+		uniform_real_distribution<float> position(-200.0f, 200.0f), size(0.2f * side, side), unit(-1.0f, 1.0f);
+		vector<Aabb> boxes(objects);
+		for (Aabb& box : boxes)
+		{
+			glm::vec3 center(position(random), position(random), position(random));
+			glm::vec3 half(0.5f * size(random), 0.5f * size(random), 0.5f * size(random));
+			box = { center - half, center + half };
+		}
+
+		DynamicBVH inserted;
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < objects; i++)
+			inserted.insert(boxes[i], (int)i);
+		double insertMilliseconds = milliseconds(start);
+
+		DynamicBVH bvh;
+		vector<int> leaves;
+		start = Clock::now();
+		bvh.build(boxes, leaves);
+		double buildMilliseconds = milliseconds(start);
+
+		// Recorte: mesma resposta que a busca linear
+		int repetitions = (int)std::max<size_t>(1, 100000 / objects);
+		vector<unsigned char> visible, reference;
+		size_t visibleCount = 0;
+		start = Clock::now();
+		for (int r = 0; r < repetitions; r++)
+			visibleCount = bvh.cull(frustum, visible);
+		double cullMilliseconds = milliseconds(start) / repetitions;
+		start = Clock::now();
+		for (int r = 0; r < repetitions; r++)
+			linearCull(boxes, frustum, reference);
+		double linearCullMilliseconds = milliseconds(start) / repetitions;
+		bool same = visible == reference;
+
+		// Raios da câmera em direções aleatórias: mesma distância do acerto mais próximo
+		vector<glm::vec3> directions(rays);
+		for (glm::vec3& direction : directions)
+			direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+		vector<DynamicBVH::RayHit> hits(rays);
+		start = Clock::now();
+		for (int r = 0; r < rays; r++)
+			hits[r] = bvh.raycast(glm::vec3(0.0f), directions[r], rayDistance);
+		double rayMilliseconds = milliseconds(start);
+		start = Clock::now();
+		for (int r = 0; r < rays; r++)
+		{
+			DynamicBVH::RayHit expected = linearRaycast(boxes, glm::vec3(0.0f), directions[r], rayDistance);
+			same = same && (expected.object >= 0) == (hits[r].object >= 0) && (expected.object < 0 || expected.distance == hits[r].distance);
+		}
+		double linearRayMilliseconds = milliseconds(start);
+
+		// 10% se deslocam um pouco (move) e outros 10% mudam a caixa no lugar (refit)
+		size_t tenth = std::max<size_t>(1, objects / 10);
+		size_t reinsertedBefore = 0;
+		start = Clock::now();
+		for (size_t i = 0; i < tenth; i++)
+		{
+			Aabb& box = boxes[i];
+			glm::vec3 step = 0.25f * side * glm::vec3(unit(random), unit(random), unit(random));
+			box = { box.min + step, box.max + step };
+			reinsertedBefore += bvh.move(leaves[i], box) ? 1 : 0;
+		}
+		double moveMilliseconds = milliseconds(start);
+		start = Clock::now();
+		for (size_t i = tenth; i < 2 * tenth && i < objects; i++)
+		{
+			Aabb& box = boxes[i];
+			glm::vec3 center = 0.5f * (box.min + box.max), half = 0.5f * (box.max - box.min) * (1.0f + 0.1f * unit(random));
+			box = { center - half, center + half };
+			bvh.refit(leaves[i], box);
+		}
+		bvh.refitPending();
+		double refitMilliseconds = milliseconds(start);
+
+		bvh.cull(frustum, visible);
+		linearCull(boxes, frustum, reference);
+		same = same && visible == reference;
+
+		cout << setw(9) << objects << fixed << setprecision(3) << setw(10) << insertMilliseconds << setprecision(1) << setw(8) << inserted.areaCost()
+			<< setprecision(3) << setw(12) << buildMilliseconds << setprecision(1) << setw(8) << bvh.areaCost() << setw(8) << bvh.height() << setprecision(3) << setw(10) << cullMilliseconds << setw(10) << linearCullMilliseconds
+			<< setw(10) << visibleCount << setw(10) << rayMilliseconds << setw(10) << linearRayMilliseconds << setw(10) << moveMilliseconds
+			<< setw(12) << reinsertedBefore << setw(10) << refitMilliseconds << setw(8) << (same ? "sim" : "NAO") << endl;
+		cout << defaultfloat << setprecision(6);
+	}
+}
@@ -0,0 +1,74 @@
+#include "FrameUniforms.h"
+
+#include <iostream>
+
+using namespace std;
+
+FrameUniforms::~FrameUniforms()
+{
+	if (buffer != 0)
+		cout << "Uniform buffer do frame ainda alocado ao final" << endl;
+}
+
+void FrameUniforms::initialize()
+{
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), &data, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, buffer);
+}
+
+void FrameUniforms::shutdown()
+{
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+bool FrameUniforms::attach(const Shader& shader) const
+{
+	GLuint block = glGetUniformBlockIndex(shader.ID, "FrameData");
+	if (block == GL_INVALID_INDEX)
+	{
+		cout << "Bloco FrameData nao encontrado no programa " << shader.ID << endl;
+		return false;
+	}
+
+	GLint size = 0;
+	glGetActiveUniformBlockiv(shader.ID, block, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+	if (size != (GLint)sizeof(FrameData))
+	{
+		cout << "Bloco FrameData do programa " << shader.ID << " tem " << size << " bytes (esperado: " << sizeof(FrameData) << ")" << endl;
+		return false;
+	}
+
+	glUniformBlockBinding(shader.ID, block, FRAME_UNIFORMS_BINDING);
+	return true;
+}
+
+void FrameUniforms::setProjection(const glm::mat4& projection)
+{
+	data.projection = projection;
+	data.viewProjection = projection * data.view;
+}
+
+void FrameUniforms::setCamera(const glm::mat4& view, const glm::vec3& position)
+{
+	data.view = view;
+	data.viewProjection = data.projection * view;
+	data.cameraPos = glm::vec4(position, 1.0f);
+}
+
+void FrameUniforms::setLight(const glm::vec3& position, const glm::vec3& color)
+{
+	data.lightPos = glm::vec4(position, 1.0f);
+	data.lightColor = glm::vec4(color, 1.0f);
+}
+
+void FrameUniforms::upload()
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
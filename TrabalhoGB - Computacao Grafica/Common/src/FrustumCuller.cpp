@@ -0,0 +1,283 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// SSE2/AVX2 por função (target), escolhidos em tempo de execução, como no MipChain
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define FRUSTUM_CULLER_X86 1
+#include <immintrin.h>
+#define CULL_TARGET_SSE2 __attribute__((target("sse2")))
+#define CULL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+namespace
+{
+	// Arrays de um teste; os kernels escrevem visible[i] para i < count e retornam os visíveis
+	struct CullInput
+	{
+		const float* boxX;
+		const float* boxY;
+		const float* boxZ;
+		const float* extentX;
+		const float* extentY;
+		const float* extentZ;
+		const float* sphereX;
+		const float* sphereY;
+		const float* sphereZ;
+		const float* radius;
+		size_t count;
+	};
+
+	// As operações seguem a mesma ordem nos três kernels, para o resultado ser idêntico
+	size_t cullScalar(const CullInput& in, const Frustum& frustum, unsigned char* visible)
+	{
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < in.count; i++)
+		{
+			bool outside = false;
+			for (int p = 0; p < 6 && !outside; p++)
+			{
+				const glm::vec4& plane = frustum.planes[p];
+				float sphereDistance = plane.x * in.sphereX[i] + plane.y * in.sphereY[i] + plane.z * in.sphereZ[i] + plane.w;
+				float boxDistance = plane.x * in.boxX[i] + plane.y * in.boxY[i] + plane.z * in.boxZ[i] + plane.w;
+				float boxRadius = std::fabs(plane.x) * in.extentX[i] + std::fabs(plane.y) * in.extentY[i] + std::fabs(plane.z) * in.extentZ[i];
+				outside = sphereDistance < -in.radius[i] || boxDistance < -boxRadius;
+			}
+			visible[i] = outside ? 0 : 1;
+			visibleCount += visible[i];
+		}
+		return visibleCount;
+	}
+
+#ifdef FRUSTUM_CULLER_X86
+	CULL_TARGET_SSE2 size_t cullSSE2(const CullInput& in, const Frustum& frustum, unsigned char* visible)
+	{
+		size_t visibleCount = 0;
+		const __m128 zero = _mm_setzero_ps();
+		for (size_t i = 0; i < in.count; i += 4)
+		{
+			__m128 sx = _mm_loadu_ps(in.sphereX + i), sy = _mm_loadu_ps(in.sphereY + i), sz = _mm_loadu_ps(in.sphereZ + i);
+			__m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(in.radius + i));
+			__m128 bx = _mm_loadu_ps(in.boxX + i), by = _mm_loadu_ps(in.boxY + i), bz = _mm_loadu_ps(in.boxZ + i);
+			__m128 ex = _mm_loadu_ps(in.extentX + i), ey = _mm_loadu_ps(in.extentY + i), ez = _mm_loadu_ps(in.extentZ + i);
+			__m128 outside = zero;
+			for (int p = 0; p < 6; p++)
+			{
+				const glm::vec4& plane = frustum.planes[p];
+				__m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z), d = _mm_set1_ps(plane.w);
+				__m128 ax = _mm_set1_ps(std::fabs(plane.x)), ay = _mm_set1_ps(std::fabs(plane.y)), az = _mm_set1_ps(std::fabs(plane.z));
+
+				__m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sx), _mm_mul_ps(ny, sy)), _mm_mul_ps(nz, sz)), d);
+				__m128 boxDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, bx), _mm_mul_ps(ny, by)), _mm_mul_ps(nz, bz)), d);
+				__m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, ex), _mm_mul_ps(ay, ey)), _mm_mul_ps(az, ez));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(sphereDistance, negativeRadius));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(boxDistance, _mm_sub_ps(zero, boxRadius)));
+			}
+
+			int mask = _mm_movemask_ps(outside);
+			size_t lanes = std::min<size_t>(4, in.count - i);
+			for (size_t lane = 0; lane < lanes; lane++)
+			{
+				visible[i + lane] = ((mask >> lane) & 1) ? 0 : 1;
+				visibleCount += visible[i + lane];
+			}
+		}
+		return visibleCount;
+	}
+
+	CULL_TARGET_AVX2 size_t cullAVX2(const CullInput& in, const Frustum& frustum, unsigned char* visible)
+	{
+		size_t visibleCount = 0;
+		const __m256 zero = _mm256_setzero_ps();
+		for (size_t i = 0; i < in.count; i += 8)
+		{
+			__m256 sx = _mm256_loadu_ps(in.sphereX + i), sy = _mm256_loadu_ps(in.sphereY + i), sz = _mm256_loadu_ps(in.sphereZ + i);
+			__m256 negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(in.radius + i));
+			__m256 bx = _mm256_loadu_ps(in.boxX + i), by = _mm256_loadu_ps(in.boxY + i), bz = _mm256_loadu_ps(in.boxZ + i);
+			__m256 ex = _mm256_loadu_ps(in.extentX + i), ey = _mm256_loadu_ps(in.extentY + i), ez = _mm256_loadu_ps(in.extentZ + i);
+			__m256 outside = zero;
+			for (int p = 0; p < 6; p++)
+			{
+				const glm::vec4& plane = frustum.planes[p];
+				__m256 nx = _mm256_set1_ps(plane.x), ny = _mm256_set1_ps(plane.y), nz = _mm256_set1_ps(plane.z), d = _mm256_set1_ps(plane.w);
+				__m256 ax = _mm256_set1_ps(std::fabs(plane.x)), ay = _mm256_set1_ps(std::fabs(plane.y)), az = _mm256_set1_ps(std::fabs(plane.z));
+
+				__m256 sphereDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, sx), _mm256_mul_ps(ny, sy)), _mm256_mul_ps(nz, sz)), d);
+				__m256 boxDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, bx), _mm256_mul_ps(ny, by)), _mm256_mul_ps(nz, bz)), d);
+				__m256 boxRadius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, ex), _mm256_mul_ps(ay, ey)), _mm256_mul_ps(az, ez));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(sphereDistance, negativeRadius, _CMP_LT_OQ));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(boxDistance, _mm256_sub_ps(zero, boxRadius), _CMP_LT_OQ));
+			}
+
+			int mask = _mm256_movemask_ps(outside);
+			size_t lanes = std::min<size_t>(8, in.count - i);
+			for (size_t lane = 0; lane < lanes; lane++)
+			{
+				visible[i + lane] = ((mask >> lane) & 1) ? 0 : 1;
+				visibleCount += visible[i + lane];
+			}
+		}
+		return visibleCount;
+	}
+#endif
+}
+
+CullSimd bestCullSimd()
+{
+#ifdef FRUSTUM_CULLER_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return CULL_SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return CULL_SIMD_SSE2;
+#endif
+	return CULL_SIMD_SCALAR;
+}
+
+const char* cullSimdName(CullSimd simd)
+{
+	const char* names[] = { "escalar", "SSE2", "AVX2" };
+	return names[simd];
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4& m)
+{
+	// Linhas da matriz (a GLM guarda por coluna: m[coluna][linha])
+	glm::vec4 rows[4];
+	for (int r = 0; r < 4; r++)
+		rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0];
+	frustum.planes[1] = rows[3] - rows[0];
+	frustum.planes[2] = rows[3] + rows[1];
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[3] + rows[2];
+	frustum.planes[5] = rows[3] - rows[2];
+	for (glm::vec4& plane : frustum.planes)
+	{
+		float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f)
+			plane /= length;
+	}
+	return frustum;
+}
+
+void FrustumCuller::resize(size_t objects)
+{
+	size_t capacity = (objects + 7) / 8 * 8;
+	for (vector<float>* array : { &boxX, &boxY, &boxZ, &extentX, &extentY, &extentZ, &sphereX, &sphereY, &sphereZ, &radius })
+		array->resize(capacity, 0.0f);
+	count = objects;
+}
+
+void FrustumCuller::setBounds(size_t index, const glm::mat4& model, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+	const glm::vec3& sphereCenter, float sphereRadius)
+{
+	// Caixa: centro transformado e meia largura pelos valores absolutos da parte 3x3 (Arvo)
+	glm::vec3 center = 0.5f * (boundsMin + boundsMax);
+	glm::vec3 halfSize = 0.5f * (boundsMax - boundsMin);
+	const glm::vec4& column0 = model[0];
+	const glm::vec4& column1 = model[1];
+	const glm::vec4& column2 = model[2];
+	const glm::vec4& column3 = model[3];
+	boxX[index] = column0.x * center.x + column1.x * center.y + column2.x * center.z + column3.x;
+	boxY[index] = column0.y * center.x + column1.y * center.y + column2.y * center.z + column3.y;
+	boxZ[index] = column0.z * center.x + column1.z * center.y + column2.z * center.z + column3.z;
+	extentX[index] = std::fabs(column0.x) * halfSize.x + std::fabs(column1.x) * halfSize.y + std::fabs(column2.x) * halfSize.z;
+	extentY[index] = std::fabs(column0.y) * halfSize.x + std::fabs(column1.y) * halfSize.y + std::fabs(column2.y) * halfSize.z;
+	extentZ[index] = std::fabs(column0.z) * halfSize.x + std::fabs(column1.z) * halfSize.y + std::fabs(column2.z) * halfSize.z;
+
+	// Esfera: o raio cresce pela maior escala entre os eixos (uma raiz só)
+	sphereX[index] = column0.x * sphereCenter.x + column1.x * sphereCenter.y + column2.x * sphereCenter.z + column3.x;
+	sphereY[index] = column0.y * sphereCenter.x + column1.y * sphereCenter.y + column2.y * sphereCenter.z + column3.y;
+	sphereZ[index] = column0.z * sphereCenter.x + column1.z * sphereCenter.y + column2.z * sphereCenter.z + column3.z;
+	float scale0 = column0.x * column0.x + column0.y * column0.y + column0.z * column0.z;
+	float scale1 = column1.x * column1.x + column1.y * column1.y + column1.z * column1.z;
+	float scale2 = column2.x * column2.x + column2.y * column2.y + column2.z * column2.z;
+	radius[index] = sphereRadius * std::sqrt(std::max(scale0, std::max(scale1, scale2)));
+}
+
+size_t FrustumCuller::cull(const Frustum& frustum, vector<unsigned char>& visible, CullSimd simd) const
+{
+	visible.resize(count);
+	CullInput in = { boxX.data(), boxY.data(), boxZ.data(), extentX.data(), extentY.data(), extentZ.data(),
+		sphereX.data(), sphereY.data(), sphereZ.data(), radius.data(), count };
+#ifdef FRUSTUM_CULLER_X86
+	if (simd == CULL_SIMD_AVX2)
+		return cullAVX2(in, frustum, visible.data());
+	if (simd == CULL_SIMD_SSE2)
+		return cullSSE2(in, frustum, visible.data());
+#endif
+	return cullScalar(in, frustum, visible.data());
+}
+
+void benchmarkFrustumCulling(size_t objects, int repetitions)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	// Objetos (caixa de lado 1, esfera de raio 0.8) girados e escalados em um cubo de lado
+	// 400 ao redor da câmera; o tronco é o da cena (39.6 graus, 16:9, de 0.1 a 100)
+	mt19937 random(7);
+	uniform_real_distribution<float> position(-200.0f, 200.0f), scale(0.2f, 3.0f), angle(0.0f, 6.2832f);
+	vector<glm::mat4> models(objects);
+	for (glm::mat4& model : models)
+	{
+		model = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+		model = glm::rotate(model, angle(random), glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f)));
+		model = glm::scale(model, glm::vec3(scale(random)));
+	}
+	glm::mat4 projection = glm::perspective(glm::radians(39.6f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::fromMatrix(projection * view);
+
+	FrustumCuller culler;
+	culler.resize(objects);
+	Clock::time_point start = Clock::now();
+	for (int r = 0; r < repetitions; r++)
+	{
+		for (size_t i = 0; i < objects; i++)
+			culler.setBounds(i, models[i], glm::vec3(-0.5f), glm::vec3(0.5f), glm::vec3(0.0f), 0.8f);
+	}
+	double boundsMilliseconds = chrono::duration<double, milli>(Clock::now() - start).count() / repetitions;
+
+	// Objetos com o centro dentro do tronco (projetado em [-1, 1]) nunca podem ser recortados
+	vector<unsigned char> centerInside(objects);
+	for (size_t i = 0; i < objects; i++)
+	{
+		glm::vec4 clip = projection * view * models[i] * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		centerInside[i] = clip.w > 0.0f && fabs(clip.x) <= clip.w && fabs(clip.y) <= clip.w && fabs(clip.z) <= clip.w;
+	}
+
+	cout << objects << " objetos, limites no mundo (setBounds, escalar): " << fixed << setprecision(3) << boundsMilliseconds << " ms" << endl;
+	cout << left << setw(12) << "Teste" << right << setw(10) << "ms" << setw(12) << "visiveis" << setw(10) << "igual" << setw(14) << "conservador" << endl;
+	vector<unsigned char> reference;
+	CullSimd best = bestCullSimd();
+	for (int simd = CULL_SIMD_SCALAR; simd <= best; simd++)
+	{
+		vector<unsigned char> visible;
+		size_t visibleCount = 0;
+		start = Clock::now();
+		for (int r = 0; r < repetitions; r++)
+			visibleCount = culler.cull(frustum, visible, (CullSimd)simd);
+		double milliseconds = chrono::duration<double, milli>(Clock::now() - start).count() / repetitions;
+		if (simd == CULL_SIMD_SCALAR)
+			reference = visible;
+
+		bool conservative = true;
+		for (size_t i = 0; i < objects && conservative; i++)
+			conservative = !centerInside[i] || visible[i];
+		cout << left << setw(12) << cullSimdName((CullSimd)simd) << right << setw(10) << milliseconds << setw(12) << visibleCount
+			<< setw(10) << (visible == reference ? "sim" : "NAO") << setw(14) << (conservative ? "sim" : "NAO") << endl;
+	}
+	cout << defaultfloat << setprecision(6);
+}
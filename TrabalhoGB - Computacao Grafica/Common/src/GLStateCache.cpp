@@ -0,0 +1,137 @@
+#include "GLStateCache.h"
+
+#include <iomanip>
+
+using namespace std;
+
+void GLStateCache::invalidate()
+{
+	programKnown = false;
+	vertexArrayKnown = false;
+	activeUnitKnown = false;
+	textures.clear();
+	uniforms.clear();
+}
+
+bool GLStateCache::useProgram(GLuint id)
+{
+	if (programKnown && program == id)
+	{
+		counters.skipped++;
+		return false;
+	}
+	glUseProgram(id);
+	programKnown = true;
+	program = id;
+	uniforms.clear();
+	counters.programs++;
+	return true;
+}
+
+bool GLStateCache::bindVertexArray(GLuint vao)
+{
+	if (vertexArrayKnown && vertexArray == vao)
+	{
+		counters.skipped++;
+		return false;
+	}
+	glBindVertexArray(vao);
+	vertexArrayKnown = true;
+	vertexArray = vao;
+	counters.vertexArrays++;
+	return true;
+}
+
+bool GLStateCache::bindTexture(GLenum unit, GLenum target, GLuint texture)
+{
+	TextureBinding* binding = nullptr;
+	for (TextureBinding& known : textures)
+	{
+		if (known.unit == unit && known.target == target)
+		{
+			binding = &known;
+			break;
+		}
+	}
+	if (binding != nullptr && binding->texture == texture)
+	{
+		counters.skipped++;
+		return false;
+	}
+
+	if (!activeUnitKnown || activeUnit != unit)
+	{
+		glActiveTexture(unit);
+		activeUnitKnown = true;
+		activeUnit = unit;
+		counters.activeUnits++;
+	}
+	glBindTexture(target, texture);
+	if (binding == nullptr)
+		textures.push_back({ unit, target, texture });
+	else
+		binding->texture = texture;
+	counters.textures++;
+	return true;
+}
+
+bool GLStateCache::changeUniform(GLint location, const float* values, int count)
+{
+	if (location < 0)
+		return false;
+	if ((size_t)location >= uniforms.size())
+		uniforms.resize(location + 1);
+
+	UniformValue& known = uniforms[location];
+	bool same = known.known;
+	for (int i = 0; same && i < count; i++)
+		same = known.values[i] == values[i];
+	if (same)
+	{
+		counters.skipped++;
+		return false;
+	}
+	known.known = true;
+	for (int i = 0; i < count; i++)
+		known.values[i] = values[i];
+	counters.uniforms++;
+	return true;
+}
+
+bool GLStateCache::set(const UniformInt& uniform, int value)
+{
+	// Inteiros de sampler e de índice cabem exatamente em um float
+	float asFloat = (float)value;
+	if (!changeUniform(uniform.location, &asFloat, 1))
+		return false;
+	uniform.set(value);
+	return true;
+}
+
+bool GLStateCache::set(const UniformFloat& uniform, float value)
+{
+	if (!changeUniform(uniform.location, &value, 1))
+		return false;
+	uniform.set(value);
+	return true;
+}
+
+bool GLStateCache::set(const UniformVec3& uniform, const float* value)
+{
+	if (!changeUniform(uniform.location, value, 3))
+		return false;
+	uniform.set(value);
+	return true;
+}
+
+void GLStateCache::report(ostream& out) const
+{
+	if (counters.frames == 0)
+		return;
+
+	double frames = (double)counters.frames;
+	out << fixed << setprecision(0) << "Estado por frame: " << counters.changes() / frames << " troca(s) (programa "
+		<< counters.programs / frames << ", VAO " << counters.vertexArrays / frames << ", unidade " << counters.activeUnits / frames
+		<< ", textura " << counters.textures / frames << ", uniform " << counters.uniforms / frames << "), "
+		<< counters.skipped / frames << " evitada(s)" << defaultfloat << setprecision(6) << endl;
+}
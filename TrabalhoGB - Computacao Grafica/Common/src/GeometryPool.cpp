@@ -0,0 +1,136 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+GeometryPool::GeometryPool(size_t blockVertexBytes, size_t blockIndexBytes)
+	: blockVertexBytes(blockVertexBytes), blockIndexBytes(blockIndexBytes)
+{
+}
+
+GeometryPool::~GeometryPool()
+{
+	if (!blocks.empty())
+		cout << blocks.size() << " bloco(s) de geometria ainda alocado(s) ao final" << endl;
+}
+
+GeometryPool::Block& GeometryPool::createBlock(const MeshLayout& layout, size_t vertexBytes, size_t indexBytes)
+{
+	blocks.emplace_back();
+	Block& block = blocks.back();
+	block.format = layout.format;
+	block.texCoordType = layout.texCoordType;
+	// Múltiplo do tamanho do vértice, para o baseVertex ser inteiro
+	GLsizei stride = vertexStride(layout.format);
+	block.vertexCapacity = std::max(blockVertexBytes, vertexBytes) / stride * stride;
+	block.indexCapacity = std::max(blockIndexBytes, indexBytes);
+
+	glGenVertexArrays(1, &block.vao);
+	glBindVertexArray(block.vao);
+
+	glGenBuffers(1, &block.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, block.vbo);
+	glBufferData(GL_ARRAY_BUFFER, block.vertexCapacity, nullptr, GL_STATIC_DRAW);
+	setupVertexAttributes(layout);
+
+	// O buffer de índices fica registrado no VAO
+	glGenBuffers(1, &block.ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, block.ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, block.indexCapacity, nullptr, GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return block;
+}
+
+GeometryPool::Allocation GeometryPool::add(const MeshLayout& layout, const void* vertexData, size_t vertexBytes, const void* indexData, size_t indexBytes)
+{
+	// Índices de 32 bits: os de 16 bits são ampliados e as malhas não indexadas ganham 0, 1, 2...
+	vector<uint32_t> indices;
+	if (layout.indexCount > 0 && layout.indexType == GL_UNSIGNED_SHORT)
+	{
+		const uint16_t* source = static_cast<const uint16_t*>(indexData);
+		indices.assign(source, source + layout.indexCount);
+	}
+	else if (layout.indexCount == 0)
+	{
+		indices.resize(layout.vertexCount);
+		for (GLsizei i = 0; i < layout.vertexCount; i++)
+			indices[i] = (uint32_t)i;
+	}
+	const void* indexSource = indices.empty() ? indexData : indices.data();
+	size_t indexSize = indices.empty() ? indexBytes : indices.size() * sizeof(uint32_t);
+
+	Block* target = nullptr;
+	for (Block& block : blocks)
+	{
+		if (block.format == layout.format && block.texCoordType == layout.texCoordType &&
+			block.vertexUsed + vertexBytes <= block.vertexCapacity && block.indexUsed + indexSize <= block.indexCapacity)
+		{
+			target = &block;
+			break;
+		}
+	}
+	if (target == nullptr)
+		target = &createBlock(layout, vertexBytes, indexSize);
+
+	Allocation allocation;
+	allocation.vao = target->vao;
+	allocation.block = (int)(target - blocks.data());
+	allocation.baseVertex = (GLint)(target->vertexUsed / vertexStride(layout.format));
+	allocation.firstIndex = (GLuint)(target->indexUsed / sizeof(uint32_t));
+	allocation.indexCount = (GLsizei)(indexSize / sizeof(uint32_t));
+
+	// Cópia pelos alvos de cópia, sem mexer no GL_ELEMENT_ARRAY_BUFFER do VAO vinculado
+	glBindBuffer(GL_COPY_WRITE_BUFFER, target->vbo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, target->vertexUsed, vertexBytes, vertexData);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, target->ebo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, target->indexUsed, indexSize, indexSource);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	target->vertexUsed += vertexBytes;
+	target->indexUsed += indexSize;
+	target->meshes++;
+	return allocation;
+}
+
+size_t GeometryPool::usedBytes() const
+{
+	size_t total = 0;
+	for (const Block& block : blocks)
+		total += block.vertexUsed + block.indexUsed;
+	return total;
+}
+
+size_t GeometryPool::capacityBytes() const
+{
+	size_t total = 0;
+	for (const Block& block : blocks)
+		total += block.vertexCapacity + block.indexCapacity;
+	return total;
+}
+
+void GeometryPool::clear()
+{
+	for (Block& block : blocks)
+	{
+		glDeleteVertexArrays(1, &block.vao);
+		glDeleteBuffers(1, &block.vbo);
+		glDeleteBuffers(1, &block.ebo);
+	}
+	blocks.clear();
+}
+
+void GeometryPool::report(ostream& out) const
+{
+	if (blocks.empty())
+		return;
+
+	int meshes = 0;
+	for (const Block& block : blocks)
+		meshes += block.meshes;
+	out << "Pool de geometria: " << meshes << " malha(s) em " << blocks.size() << " bloco(s), "
+		<< usedBytes() / 1024 << " KB usados de " << capacityBytes() / 1024 << " KB" << endl;
+}
@@ -0,0 +1,112 @@
+#include "IndirectDraw.h"
+
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+	typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+	MultiDrawElementsIndirectProc multiDrawElementsIndirect = nullptr;
+}
+
+bool loadMultiDrawIndirect(GLADloadproc load)
+{
+	multiDrawElementsIndirect = (MultiDrawElementsIndirectProc)load("glMultiDrawElementsIndirect");
+	return multiDrawElementsIndirect != nullptr;
+}
+
+bool hasMultiDrawIndirect()
+{
+	return multiDrawElementsIndirect != nullptr;
+}
+
+IndirectDrawBuffer::~IndirectDrawBuffer()
+{
+	if (buffer != 0)
+		cout << "Buffer de comandos indiretos ainda alocado ao final" << endl;
+}
+
+void IndirectDrawBuffer::initialize()
+{
+	glGenBuffers(1, &buffer);
+}
+
+void IndirectDrawBuffer::shutdown()
+{
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+void IndirectDrawBuffer::upload(const vector<DrawElementsIndirectCommand>& commands)
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectDrawBuffer::draw(size_t first, size_t count) const
+{
+	if (count == 0 || multiDrawElementsIndirect == nullptr)
+		return;
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+	const char* offset = (const char*)(first * sizeof(DrawElementsIndirectCommand));
+	multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, (GLsizei)count, sizeof(DrawElementsIndirectCommand));
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+MaterialTable::~MaterialTable()
+{
+	if (buffer != 0)
+		cout << "Tabela de materiais ainda alocada ao final" << endl;
+}
+
+void MaterialTable::initialize()
+{
+	glGenBuffers(1, &buffer);
+	glGenTextures(1, &texture);
+}
+
+void MaterialTable::shutdown()
+{
+	if (buffer != 0)
+	{
+		glDeleteTextures(1, &texture);
+		glDeleteBuffers(1, &buffer);
+	}
+	buffer = 0;
+	texture = 0;
+}
+
+int MaterialTable::add(const glm::vec3& ka, const glm::vec3& kd, const glm::vec3& ks)
+{
+	glm::vec4 material[TEXELS_PER_MATERIAL] = { glm::vec4(ka, 0.0f), glm::vec4(kd, 0.0f), glm::vec4(ks, 0.0f) };
+	for (size_t i = 0; i < texels.size(); i += TEXELS_PER_MATERIAL)
+	{
+		if (texels[i] == material[0] && texels[i + 1] == material[1] && texels[i + 2] == material[2])
+			return (int)(i / TEXELS_PER_MATERIAL);
+	}
+	texels.insert(texels.end(), material, material + TEXELS_PER_MATERIAL);
+	return (int)size() - 1;
+}
+
+void MaterialTable::upload()
+{
+	if (texels.empty())
+		return;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::vec4), texels.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void MaterialTable::bind(GLenum unit) const
+{
+	glActiveTexture(unit);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+}
@@ -0,0 +1,68 @@
+#include "InstanceBuffer.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+InstanceBuffer::~InstanceBuffer()
+{
+	if (buffer != 0)
+		cout << "Buffer de instancias ainda alocado ao final" << endl;
+}
+
+void InstanceBuffer::initialize()
+{
+	glGenBuffers(1, &buffer);
+}
+
+void InstanceBuffer::shutdown()
+{
+	if (buffer != 0)
+		glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	capacity = 0;
+}
+
+void InstanceBuffer::upload(const vector<InstanceData>& instances)
+{
+	size_t bytes = instances.size() * sizeof(InstanceData);
+	if (bytes == 0)
+		return;
+
+	// Cresce em potências de 2 para não realocar a cada objeto novo
+	if (bytes > capacity)
+	{
+		capacity = std::max(capacity, (size_t)64 * sizeof(InstanceData));
+		while (capacity < bytes)
+			capacity *= 2;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::point(size_t first) const
+{
+	const GLsizei stride = sizeof(InstanceData);
+	size_t base = first * sizeof(InstanceData);
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	// mat4: uma coluna por localização
+	for (GLuint column = 0; column < 4; column++)
+	{
+		GLuint location = INSTANCE_ATTRIBUTE_MODEL + column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(base + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+	glVertexAttribPointer(INSTANCE_ATTRIBUTE_SCALE, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(base + offsetof(InstanceData, posScale)));
+	glVertexAttribDivisor(INSTANCE_ATTRIBUTE_SCALE, 1);
+	glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_SCALE);
+	glVertexAttribPointer(INSTANCE_ATTRIBUTE_OFFSET, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(base + offsetof(InstanceData, posOffset)));
+	glVertexAttribDivisor(INSTANCE_ATTRIBUTE_OFFSET, 1);
+	glEnableVertexAttribArray(INSTANCE_ATTRIBUTE_OFFSET);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,107 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& filePath)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	length = (size_t)fileSize.QuadPart;
+	opened = true;
+
+	// Arquivo vazio não pode ser mapeado, mas é um arquivo válido
+	if (length == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (ptr == nullptr)
+	{
+		close();
+		return false;
+	}
+#else
+	int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	length = (size_t)st.st_size;
+	opened = true;
+
+	if (length > 0)
+	{
+		void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			::close(fd);
+			length = 0;
+			opened = false;
+			return false;
+		}
+		ptr = (const char*)mapped;
+		madvise(mapped, length, MADV_SEQUENTIAL);
+	}
+
+	// O mapeamento continua válido depois de fechar o descritor
+	::close(fd);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (ptr)
+		UnmapViewOfFile(ptr);
+	if (mappingHandle)
+		CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle)
+		CloseHandle((HANDLE)fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (ptr)
+		munmap((void*)ptr, length);
+#endif
+	ptr = nullptr;
+	length = 0;
+	opened = false;
+}
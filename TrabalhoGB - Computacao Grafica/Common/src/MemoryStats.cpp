@@ -0,0 +1,91 @@
+#include "MemoryStats.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+// Versão 2: GetProcessMemoryInfo vem da kernel32, sem precisar ligar a psapi
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <cstring>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#endif
+
+#ifndef _WIN32
+namespace
+{
+	// Lê um campo "Nome:   123 kB" de /proc/self/status
+	size_t readStatusKilobytes(const char* field)
+	{
+		FILE* status = fopen("/proc/self/status", "r");
+		if (status == NULL)
+			return 0;
+
+		size_t fieldLength = strlen(field);
+		char line[256];
+		size_t kilobytes = 0;
+		while (fgets(line, sizeof(line), status))
+		{
+			if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':')
+			{
+				sscanf(line + fieldLength + 1, "%zu", &kilobytes);
+				break;
+			}
+		}
+		fclose(status);
+		return kilobytes * 1024;
+	}
+}
+#endif
+
+size_t currentRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.WorkingSetSize;
+#else
+	return readStatusKilobytes("VmRSS");
+#endif
+}
+
+size_t peakRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	return readStatusKilobytes("VmHWM");
+#endif
+}
+
+bool resetPeakRSS()
+{
+#ifdef _WIN32
+	return false;
+#else
+	// Linux 4.0+: escrever "5" em clear_refs reinicia o VmHWM
+	FILE* clearRefs = fopen("/proc/self/clear_refs", "w");
+	if (clearRefs == NULL)
+		return false;
+	bool reset = fputs("5", clearRefs) >= 0;
+	reset = (fclose(clearRefs) == 0) && reset;
+	return reset;
+#endif
+}
+
+void releaseFreeMemory()
+{
+#if defined(_WIN32)
+	HeapCompact(GetProcessHeap(), 0);
+#elif defined(__GLIBC__)
+	malloc_trim(0);
+#endif
+}
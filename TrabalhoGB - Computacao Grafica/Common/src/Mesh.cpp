@@ -0,0 +1,189 @@
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include <glm/gtc/packing.hpp>
+
+using namespace std;
+
+namespace
+{
+	// Layout do formato compacto (16 bytes por vértice)
+	struct PackedVertex
+	{
+		GLushort position[4];  // x, y, z normalizados na caixa envolvente + preenchimento
+		GLuint texCoord;       // s, t em unorm16 ou half float
+		GLuint normal;         // GL_INT_2_10_10_10_REV normalizado
+	};
+
+	static_assert(sizeof(PackedVertex) == 16, "PackedVertex deve ter 16 bytes");
+
+	template <typename T>
+	void copyToBytes(const vector<T>& source, vector<unsigned char>& bytes)
+	{
+		bytes.resize(source.size() * sizeof(T));
+		if (!source.empty())
+			memcpy(bytes.data(), source.data(), bytes.size());
+	}
+}
+
+GLsizei MeshLayout::baseElementCount() const
+{
+	if (!lods.empty())
+		return (GLsizei)lods[0].first;
+	return indexCount > 0 ? indexCount : vertexCount;
+}
+
+GLsizei vertexStride(VertexFormat format)
+{
+	if (format == VERTEX_FORMAT_PACKED)
+		return sizeof(PackedVertex);
+	return OBJ_FLOATS_PER_VERTEX * sizeof(GLfloat);
+}
+
+VertexFormat vertexFormatFromString(const string& name)
+{
+	if (name == "float")
+		return VERTEX_FORMAT_FLOAT;
+	return VERTEX_FORMAT_PACKED;
+}
+
+void buildMeshBuffers(const MeshData& mesh, VertexFormat format, MeshBuffers& buffers)
+{
+	const size_t nVertices = mesh.vertexCount();
+	const float* v = mesh.vertices.data();
+
+	MeshLayout& layout = buffers.layout;
+	layout = MeshLayout();
+	layout.format = format;
+	layout.vertexCount = (GLsizei)nVertices;
+	layout.submeshes = mesh.submeshes;
+
+	// Caixa envolvente (quantização das posições e tamanho do objeto na tela) e faixa
+	// das coordenadas de textura
+	glm::vec3 minPos(0.0f), maxPos(0.0f);
+	bool texCoordsInUnitRange = true;
+	for (size_t i = 0; i < nVertices; i++)
+	{
+		const float* vertex = v + i * OBJ_FLOATS_PER_VERTEX;
+		glm::vec3 p(vertex[0], vertex[1], vertex[2]);
+		minPos = (i == 0) ? p : glm::min(minPos, p);
+		maxPos = (i == 0) ? p : glm::max(maxPos, p);
+		if (vertex[6] < 0.0f || vertex[6] > 1.0f || vertex[7] < 0.0f || vertex[7] > 1.0f)
+			texCoordsInUnitRange = false;
+	}
+	layout.boundsMin = minPos;
+	layout.boundsMax = maxPos;
+
+	glm::vec3 center = 0.5f * (minPos + maxPos);
+	float radiusSquared = 0.0f;
+	for (size_t i = 0; i < nVertices; i++)
+	{
+		const float* vertex = v + i * OBJ_FLOATS_PER_VERTEX;
+		glm::vec3 d = glm::vec3(vertex[0], vertex[1], vertex[2]) - center;
+		radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+	}
+	layout.sphereCenter = center;
+	layout.sphereRadius = std::sqrt(radiusSquared);
+
+	if (format == VERTEX_FORMAT_FLOAT)
+	{
+		copyToBytes(mesh.vertices, buffers.vertexData);
+	}
+	else
+	{
+		glm::vec3 extent = maxPos - minPos;
+		for (int c = 0; c < 3; c++)
+		{
+			if (extent[c] <= 0.0f)
+				extent[c] = 1.0f;
+		}
+		layout.posScale = extent;
+		layout.posOffset = minPos;
+
+		// unorm16 tem mais precisão em [0,1]; fora disso (GL_REPEAT) usa half float
+		layout.texCoordType = texCoordsInUnitRange ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+
+		vector<PackedVertex> packed(nVertices);
+		for (size_t i = 0; i < nVertices; i++)
+		{
+			const float* vertex = v + i * OBJ_FLOATS_PER_VERTEX;
+			glm::vec3 p = (glm::vec3(vertex[0], vertex[1], vertex[2]) - minPos) / extent;
+			glm::u16vec4 q = glm::u16vec4(glm::round(glm::clamp(glm::vec4(p, 0.0f), 0.0f, 1.0f) * 65535.0f));
+			packed[i].position[0] = q.x;
+			packed[i].position[1] = q.y;
+			packed[i].position[2] = q.z;
+			packed[i].position[3] = 0;
+
+			glm::vec2 st(vertex[6], vertex[7]);
+			packed[i].texCoord = texCoordsInUnitRange ? glm::packUnorm2x16(st) : glm::packHalf2x16(st);
+
+			glm::vec3 n(vertex[8], vertex[9], vertex[10]);
+			float length = glm::length(n);
+			if (length > 0.0f)
+				n /= length;
+			packed[i].normal = glm::packSnorm3x10_1x2(glm::vec4(n, 0.0f));
+		}
+		copyToBytes(packed, buffers.vertexData);
+	}
+
+	layout.indexCount = (GLsizei)mesh.indices.size();
+	buffers.indexData.clear();
+	if (!mesh.indices.empty())
+	{
+		// Índices de 16 bits quando todos os vértices cabem, economizando metade do buffer
+		if (nVertices <= 65536)
+		{
+			vector<GLushort> shortIndices(mesh.indices.begin(), mesh.indices.end());
+			copyToBytes(shortIndices, buffers.indexData);
+			layout.indexType = GL_UNSIGNED_SHORT;
+		}
+		else
+		{
+			copyToBytes(mesh.indices, buffers.indexData);
+			layout.indexType = GL_UNSIGNED_INT;
+		}
+	}
+}
+
+void setupVertexAttributes(const MeshLayout& layout)
+{
+	GLsizei stride = vertexStride(layout.format);
+
+	if (layout.format == VERTEX_FORMAT_FLOAT)
+	{
+		//Atributo posição (x, y, z)
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+		glEnableVertexAttribArray(0);
+
+		//Atributo cor (r, g, b) - mantido no buffer, o phong.vs não usa
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(3 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(1);
+
+		//Atributo coordenada de textura - s, t
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(6 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(2);
+
+		//Atributo vetor normal - x, y, z
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(8 * sizeof(GLfloat)));
+		glEnableVertexAttribArray(3);
+	}
+	else
+	{
+		//Atributo posição quantizada em [0,1], desquantizada no shader
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (GLvoid*)offsetof(PackedVertex, position));
+		glEnableVertexAttribArray(0);
+
+		//Atributo coordenada de textura - s, t
+		GLboolean normalized = (layout.texCoordType == GL_UNSIGNED_SHORT) ? GL_TRUE : GL_FALSE;
+		glVertexAttribPointer(2, 2, layout.texCoordType, normalized, stride, (GLvoid*)offsetof(PackedVertex, texCoord));
+		glEnableVertexAttribArray(2);
+
+		//Atributo vetor normal - tipos empacotados exigem 4 componentes
+		glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (GLvoid*)offsetof(PackedVertex, normal));
+		glEnableVertexAttribArray(3);
+	}
+}
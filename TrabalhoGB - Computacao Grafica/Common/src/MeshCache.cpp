@@ -0,0 +1,403 @@
+#include "MeshCache.h"
+#include "MemoryStats.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+	const char MESH_CACHE_MAGIC[8] = { 'C', 'G', 'M', 'E', 'S', 'H', 0, 0 };
+
+	// Cabeçalho do arquivo; os dados começam em offsets alinhados a 16 bytes.
+	// A tabela de trechos de material vem no fim: por trecho, first, count e o
+	// tamanho do nome (uint32) seguidos do nome. Depois dos trechos do nível 0 vem
+	// cada nível de detalhe: erro (float), first, count e quantidade de trechos
+	// (uint32) seguidos dos seus trechos
+	struct MeshCacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t optionsKey;
+		uint64_t sourceHash;
+		uint64_t sourceSize;
+		uint32_t format;
+		uint32_t texCoordType;
+		uint32_t indexType;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t submeshCount;
+		uint32_t lodCount;
+		float posScale[3];
+		float posOffset[3];
+		float boundsMin[3];
+		float boundsMax[3];
+		float boundingSphere[4];  // centro e raio
+		uint32_t padding;
+		uint64_t vertexOffset;
+		uint64_t vertexBytes;
+		uint64_t indexOffset;
+		uint64_t indexBytes;
+		uint64_t submeshOffset;
+		uint64_t submeshBytes;
+	};
+
+	static_assert(sizeof(MeshCacheHeader) == 176, "MeshCacheHeader mudou de tamanho: incremente MESH_CACHE_VERSION");
+
+	inline uint64_t alignTo16(uint64_t value)
+	{
+		return (value + 15) & ~(uint64_t)15;
+	}
+
+	void writeSubMeshes(const vector<SubMesh>& submeshes, vector<unsigned char>& bytes)
+	{
+		for (const SubMesh& submesh : submeshes)
+		{
+			uint32_t fields[3] = { submesh.first, submesh.count, (uint32_t)submesh.material.size() };
+			bytes.insert(bytes.end(), (const unsigned char*)fields, (const unsigned char*)(fields + 3));
+			bytes.insert(bytes.end(), submesh.material.begin(), submesh.material.end());
+		}
+	}
+
+	bool readSubMeshes(const unsigned char*& p, const unsigned char* end, uint32_t count, vector<SubMesh>& submeshes)
+	{
+		submeshes.clear();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t fields[3];
+			if (end - p < (ptrdiff_t)sizeof(fields))
+				return false;
+			memcpy(fields, p, sizeof(fields));
+			p += sizeof(fields);
+			if ((uint64_t)(end - p) < fields[2])
+				return false;
+			submeshes.push_back({ string((const char*)p, fields[2]), fields[0], fields[1] });
+			p += fields[2];
+		}
+		return true;
+	}
+
+	void writeLods(const vector<MeshLod>& lods, vector<unsigned char>& bytes)
+	{
+		for (const MeshLod& lod : lods)
+		{
+			uint32_t fields[4];
+			memcpy(&fields[0], &lod.error, sizeof(float));
+			fields[1] = lod.first;
+			fields[2] = lod.count;
+			fields[3] = (uint32_t)lod.submeshes.size();
+			bytes.insert(bytes.end(), (const unsigned char*)fields, (const unsigned char*)(fields + 4));
+			writeSubMeshes(lod.submeshes, bytes);
+		}
+	}
+
+	bool readLods(const unsigned char*& p, const unsigned char* end, uint32_t count, vector<MeshLod>& lods)
+	{
+		lods.clear();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t fields[4];
+			if (end - p < (ptrdiff_t)sizeof(fields))
+				return false;
+			memcpy(fields, p, sizeof(fields));
+			p += sizeof(fields);
+			MeshLod lod;
+			memcpy(&lod.error, &fields[0], sizeof(float));
+			lod.first = fields[1];
+			lod.count = fields[2];
+			if (!readSubMeshes(p, end, fields[3], lod.submeshes))
+				return false;
+			lods.push_back(lod);
+		}
+		return true;
+	}
+
+	// Trecho [offset, offset + bytes) dentro do arquivo, sem estourar a soma
+	bool fitsInFile(uint64_t offset, uint64_t bytes, uint64_t fileSize)
+	{
+		return bytes <= fileSize && offset <= fileSize - bytes;
+	}
+
+	bool rangesFit(const vector<SubMesh>& submeshes, uint64_t elementCount)
+	{
+		for (const SubMesh& submesh : submeshes)
+		{
+			if ((uint64_t)submesh.first + submesh.count > elementCount)
+				return false;
+		}
+		return true;
+	}
+
+	template <typename Index>
+	bool indicesInRange(const unsigned char* data, size_t count, uint32_t vertexCount)
+	{
+		Index maxIndex = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			Index index;
+			memcpy(&index, data + i * sizeof(Index), sizeof(Index));
+			maxIndex = std::max(maxIndex, index);
+		}
+		return count == 0 || maxIndex < vertexCount;
+	}
+}
+
+uint64_t hashBytes(const void* data, size_t size)
+{
+	// FNV-1a aplicado a palavras de 8 bytes (o hash não pode custar o mesmo que o parsing)
+	const unsigned char* bytes = (const unsigned char*)data;
+	const uint64_t prime = 0x100000001b3ull;
+	uint64_t hash = 0xcbf29ce484222325ull ^ size;
+
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * prime;
+		hash ^= hash >> 32;
+	}
+	for (; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * prime;
+	}
+	return hash;
+}
+
+MeshCacheKey makeMeshCacheKey(const MappedFile& objFile, const OBJLoadOptions& options, MeshOptimization optimization, VertexFormat format, int lodLevels)
+{
+	MeshCacheKey key;
+	key.sourceHash = hashBytes(objFile.data(), objFile.size());
+	key.sourceSize = objFile.size();
+	key.optionsKey = (options.indexed ? 1u : 0u) | (options.groupByMaterial ? 2u : 0u) | ((uint32_t)optimization << 4) | ((uint32_t)format << 8) | ((uint32_t)lodLevels << 12);
+	return key;
+}
+
+string meshCachePath(const string& objPath, const MeshCacheKey& key)
+{
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%04x.meshcache", key.optionsKey);
+	return objPath + suffix;
+}
+
+bool MeshCacheEntry::open(const string& cachePath, const MeshCacheKey& key)
+{
+	if (!file.open(cachePath))
+		return false;
+
+	if (file.size() < sizeof(MeshCacheHeader))
+		return false;
+
+	MeshCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+
+	if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != MESH_CACHE_VERSION ||
+		header.optionsKey != key.optionsKey ||
+		header.sourceHash != key.sourceHash ||
+		header.sourceSize != key.sourceSize)
+		return false;
+
+	// Arquivo danificado com cabeçalho válido: tamanhos coerentes com as quantidades e
+	// índices dentro dos vértices, senão vira falta no cache (e o .obj é lido de novo)
+	if (header.format != VERTEX_FORMAT_FLOAT && header.format != VERTEX_FORMAT_PACKED)
+		return false;
+	if (header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT)
+		return false;
+	uint64_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	if (header.vertexBytes != (uint64_t)header.vertexCount * vertexStride((VertexFormat)header.format) ||
+		header.indexBytes != (uint64_t)header.indexCount * indexSize ||
+		header.vertexCount > (uint32_t)std::numeric_limits<GLsizei>::max() ||
+		header.indexCount > (uint32_t)std::numeric_limits<GLsizei>::max())
+		return false;
+
+	if (!fitsInFile(header.vertexOffset, header.vertexBytes, file.size()) ||
+		!fitsInFile(header.indexOffset, header.indexBytes, file.size()) ||
+		!fitsInFile(header.submeshOffset, header.submeshBytes, file.size()))
+		return false;
+
+	const unsigned char* base = (const unsigned char*)file.data();
+	const unsigned char* submeshData = base + header.submeshOffset;
+	const unsigned char* submeshEnd = submeshData + header.submeshBytes;
+	if (!readSubMeshes(submeshData, submeshEnd, header.submeshCount, layout.submeshes) ||
+		!readLods(submeshData, submeshEnd, header.lodCount, layout.lods))
+		return false;
+
+	// Faixas dentro dos índices (ou dos vértices, sem índices); os níveis de detalhe só
+	// existem nas malhas indexadas
+	uint64_t elementCount = header.indexCount > 0 ? header.indexCount : header.vertexCount;
+	if (!rangesFit(layout.submeshes, elementCount) || (header.indexCount == 0 && !layout.lods.empty()))
+		return false;
+	for (const MeshLod& lod : layout.lods)
+	{
+		if ((uint64_t)lod.first + lod.count > elementCount || !rangesFit(lod.submeshes, elementCount))
+			return false;
+	}
+
+	const unsigned char* indices = base + header.indexOffset;
+	bool inRange = header.indexType == GL_UNSIGNED_SHORT ?
+		indicesInRange<GLushort>(indices, header.indexCount, header.vertexCount) :
+		indicesInRange<GLuint>(indices, header.indexCount, header.vertexCount);
+	if (!inRange)
+		return false;
+
+	layout.format = (VertexFormat)header.format;
+	layout.vertexCount = (GLsizei)header.vertexCount;
+	layout.indexCount = (GLsizei)header.indexCount;
+	layout.indexType = (GLenum)header.indexType;
+	layout.texCoordType = (GLenum)header.texCoordType;
+	layout.posScale = glm::vec3(header.posScale[0], header.posScale[1], header.posScale[2]);
+	layout.posOffset = glm::vec3(header.posOffset[0], header.posOffset[1], header.posOffset[2]);
+	layout.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	layout.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	layout.sphereCenter = glm::vec3(header.boundingSphere[0], header.boundingSphere[1], header.boundingSphere[2]);
+	layout.sphereRadius = header.boundingSphere[3];
+
+	vertexData = base + header.vertexOffset;
+	vertexBytes = (size_t)header.vertexBytes;
+	indexData = header.indexBytes > 0 ? base + header.indexOffset : nullptr;
+	indexBytes = (size_t)header.indexBytes;
+	return true;
+}
+
+bool saveMeshCache(const string& cachePath, const MeshCacheKey& key, const MeshBuffers& buffers)
+{
+	const MeshLayout& layout = buffers.layout;
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.optionsKey = key.optionsKey;
+	header.sourceHash = key.sourceHash;
+	header.sourceSize = key.sourceSize;
+	header.format = (uint32_t)layout.format;
+	header.texCoordType = layout.texCoordType;
+	header.indexType = layout.indexType;
+	header.vertexCount = (uint32_t)layout.vertexCount;
+	header.indexCount = (uint32_t)layout.indexCount;
+	header.submeshCount = (uint32_t)layout.submeshes.size();
+	header.lodCount = (uint32_t)layout.lods.size();
+	for (int c = 0; c < 3; c++)
+	{
+		header.posScale[c] = layout.posScale[c];
+		header.posOffset[c] = layout.posOffset[c];
+		header.boundsMin[c] = layout.boundsMin[c];
+		header.boundsMax[c] = layout.boundsMax[c];
+		header.boundingSphere[c] = layout.sphereCenter[c];
+	}
+	header.boundingSphere[3] = layout.sphereRadius;
+	header.vertexOffset = alignTo16(sizeof(header));
+	header.vertexBytes = buffers.vertexData.size();
+	header.indexOffset = alignTo16(header.vertexOffset + header.vertexBytes);
+	header.indexBytes = buffers.indexData.size();
+
+	vector<unsigned char> submeshData;
+	writeSubMeshes(layout.submeshes, submeshData);
+	writeLods(layout.lods, submeshData);
+	header.submeshOffset = alignTo16(header.indexOffset + header.indexBytes);
+	header.submeshBytes = submeshData.size();
+
+	string tempPath = cachePath + ".tmp";
+	{
+		ofstream out(tempPath, ios::binary | ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		const char padding[16] = { 0 };
+		out.write((const char*)&header, sizeof(header));
+		out.write(padding, header.vertexOffset - sizeof(header));
+		out.write((const char*)buffers.vertexData.data(), buffers.vertexData.size());
+		out.write(padding, header.indexOffset - (header.vertexOffset + header.vertexBytes));
+		out.write((const char*)buffers.indexData.data(), buffers.indexData.size());
+		out.write(padding, header.submeshOffset - (header.indexOffset + header.indexBytes));
+		out.write((const char*)submeshData.data(), submeshData.size());
+		if (!out.good())
+			return false;
+	}
+
+	error_code error;
+	filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool prepareMesh(const string& objPath, const OBJLoadOptions& options, MeshOptimization optimization, VertexFormat format, int lodLevels, bool useCache, PreparedMesh& prepared)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	MappedFile objFile;
+	if (!objFile.open(objPath))
+		return false;
+
+	// Procura os buffers já processados no cache; só faz o parsing se não houver entrada válida
+	// (sem índices não há níveis de detalhe: a chave é a mesma de um nível só)
+	if (!options.indexed)
+		lodLevels = 1;
+	MeshCacheKey key = makeMeshCacheKey(objFile, options, optimization, format, lodLevels);
+	string cachePath = meshCachePath(objPath, key);
+
+	prepared.fromCache = useCache && prepared.cacheEntry.open(cachePath, key);
+	if (prepared.fromCache)
+	{
+		prepared.layout = prepared.cacheEntry.layout;
+		prepared.vertexData = prepared.cacheEntry.vertexData;
+		prepared.vertexBytes = prepared.cacheEntry.vertexBytes;
+		prepared.indexData = prepared.cacheEntry.indexData;
+		prepared.indexBytes = prepared.cacheEntry.indexBytes;
+	}
+	else
+	{
+		//Fazer o parsing (arquivo mapeado em memória, sem alocação por linha)
+		MeshData mesh;
+		if (!parseOBJMesh(objFile.begin(), objFile.end(), mesh, options, objPath))
+			return false;
+
+		if (!mesh.indices.empty())
+		{
+			prepared.hasOriginalStats = true;
+			prepared.originalStats = analyzeVertexCache(mesh);
+		}
+		// Níveis de detalhe (índices depois dos do nível 0) e otimização de todos os níveis
+		vector<MeshLod> lods;
+		buildMeshLods(mesh, lodLevels, optimization, lods);
+
+		//Conversão para o layout de vértice escolhido
+		buildMeshBuffers(mesh, format, prepared.buffers);
+		prepared.buffers.layout.lods = lods;
+		// Os dados em float não são mais usados: libera antes de gravar o cache
+		mesh = MeshData();
+
+		prepared.cacheSaveFailed = useCache && !saveMeshCache(cachePath, key, prepared.buffers);
+
+		prepared.layout = prepared.buffers.layout;
+		prepared.vertexData = prepared.buffers.vertexData.data();
+		prepared.vertexBytes = prepared.buffers.vertexData.size();
+		prepared.indexData = prepared.buffers.indexData.data();
+		prepared.indexBytes = prepared.buffers.indexData.size();
+	}
+
+	// Estatísticas da ordem final do nível 0, lidas do próprio buffer de índices (16 ou 32 bits)
+	const MeshLayout& layout = prepared.layout;
+	GLsizei baseIndexCount = layout.indexCount > 0 ? layout.baseElementCount() : 0;
+	if (layout.indexType == GL_UNSIGNED_SHORT)
+		prepared.stats = analyzeVertexCache((const GLushort*)prepared.indexData, baseIndexCount, layout.vertexCount);
+	else
+		prepared.stats = analyzeVertexCache((const GLuint*)prepared.indexData, baseIndexCount, layout.vertexCount);
+
+	prepared.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	prepared.peakRSS = peakRSS();
+	return true;
+}
@@ -0,0 +1,422 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+using namespace std;
+
+namespace
+{
+	// Parâmetros do algoritmo de Forsyth (valores do artigo original)
+	const int FORSYTH_CACHE_SIZE = 32;
+	const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+	const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+	const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+	const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+	// Pontuação de um vértice pela posição no cache (LRU) e triângulos restantes
+	float forsythVertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// Os três vértices do último triângulo têm pontuação fixa, para não
+			// favorecer uma direção na escolha do próximo
+			if (cachePosition < 3)
+			{
+				score = FORSYTH_LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+				score = powf(1.0f - (cachePosition - 3) * scale, FORSYTH_CACHE_DECAY_POWER);
+			}
+		}
+
+		// Vértices com poucos triângulos restantes ganham prioridade, para não ficarem isolados
+		score += FORSYTH_VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	// Posição (só x, y, z) do vértice no buffer intercalado
+	inline glm::vec3 vertexPosition(const MeshData& mesh, unsigned int index)
+	{
+		const float* v = mesh.vertices.data() + (size_t)index * OBJ_FLOATS_PER_VERTEX;
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	// Falhas de cache (FIFO) de um intervalo de triângulos, com o cache vazio no início
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, unsigned int size) : insertedAt(vertexCount, 0), size(size) {}
+
+		void reset() { time += size + 1; }
+
+		// Número de vértices do triângulo que não estavam no cache
+		unsigned int access(const unsigned int* triangle)
+		{
+			unsigned int misses = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = triangle[k];
+				if (insertedAt[v] == 0 || time - insertedAt[v] >= size)
+				{
+					time++;
+					insertedAt[v] = time;
+					misses++;
+				}
+			}
+			return misses;
+		}
+
+	private:
+		vector<unsigned int> insertedAt;
+		unsigned int size;
+		unsigned int time = 1;
+	};
+}
+
+VertexCacheStats analyzeVertexCache(const MeshData& mesh)
+{
+	return analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertexCount());
+}
+
+namespace
+{
+	// Faixas do buffer de índices otimizadas separadamente: um trecho por material,
+	// para que a reordenação nunca misture triângulos de materiais diferentes
+	vector<SubMesh> indexRanges(const MeshData& mesh)
+	{
+		if (!mesh.submeshes.empty())
+			return mesh.submeshes;
+		return { SubMesh{ "", 0, (unsigned int)mesh.indices.size() } };
+	}
+
+	void optimizeVertexCacheRange(unsigned int* rangeIndices, size_t indexCount, size_t nVertices)
+	{
+		const size_t nTriangles = indexCount / 3;
+		if (nTriangles == 0)
+			return;
+		const vector<unsigned int> indices(rangeIndices, rangeIndices + nTriangles * 3);
+
+		// Lista de adjacência vértice -> triângulos; os primeiros remaining[v] de cada
+		// vértice são os triângulos ainda não emitidos
+		vector<unsigned int> remaining(nVertices, 0);
+		for (unsigned int v : indices)
+			remaining[v]++;
+
+		vector<unsigned int> offsets(nVertices + 1, 0);
+		for (size_t v = 0; v < nVertices; v++)
+			offsets[v + 1] = offsets[v] + remaining[v];
+
+		vector<unsigned int> adjacency(indices.size());
+		{
+			vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+				adjacency[cursor[indices[i]]++] = (unsigned int)(i / 3);
+		}
+
+		vector<int> cachePosition(nVertices, -1);
+		vector<float> vertexScore(nVertices);
+		for (size_t v = 0; v < nVertices; v++)
+			vertexScore[v] = forsythVertexScore(-1, remaining[v]);
+
+		vector<float> triangleScore(nTriangles);
+		vector<bool> emitted(nTriangles, false);
+		int bestTriangle = 0;
+		for (size_t t = 0; t < nTriangles; t++)
+		{
+			triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+			if (triangleScore[t] > triangleScore[bestTriangle])
+				bestTriangle = (int)t;
+		}
+
+		vector<unsigned int> result;
+		result.reserve(indices.size());
+
+		// Cache LRU simulado: três posições extras para os vértices que saem a cada passo
+		unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+		unsigned int newCache[FORSYTH_CACHE_SIZE + 3];
+		int cacheCount = 0;
+		size_t deadEndCursor = 0;
+
+		while (bestTriangle >= 0)
+		{
+			const unsigned int* triangle = &indices[3 * (size_t)bestTriangle];
+			emitted[bestTriangle] = true;
+			result.insert(result.end(), triangle, triangle + 3);
+
+			// Os vértices do triângulo vão para o início do cache; os demais são empurrados
+			int newCount = 0;
+			for (int k = 0; k < 3; k++)
+				newCache[newCount++] = triangle[k];
+			for (int i = 0; i < cacheCount; i++)
+			{
+				unsigned int v = cache[i];
+				if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+					newCache[newCount++] = v;
+			}
+
+			// Retira o triângulo das listas de adjacência dos seus vértices
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = triangle[k];
+				unsigned int* begin = &adjacency[offsets[v]];
+				unsigned int* end = begin + remaining[v];
+				unsigned int* found = find(begin, end, (unsigned int)bestTriangle);
+				swap(*found, *(end - 1));
+				remaining[v]--;
+			}
+
+			// Atualiza as pontuações dos vértices que mudaram de posição (inclusive os que saíram)
+			for (int i = 0; i < newCount; i++)
+			{
+				unsigned int v = newCache[i];
+				cachePosition[v] = i < FORSYTH_CACHE_SIZE ? i : -1;
+				float score = forsythVertexScore(cachePosition[v], remaining[v]);
+				float delta = score - vertexScore[v];
+				vertexScore[v] = score;
+
+				const unsigned int* tri = &adjacency[offsets[v]];
+				for (unsigned int j = 0; j < remaining[v]; j++)
+					triangleScore[tri[j]] += delta;
+			}
+
+			// Próximo triângulo: o de maior pontuação entre os que usam vértices do cache
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			cacheCount = min(newCount, FORSYTH_CACHE_SIZE);
+			for (int i = 0; i < cacheCount; i++)
+			{
+				unsigned int v = newCache[i];
+				cache[i] = v;
+				const unsigned int* tri = &adjacency[offsets[v]];
+				for (unsigned int j = 0; j < remaining[v]; j++)
+				{
+					if (triangleScore[tri[j]] > bestScore)
+					{
+						bestScore = triangleScore[tri[j]];
+						bestTriangle = (int)tri[j];
+					}
+				}
+			}
+
+			// Beco sem saída: segue para o próximo triângulo não emitido na ordem original
+			if (bestTriangle < 0)
+			{
+				while (deadEndCursor < nTriangles && emitted[deadEndCursor])
+					deadEndCursor++;
+				if (deadEndCursor < nTriangles)
+					bestTriangle = (int)deadEndCursor;
+			}
+		}
+
+		copy(result.begin(), result.end(), rangeIndices);
+	}
+
+	void optimizeOverdrawRange(const MeshData& mesh, unsigned int* rangeIndices, size_t indexCount, const glm::dvec3& meshCenter, float threshold)
+	{
+		const size_t nVertices = mesh.vertexCount();
+		const size_t nTriangles = indexCount / 3;
+		if (nTriangles == 0)
+			return;
+		const vector<unsigned int> source(rangeIndices, rangeIndices + nTriangles * 3);
+		const unsigned int* indices = source.data();
+
+		// Limites "rígidos": triângulos em que o cache recomeça (três falhas)
+		vector<size_t> hardBoundaries;
+		{
+			FifoCache cache(nVertices, VERTEX_CACHE_SIMULATION_SIZE);
+			for (size_t t = 0; t < nTriangles; t++)
+			{
+				if (cache.access(indices + 3 * t) == 3)
+					hardBoundaries.push_back(t);
+			}
+			hardBoundaries.push_back(nTriangles);
+		}
+
+		// Dentro de cada grupo rígido, novos limites sempre que o ACMR acumulado desde o
+		// último limite não passa de threshold vezes o ACMR do grupo inteiro
+		vector<size_t> clusters;
+		{
+			FifoCache cache(nVertices, VERTEX_CACHE_SIMULATION_SIZE);
+			for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+			{
+				size_t start = hardBoundaries[c], end = hardBoundaries[c + 1];
+
+				cache.reset();
+				unsigned int groupMisses = 0;
+				for (size_t t = start; t < end; t++)
+					groupMisses += cache.access(indices + 3 * t);
+				float limit = threshold * (float)groupMisses / (float)(end - start);
+
+				cache.reset();
+				clusters.push_back(start);
+				unsigned int misses = 0;
+				size_t clusterStart = start;
+				for (size_t t = start; t < end; t++)
+				{
+					misses += cache.access(indices + 3 * t);
+					if (t + 1 < end && (float)misses / (float)(t + 1 - clusterStart) <= limit)
+					{
+						clusters.push_back(t + 1);
+						clusterStart = t + 1;
+						misses = 0;
+						cache.reset();
+					}
+				}
+			}
+			clusters.push_back(nTriangles);
+		}
+
+		// Grupos cuja normal média aponta para fora do centro são desenhados primeiro:
+		// tendem a ficar na frente e ocultar os demais pelo teste de profundidade
+		size_t nClusters = clusters.size() - 1;
+		vector<float> sortKey(nClusters);
+		for (size_t c = 0; c < nClusters; c++)
+		{
+			glm::dvec3 center(0.0), normal(0.0);
+			double area = 0.0;
+			for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+			{
+				glm::vec3 a = vertexPosition(mesh, indices[3 * t]);
+				glm::vec3 b = vertexPosition(mesh, indices[3 * t + 1]);
+				glm::vec3 p = vertexPosition(mesh, indices[3 * t + 2]);
+				glm::dvec3 n = glm::dvec3(glm::cross(b - a, p - a));
+				double triangleArea = glm::length(n);
+				center += glm::dvec3((a + b + p) / 3.0f) * triangleArea;
+				normal += n;
+				area += triangleArea;
+			}
+			if (area > 0.0)
+				center /= area;
+			double length = glm::length(normal);
+			sortKey[c] = length > 0.0 ? (float)glm::dot(center - meshCenter, normal / length) : 0.0f;
+		}
+
+		vector<size_t> order(nClusters);
+		for (size_t c = 0; c < nClusters; c++)
+			order[c] = c;
+		stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+		unsigned int* out = rangeIndices;
+		for (size_t c : order)
+			out = copy(indices + 3 * clusters[c], indices + 3 * clusters[c + 1], out);
+	}
+}
+
+void optimizeVertexCache(MeshData& mesh)
+{
+	for (const SubMesh& range : indexRanges(mesh))
+		optimizeVertexCacheRange(mesh.indices.data() + range.first, range.count, mesh.vertexCount());
+}
+
+void optimizeOverdraw(MeshData& mesh, float threshold)
+{
+	// Centro da malha inteira (média ponderada pela área dos triângulos): a
+	// referência de "para fora" é a mesma em todos os trechos de material
+	const unsigned int* indices = mesh.indices.data();
+	glm::dvec3 meshCenter(0.0);
+	double meshArea = 0.0;
+	for (size_t t = 0; t < mesh.indices.size() / 3; t++)
+	{
+		glm::vec3 a = vertexPosition(mesh, indices[3 * t]);
+		glm::vec3 b = vertexPosition(mesh, indices[3 * t + 1]);
+		glm::vec3 c = vertexPosition(mesh, indices[3 * t + 2]);
+		double area = glm::length(glm::cross(b - a, c - a));
+		meshCenter += glm::dvec3((a + b + c) / 3.0f) * area;
+		meshArea += area;
+	}
+	if (meshArea > 0.0)
+		meshCenter /= meshArea;
+
+	for (const SubMesh& range : indexRanges(mesh))
+		optimizeOverdrawRange(mesh, mesh.indices.data() + range.first, range.count, meshCenter, threshold);
+}
+
+void optimizeVertexFetch(MeshData& mesh)
+{
+	const size_t nVertices = mesh.vertexCount();
+	const unsigned int unused = ~0u;
+
+	vector<unsigned int> remap(nVertices, unused);
+	unsigned int next = 0;
+	for (unsigned int& index : mesh.indices)
+	{
+		if (remap[index] == unused)
+			remap[index] = next++;
+		index = remap[index];
+	}
+
+	vector<float> vertices((size_t)next * OBJ_FLOATS_PER_VERTEX);
+	for (size_t v = 0; v < nVertices; v++)
+	{
+		if (remap[v] == unused)
+			continue;
+		copy_n(mesh.vertices.begin() + v * OBJ_FLOATS_PER_VERTEX, OBJ_FLOATS_PER_VERTEX,
+			vertices.begin() + (size_t)remap[v] * OBJ_FLOATS_PER_VERTEX);
+	}
+	mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(MeshData& mesh, MeshOptimization optimization)
+{
+	if (optimization == MESH_OPTIMIZATION_NONE || mesh.indices.empty())
+		return;
+
+	optimizeVertexCache(mesh);
+	if (optimization == MESH_OPTIMIZATION_OVERDRAW)
+		optimizeOverdraw(mesh);
+	optimizeVertexFetch(mesh);
+}
+
+MeshOptimization meshOptimizationFromString(const string& name)
+{
+	if (name == "none")
+		return MESH_OPTIMIZATION_NONE;
+	if (name == "overdraw")
+		return MESH_OPTIMIZATION_OVERDRAW;
+	return MESH_OPTIMIZATION_VERTEX_CACHE;
+}
+
+void benchmarkMeshOptimizer(const vector<string>& files)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	const char* names[] = { "none", "vertexCache", "overdraw" };
+	cout << left << setw(40) << "Arquivo" << setw(14) << "modo" << right << setw(10) << "triang."
+		<< setw(10) << "ACMR" << setw(10) << "ATVR" << setw(10) << "ms" << endl;
+
+	for (const string& file : files)
+	{
+		MeshData original;
+		if (!loadOBJMesh(file, original))
+		{
+			cout << "Erro ao tentar ler o arquivo " << file << endl;
+			continue;
+		}
+
+		for (int mode = MESH_OPTIMIZATION_NONE; mode <= MESH_OPTIMIZATION_OVERDRAW; mode++)
+		{
+			MeshData mesh = original;
+			Clock::time_point start = Clock::now();
+			optimizeMesh(mesh, (MeshOptimization)mode);
+			double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+
+			VertexCacheStats stats = analyzeVertexCache(mesh);
+			cout << left << setw(40) << (mode == 0 ? file.substr(file.size() > 39 ? file.size() - 39 : 0) : "")
+				<< setw(14) << names[mode] << right << setw(10) << mesh.indices.size() / 3
+				<< fixed << setprecision(3) << setw(10) << stats.acmr << setw(10) << stats.atvr
+				<< setprecision(2) << setw(10) << ms << endl;
+		}
+	}
+}
@@ -0,0 +1,806 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <unordered_set>
+
+#include <glm/glm.hpp>
+
+using namespace std;
+
+namespace
+{
+	// Peso dos planos que seguram bordas, costuras e divisas de material (multiplica o
+	// quadrado do comprimento da aresta, na mesma escala da área dos triângulos)
+	const double FEATURE_WEIGHT = 4.0;
+
+	// Colapso recusado se a normal de algum triângulo girar mais que isso (cosseno)
+	const double MIN_NORMAL_COSINE = 0.25;
+
+	// Um nível só é aceito com no máximo esta fração dos triângulos do anterior
+	const float MIN_LOD_REDUCTION = 0.8f;
+
+	// Matriz simétrica 4x4 dos planos acumulados (a, b, c, d com a² + b² + c² = 1),
+	// ponderados; o erro em um ponto é a soma ponderada das distâncias quadráticas
+	struct Quadric
+	{
+		double a2 = 0.0, b2 = 0.0, c2 = 0.0, ab = 0.0, ac = 0.0, bc = 0.0;
+		double ad = 0.0, bd = 0.0, cd = 0.0, d2 = 0.0;
+		double weight = 0.0;
+
+		void addPlane(const glm::dvec3& n, double d, double w)
+		{
+			a2 += w * n.x * n.x; b2 += w * n.y * n.y; c2 += w * n.z * n.z;
+			ab += w * n.x * n.y; ac += w * n.x * n.z; bc += w * n.y * n.z;
+			ad += w * n.x * d; bd += w * n.y * d; cd += w * n.z * d;
+			d2 += w * d * d;
+			weight += w;
+		}
+
+		void add(const Quadric& o)
+		{
+			a2 += o.a2; b2 += o.b2; c2 += o.c2; ab += o.ab; ac += o.ac; bc += o.bc;
+			ad += o.ad; bd += o.bd; cd += o.cd; d2 += o.d2;
+			weight += o.weight;
+		}
+
+		double error(const glm::dvec3& p) const
+		{
+			double e = a2 * p.x * p.x + b2 * p.y * p.y + c2 * p.z * p.z
+				+ 2.0 * (ab * p.x * p.y + ac * p.x * p.z + bc * p.y * p.z)
+				+ 2.0 * (ad * p.x + bd * p.y + cd * p.z) + d2;
+			return std::max(e, 0.0);
+		}
+	};
+
+	inline uint64_t edgeKey(unsigned int a, unsigned int b)
+	{
+		if (a > b)
+			std::swap(a, b);
+		return ((uint64_t)a << 32) | b;
+	}
+
+	class Simplifier
+	{
+	public:
+		explicit Simplifier(const MeshData& mesh);
+
+		// Colapsa arestas até targetTriangles triângulos (ou até não haver colapso válido)
+		void simplify(size_t targetTriangles);
+
+		size_t liveTriangles() const { return live; }
+
+		// Erro do colapso mais caro feito, relativo ao raio da esfera envolvente
+		float relativeError() const { return radius > 0.0 ? (float)(std::sqrt(maxCost) / radius) : 0.0f; }
+
+		// Triângulos restantes agrupados por material, na ordem original dentro de cada um
+		void output(vector<unsigned int>& indices, vector<SubMesh>& submeshes) const;
+
+	private:
+		struct Candidate
+		{
+			double cost;
+			unsigned int from, to;
+			unsigned int fromVersion, toVersion;
+
+			bool operator>(const Candidate& other) const { return cost > other.cost; }
+		};
+
+		int cornerOf(unsigned int triangle, unsigned int position) const;
+		void neighbours(unsigned int position, vector<unsigned int>& result) const;
+		double evaluate(unsigned int u, unsigned int v);
+		void collapse(unsigned int u, unsigned int v, double cost);
+		void pushEdge(unsigned int a, unsigned int b);
+
+		const MeshData& mesh;
+		vector<SubMesh> ranges;
+
+		// Vértices na mesma posição compartilham um representante (o de menor índice): a
+		// topologia e as quádricas são das posições; os cantos dos triângulos guardam o vértice
+		vector<unsigned int> positionOf;
+		vector<glm::dvec3> positions;         // por representante
+		vector<Quadric> quadrics;             // por representante
+		vector<vector<unsigned int>> around;  // por representante: triângulos (vivos ou não)
+		vector<unsigned int> version;         // muda quando a quádrica do representante muda
+		vector<unsigned char> removed;
+		vector<unsigned char> locked;
+		vector<unsigned char> featureCount;   // arestas de contorno no representante
+
+		vector<unsigned int> corners;         // 3 por triângulo
+		vector<unsigned int> material;        // por triângulo, índice em ranges
+		vector<unsigned char> alive;
+		size_t live = 0;
+
+		unordered_set<uint64_t> features;     // arestas de borda, costura ou divisa de material
+		priority_queue<Candidate, vector<Candidate>, greater<Candidate>> heap;
+		double maxCost = 0.0;
+		double radius = 0.0;
+
+		// Rascunho do evaluate: canto do vértice que sai -> canto do vértice que fica
+		vector<pair<unsigned int, unsigned int>> cornerMap;
+		vector<unsigned int> scratchU, scratchV;
+	};
+
+	Simplifier::Simplifier(const MeshData& mesh) : mesh(mesh)
+	{
+		const size_t nVertices = mesh.vertexCount();
+		const float* v = mesh.vertices.data();
+
+		// Soldagem por posição exata: ordena os vértices por (x, y, z)
+		vector<unsigned int> order(nVertices);
+		for (size_t i = 0; i < nVertices; i++)
+			order[i] = (unsigned int)i;
+		auto position = [v](unsigned int i) { return glm::vec3(v[(size_t)i * OBJ_FLOATS_PER_VERTEX], v[(size_t)i * OBJ_FLOATS_PER_VERTEX + 1], v[(size_t)i * OBJ_FLOATS_PER_VERTEX + 2]); };
+		sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+			glm::vec3 pa = position(a), pb = position(b);
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			if (pa.z != pb.z) return pa.z < pb.z;
+			return a < b;
+		});
+		positionOf.resize(nVertices);
+		for (size_t i = 0; i < nVertices; i++)
+		{
+			bool same = i > 0 && position(order[i]) == position(order[i - 1]);
+			positionOf[order[i]] = same ? positionOf[order[i - 1]] : order[i];
+		}
+
+		positions.resize(nVertices);
+		glm::dvec3 boundsMin(0.0), boundsMax(0.0);
+		for (size_t i = 0; i < nVertices; i++)
+		{
+			positions[i] = glm::dvec3(position((unsigned int)i));
+			boundsMin = i == 0 ? positions[i] : glm::min(boundsMin, positions[i]);
+			boundsMax = i == 0 ? positions[i] : glm::max(boundsMax, positions[i]);
+		}
+		glm::dvec3 center = 0.5 * (boundsMin + boundsMax);
+		for (size_t i = 0; i < nVertices; i++)
+			radius = std::max(radius, glm::length(positions[i] - center));
+
+		quadrics.resize(nVertices);
+		around.resize(nVertices);
+		version.assign(nVertices, 0);
+		removed.assign(nVertices, 0);
+		locked.assign(nVertices, 0);
+		featureCount.assign(nVertices, 0);
+
+		ranges = mesh.submeshes;
+		if (ranges.empty())
+			ranges.push_back(SubMesh{ "", 0, (unsigned int)mesh.indices.size() });
+
+		const size_t nTriangles = mesh.indices.size() / 3;
+		corners.assign(mesh.indices.begin(), mesh.indices.begin() + nTriangles * 3);
+		material.assign(nTriangles, 0);
+		alive.assign(nTriangles, 1);
+		for (size_t r = 0; r < ranges.size(); r++)
+		{
+			for (size_t t = ranges[r].first / 3; t < (ranges[r].first + ranges[r].count) / 3 && t < nTriangles; t++)
+				material[t] = (unsigned int)r;
+		}
+
+		// Planos dos triângulos, ponderados pela área; triângulos com duas posições iguais saem
+		for (size_t t = 0; t < nTriangles; t++)
+		{
+			unsigned int p0 = positionOf[corners[3 * t]], p1 = positionOf[corners[3 * t + 1]], p2 = positionOf[corners[3 * t + 2]];
+			if (p0 == p1 || p1 == p2 || p0 == p2)
+			{
+				alive[t] = 0;
+				continue;
+			}
+			live++;
+			around[p0].push_back((unsigned int)t);
+			around[p1].push_back((unsigned int)t);
+			around[p2].push_back((unsigned int)t);
+
+			glm::dvec3 normal = glm::cross(positions[p1] - positions[p0], positions[p2] - positions[p0]);
+			double length = glm::length(normal);
+			if (length <= 0.0)
+				continue;
+			normal /= length;
+			double d = -glm::dot(normal, positions[p0]);
+			for (unsigned int p : { p0, p1, p2 })
+				quadrics[p].addPlane(normal, d, 0.5 * length);
+		}
+
+		// Arestas de contorno: borda (um triângulo), costura (os dois triângulos usam vértices
+		// diferentes nas duas pontas) ou divisa de material; com mais de dois triângulos a
+		// aresta não é variedade e as pontas ficam presas
+		vector<pair<uint64_t, unsigned int>> edges;
+		edges.reserve(live * 3);
+		for (size_t t = 0; t < nTriangles; t++)
+		{
+			if (!alive[t])
+				continue;
+			for (int k = 0; k < 3; k++)
+				edges.push_back({ edgeKey(positionOf[corners[3 * t + k]], positionOf[corners[3 * t + (k + 1) % 3]]), (unsigned int)t });
+		}
+		sort(edges.begin(), edges.end());
+
+		auto addFeaturePlane = [&](unsigned int t, unsigned int a, unsigned int b) {
+			glm::dvec3 p0 = positions[positionOf[corners[3 * t]]];
+			glm::dvec3 faceNormal = glm::cross(positions[positionOf[corners[3 * t + 1]]] - p0, positions[positionOf[corners[3 * t + 2]]] - p0);
+			glm::dvec3 edge = positions[b] - positions[a];
+			glm::dvec3 normal = glm::cross(edge, faceNormal);
+			double length = glm::length(normal);
+			if (length <= 0.0)
+				return;
+			normal /= length;
+			double d = -glm::dot(normal, positions[a]);
+			double w = FEATURE_WEIGHT * glm::dot(edge, edge);
+			quadrics[a].addPlane(normal, d, w);
+			quadrics[b].addPlane(normal, d, w);
+		};
+
+		for (size_t first = 0; first < edges.size();)
+		{
+			size_t last = first + 1;
+			while (last < edges.size() && edges[last].first == edges[first].first)
+				last++;
+			unsigned int a = (unsigned int)(edges[first].first >> 32);
+			unsigned int b = (unsigned int)(edges[first].first & 0xffffffffu);
+			size_t count = last - first;
+
+			bool feature = false;
+			if (count == 1)
+			{
+				feature = true;
+			}
+			else if (count == 2)
+			{
+				unsigned int t1 = edges[first].second, t2 = edges[first + 1].second;
+				bool splitA = corners[3 * t1 + cornerOf(t1, a)] != corners[3 * t2 + cornerOf(t2, a)];
+				bool splitB = corners[3 * t1 + cornerOf(t1, b)] != corners[3 * t2 + cornerOf(t2, b)];
+				feature = (splitA && splitB) || material[t1] != material[t2];
+			}
+			else
+			{
+				locked[a] = 1;
+				locked[b] = 1;
+			}
+
+			if (feature)
+			{
+				features.insert(edges[first].first);
+				featureCount[a] = (unsigned char)std::min(255, featureCount[a] + 1);
+				featureCount[b] = (unsigned char)std::min(255, featureCount[b] + 1);
+				for (size_t e = first; e < last; e++)
+					addFeaturePlane(edges[e].second, a, b);
+			}
+			first = last;
+		}
+
+		// Pontas de contorno (uma aresta) e encontros de três ou mais não se movem
+		for (size_t p = 0; p < nVertices; p++)
+		{
+			if (featureCount[p] == 1 || featureCount[p] > 2)
+				locked[p] = 1;
+		}
+	}
+
+	int Simplifier::cornerOf(unsigned int triangle, unsigned int position) const
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			if (positionOf[corners[3 * triangle + k]] == position)
+				return k;
+		}
+		return -1;
+	}
+
+	void Simplifier::neighbours(unsigned int position, vector<unsigned int>& result) const
+	{
+		result.clear();
+		for (unsigned int t : around[position])
+		{
+			if (!alive[t])
+				continue;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int p = positionOf[corners[3 * t + k]];
+				if (p != position)
+					result.push_back(p);
+			}
+		}
+		sort(result.begin(), result.end());
+		result.erase(unique(result.begin(), result.end()), result.end());
+	}
+
+	double Simplifier::evaluate(unsigned int u, unsigned int v)
+	{
+		// Custo de levar a posição u até v, ou -1 se o colapso não é permitido
+		if (locked[u])
+			return -1.0;
+		bool featureEdge = features.count(edgeKey(u, v)) > 0;
+		if (featureCount[u] > 0 && !featureEdge)
+			return -1.0;
+
+		// Triângulos da aresta (saem) e canto de u -> canto de v em cada um: um canto de u
+		// vai sempre para o mesmo canto de v, e dois cantos de u nunca se juntam
+		cornerMap.clear();
+		int edgeTriangles = 0;
+		for (unsigned int t : around[u])
+		{
+			if (!alive[t])
+				continue;
+			int cv = cornerOf(t, v);
+			if (cv < 0)
+				continue;
+			edgeTriangles++;
+			unsigned int from = corners[3 * t + cornerOf(t, u)];
+			unsigned int to = corners[3 * t + cv];
+			for (const pair<unsigned int, unsigned int>& known : cornerMap)
+			{
+				if ((known.first == from) != (known.second == to))
+					return -1.0;
+			}
+			cornerMap.push_back({ from, to });
+		}
+		if (edgeTriangles == 0 || edgeTriangles > 2 || (!featureEdge && edgeTriangles != 2))
+			return -1.0;
+
+		// Condição de elo: os vizinhos comuns de u e v são só os terceiros vértices dos
+		// triângulos da aresta (senão o colapso cola duas partes da malha)
+		neighbours(u, scratchU);
+		neighbours(v, scratchV);
+		size_t common = 0;
+		for (size_t i = 0, j = 0; i < scratchU.size() && j < scratchV.size();)
+		{
+			if (scratchU[i] < scratchV[j])
+				i++;
+			else if (scratchU[i] > scratchV[j])
+				j++;
+			else
+			{
+				common++;
+				i++;
+				j++;
+			}
+		}
+		if (common != (size_t)edgeTriangles)
+			return -1.0;
+
+		// Os triângulos que ficam: o canto de u precisa ter destino e a normal não pode virar
+		const glm::dvec3& target = positions[v];
+		for (unsigned int t : around[u])
+		{
+			if (!alive[t] || cornerOf(t, v) >= 0)
+				continue;
+			int cu = cornerOf(t, u);
+			unsigned int from = corners[3 * t + cu];
+			bool mapped = false;
+			for (const pair<unsigned int, unsigned int>& known : cornerMap)
+				mapped = mapped || known.first == from;
+			if (!mapped)
+				return -1.0;
+
+			glm::dvec3 p[3];
+			for (int k = 0; k < 3; k++)
+				p[k] = positions[positionOf[corners[3 * t + k]]];
+			glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			p[cu] = target;
+			glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+			if (glm::dot(before, after) <= MIN_NORMAL_COSINE * glm::length(before) * glm::length(after))
+				return -1.0;
+		}
+
+		Quadric q = quadrics[u];
+		q.add(quadrics[v]);
+		return q.weight > 0.0 ? q.error(target) / q.weight : 0.0;
+	}
+
+	void Simplifier::collapse(unsigned int u, unsigned int v, double cost)
+	{
+		// cornerMap vem do evaluate(u, v) feito logo antes
+		neighbours(u, scratchU);
+		for (unsigned int t : around[u])
+		{
+			if (!alive[t])
+				continue;
+			if (cornerOf(t, v) >= 0)
+			{
+				alive[t] = 0;
+				live--;
+				continue;
+			}
+			unsigned int& corner = corners[3 * t + cornerOf(t, u)];
+			for (const pair<unsigned int, unsigned int>& known : cornerMap)
+			{
+				if (known.first == corner)
+				{
+					corner = known.second;
+					break;
+				}
+			}
+			around[v].push_back(t);
+		}
+		vector<unsigned int>().swap(around[u]);
+
+		vector<unsigned int>& list = around[v];
+		list.erase(remove_if(list.begin(), list.end(), [this](unsigned int t) { return !alive[t]; }), list.end());
+
+		// As arestas de contorno de u passam para v
+		if (featureCount[u] > 0)
+		{
+			for (unsigned int n : scratchU)
+			{
+				if (features.erase(edgeKey(u, n)) == 0)
+					continue;
+				featureCount[n]--;
+				if (n != v && features.insert(edgeKey(v, n)).second)
+				{
+					featureCount[v]++;
+					featureCount[n]++;
+				}
+			}
+		}
+
+		quadrics[v].add(quadrics[u]);
+		removed[u] = 1;
+		version[v]++;
+		maxCost = std::max(maxCost, cost);
+
+		neighbours(v, scratchV);
+		vector<unsigned int> next = scratchV;
+		for (unsigned int n : next)
+			pushEdge(v, n);
+	}
+
+	void Simplifier::pushEdge(unsigned int a, unsigned int b)
+	{
+		// A direção mais barata entre as permitidas
+		double ab = evaluate(a, b);
+		double ba = evaluate(b, a);
+		if (ab < 0.0 && ba < 0.0)
+			return;
+		if (ab >= 0.0 && (ba < 0.0 || ab <= ba))
+			heap.push({ ab, a, b, version[a], version[b] });
+		else
+			heap.push({ ba, b, a, version[b], version[a] });
+	}
+
+	void Simplifier::simplify(size_t targetTriangles)
+	{
+		// Passadas com todas as arestas: um colapso recusado pode voltar a valer depois que
+		// os vizinhos mudam, então a fila é refeita enquanto algum colapso acontece
+		bool progress = true;
+		while (live > targetTriangles && progress)
+		{
+			progress = false;
+			for (size_t t = 0; t < alive.size(); t++)
+			{
+				if (!alive[t])
+					continue;
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned int a = positionOf[corners[3 * t + k]];
+					unsigned int b = positionOf[corners[3 * t + (k + 1) % 3]];
+					if (a < b || features.count(edgeKey(a, b)) > 0)
+						pushEdge(a, b);
+				}
+			}
+
+			while (!heap.empty() && live > targetTriangles)
+			{
+				Candidate candidate = heap.top();
+				heap.pop();
+				if (removed[candidate.from] || removed[candidate.to] ||
+					version[candidate.from] != candidate.fromVersion || version[candidate.to] != candidate.toVersion)
+					continue;
+				// A quádrica não mudou (mesma versão), mas a vizinhança pode ter mudado
+				double cost = evaluate(candidate.from, candidate.to);
+				if (cost < 0.0)
+					continue;
+				collapse(candidate.from, candidate.to, cost);
+				progress = true;
+			}
+			heap = decltype(heap)();
+		}
+	}
+
+	void Simplifier::output(vector<unsigned int>& indices, vector<SubMesh>& submeshes) const
+	{
+		indices.clear();
+		submeshes.clear();
+		indices.reserve(live * 3);
+		for (size_t r = 0; r < ranges.size(); r++)
+		{
+			SubMesh submesh;
+			submesh.material = ranges[r].material;
+			submesh.first = (unsigned int)indices.size();
+			for (size_t t = 0; t < alive.size(); t++)
+			{
+				if (alive[t] && material[t] == r)
+					indices.insert(indices.end(), corners.begin() + 3 * t, corners.begin() + 3 * t + 3);
+			}
+			submesh.count = (unsigned int)indices.size() - submesh.first;
+			if (submesh.count > 0)
+				submeshes.push_back(submesh);
+		}
+	}
+
+	// Ponto do triângulo abc mais próximo de p (Ericson, "Real-Time Collision Detection")
+	glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+		float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+			return a;
+		glm::vec3 bp = p - b;
+		float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3)
+			return b;
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return a + ab * (d1 / (d1 - d3));
+		glm::vec3 cp = p - c;
+		float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6)
+			return c;
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return a + ac * (d2 / (d2 - d6));
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		float denominator = 1.0f / (va + vb + vc);
+		return a + ab * (vb * denominator) + ac * (vc * denominator);
+	}
+
+	// Raio da varredura ("-": o nível não foi usado ou não foi deixado)
+	string radiusText(float radius)
+	{
+		if (radius == 0.0f)
+			return "-";
+		char text[32];
+		snprintf(text, sizeof(text), "%.1f", radius);
+		return text;
+	}
+
+	inline glm::vec3 vertexPosition(const MeshData& mesh, unsigned int index)
+	{
+		const float* v = mesh.vertices.data() + (size_t)index * OBJ_FLOATS_PER_VERTEX;
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+}
+
+float simplifyMesh(const MeshData& mesh, size_t targetTriangles, vector<unsigned int>& indices, vector<SubMesh>& submeshes)
+{
+	Simplifier simplifier(mesh);
+	simplifier.simplify(targetTriangles);
+	simplifier.output(indices, submeshes);
+	return simplifier.relativeError();
+}
+
+void buildMeshLods(MeshData& mesh, int levels, MeshOptimization optimization, vector<MeshLod>& lods)
+{
+	lods.clear();
+	if (levels <= 1 || mesh.indices.empty())
+	{
+		optimizeMesh(mesh, optimization);
+		return;
+	}
+	levels = std::min(levels, MAX_MESH_LODS);
+
+	// Cada nível sai da malha completa (o erro é sempre em relação a ela); o erro de um
+	// nível nunca é menor que o do anterior
+	struct Level
+	{
+		vector<unsigned int> indices;
+		vector<SubMesh> submeshes;
+		float error = 0.0f;
+	};
+	vector<Level> simplified;
+	size_t previous = mesh.indices.size() / 3;
+	float error = 0.0f;
+	for (int level = 1; level < levels; level++)
+	{
+		Level next;
+		next.error = simplifyMesh(mesh, (size_t)(previous * MESH_LOD_REDUCTION), next.indices, next.submeshes);
+		size_t triangles = next.indices.size() / 3;
+		if (triangles == 0 || triangles > previous * MIN_LOD_REDUCTION)
+			break;
+		error = std::max(error, next.error);
+		next.error = error;
+		previous = triangles;
+		simplified.push_back(std::move(next));
+	}
+
+	// Cache de vértices e overdraw em cada nível separadamente, com os índices do nível no
+	// lugar dos da malha
+	auto optimizeOrder = [&]() {
+		if (optimization == MESH_OPTIMIZATION_NONE)
+			return;
+		optimizeVertexCache(mesh);
+		if (optimization == MESH_OPTIMIZATION_OVERDRAW)
+			optimizeOverdraw(mesh);
+	};
+	optimizeOrder();
+	for (Level& level : simplified)
+	{
+		mesh.indices.swap(level.indices);
+		mesh.submeshes.swap(level.submeshes);
+		optimizeOrder();
+		mesh.indices.swap(level.indices);
+		mesh.submeshes.swap(level.submeshes);
+	}
+
+	for (Level& level : simplified)
+	{
+		MeshLod lod;
+		lod.error = level.error;
+		lod.first = (unsigned int)mesh.indices.size();
+		lod.count = (unsigned int)level.indices.size();
+		lod.submeshes = level.submeshes;
+		for (SubMesh& submesh : lod.submeshes)
+			submesh.first += lod.first;
+		mesh.indices.insert(mesh.indices.end(), level.indices.begin(), level.indices.end());
+		lods.push_back(lod);
+	}
+
+	// Renumeração pela ordem de uso com todos os níveis: os vértices do nível 0 vêm
+	// primeiro e os níveis simplificados usam só vértices dele
+	if (optimization != MESH_OPTIMIZATION_NONE)
+		optimizeVertexFetch(mesh);
+}
+
+int selectMeshLod(const float* errors, int count, int current, float projectedRadius, float maxErrorPixels, float hysteresis)
+{
+	int lod = std::min(std::max(current, 0), count - 1);
+
+	// Mais detalhe assim que o erro do nível atual passa do limite
+	while (lod > 0 && errors[lod] * projectedRadius > maxErrorPixels)
+		lod--;
+
+	// Menos detalhe só com folga abaixo do limite
+	while (lod + 1 < count && errors[lod + 1] * projectedRadius * (1.0f + hysteresis) <= maxErrorPixels)
+		lod++;
+	return lod;
+}
+
+bool checkMeshLods(const vector<string>& files, int levels)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	// Limite de erro e margem usados na varredura de distâncias (os padrões da cena)
+	const float errorPixels = 1.0f;
+	const float hysteresis = 0.25f;
+
+	bool allValid = true;
+	cout << left << setw(32) << "Arquivo" << right << setw(6) << "nivel" << setw(10) << "triang." << setw(8) << "%"
+		<< setw(12) << "erro est." << setw(12) << "medido max" << setw(12) << "medio" << setw(8) << "ACMR"
+		<< setw(12) << "entra (px)" << setw(12) << "sai (px)" << endl;
+
+	for (const string& file : files)
+	{
+		MeshData mesh;
+		if (!loadOBJMesh(file, mesh) || mesh.indices.empty())
+		{
+			cout << "Erro ao tentar ler o arquivo " << file << " (ou malha nao indexada)" << endl;
+			allValid = false;
+			continue;
+		}
+
+		// Posições distintas da malha completa: referência da medição do erro
+		vector<glm::vec3> reference;
+		for (unsigned int index : mesh.indices)
+			reference.push_back(vertexPosition(mesh, index));
+		sort(reference.begin(), reference.end(), [](const glm::vec3& a, const glm::vec3& b) {
+			return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+		});
+		reference.erase(unique(reference.begin(), reference.end()), reference.end());
+		glm::vec3 boundsMin = reference[0], boundsMax = reference[0];
+		for (const glm::vec3& p : reference)
+		{
+			boundsMin = glm::min(boundsMin, p);
+			boundsMax = glm::max(boundsMax, p);
+		}
+		float radius = 0.0f;
+		for (const glm::vec3& p : reference)
+			radius = std::max(radius, glm::length(p - 0.5f * (boundsMin + boundsMax)));
+
+		Clock::time_point start = Clock::now();
+		vector<MeshLod> lods;
+		buildMeshLods(mesh, levels, MESH_OPTIMIZATION_VERTEX_CACHE, lods);
+		double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+
+		// Nível 0 seguido dos simplificados: faixas contíguas, cobertas pelas de material,
+		// índices válidos, sem triângulos degenerados e cada nível menor que o anterior
+		vector<MeshLod> levelsOfMesh(1);
+		levelsOfMesh[0].count = lods.empty() ? (unsigned int)mesh.indices.size() : lods[0].first;
+		levelsOfMesh[0].submeshes = mesh.submeshes;
+		levelsOfMesh.insert(levelsOfMesh.end(), lods.begin(), lods.end());
+
+		vector<float> errors;
+		for (const MeshLod& lod : levelsOfMesh)
+			errors.push_back(lod.error);
+
+		// Varredura do raio na tela de longe para perto e de volta: raio em que cada nível
+		// passa a ser usado ao afastar e deixa de ser ao aproximar
+		vector<float> enterRadius(levelsOfMesh.size(), 0.0f), leaveRadius(levelsOfMesh.size(), 0.0f);
+		int current = 0;
+		for (float r = 4096.0f; r >= 0.5f; r *= 0.98f)
+		{
+			int next = selectMeshLod(errors.data(), (int)errors.size(), current, r, errorPixels, hysteresis);
+			if (next != current && enterRadius[next] == 0.0f)
+				enterRadius[next] = r;
+			current = next;
+		}
+		for (float r = 0.5f; r <= 4096.0f; r *= 1.02f)
+		{
+			int next = selectMeshLod(errors.data(), (int)errors.size(), current, r, errorPixels, hysteresis);
+			if (next != current && leaveRadius[current] == 0.0f)
+				leaveRadius[current] = r;
+			current = next;
+		}
+
+		bool valid = true;
+		unsigned int expectedFirst = 0;
+		size_t previousTriangles = 0;
+		for (size_t l = 0; l < levelsOfMesh.size(); l++)
+		{
+			const MeshLod& lod = levelsOfMesh[l];
+			size_t triangles = lod.count / 3;
+			bool levelValid = lod.first == expectedFirst && lod.count % 3 == 0 && (size_t)lod.first + lod.count <= mesh.indices.size() &&
+				(l == 0 || triangles < previousTriangles) && (l == 0 || lod.error >= levelsOfMesh[l - 1].error) &&
+				(enterRadius[l] == 0.0f || leaveRadius[l] == 0.0f || enterRadius[l] < leaveRadius[l]);
+			unsigned int rangeFirst = lod.first;
+			for (const SubMesh& submesh : lod.submeshes)
+			{
+				levelValid = levelValid && submesh.first == rangeFirst && submesh.count % 3 == 0;
+				rangeFirst = submesh.first + submesh.count;
+			}
+			levelValid = levelValid && rangeFirst == lod.first + lod.count;
+
+			// Erro medido: distância de cada posição da malha completa até o triângulo mais
+			// próximo do nível (força bruta; as malhas do projeto têm poucos milhares de triângulos)
+			const unsigned int* indices = mesh.indices.data() + lod.first;
+			for (size_t i = 0; levelValid && i < lod.count; i++)
+				levelValid = indices[i] < mesh.vertexCount();
+			for (size_t t = 0; levelValid && t < triangles; t++)
+			{
+				glm::vec3 a = vertexPosition(mesh, indices[3 * t]), b = vertexPosition(mesh, indices[3 * t + 1]), c = vertexPosition(mesh, indices[3 * t + 2]);
+				levelValid = a != b && b != c && a != c;
+			}
+			double maxDistance = 0.0, sumDistance = 0.0;
+			if (levelValid && l > 0)
+			{
+				for (const glm::vec3& p : reference)
+				{
+					float closest = INFINITY;
+					for (size_t t = 0; t < triangles; t++)
+					{
+						glm::vec3 q = closestPointOnTriangle(p, vertexPosition(mesh, indices[3 * t]), vertexPosition(mesh, indices[3 * t + 1]), vertexPosition(mesh, indices[3 * t + 2]));
+						closest = std::min(closest, glm::dot(q - p, q - p));
+					}
+					maxDistance = std::max(maxDistance, (double)std::sqrt(closest));
+					sumDistance += std::sqrt(closest);
+				}
+			}
+			VertexCacheStats stats = analyzeVertexCache(indices, lod.count, mesh.vertexCount());
+
+			string name = l == 0 ? file.substr(file.size() > 31 ? file.size() - 31 : 0) : "";
+			double percentOfRadius = radius > 0.0f ? 100.0 / radius : 0.0;
+			cout << left << setw(32) << name << right << setw(6) << l << setw(10) << triangles
+				<< fixed << setprecision(1) << setw(8) << 100.0 * triangles / (levelsOfMesh[0].count / 3)
+				<< setprecision(3) << setw(11) << 100.0 * lod.error << "%"
+				<< setw(11) << maxDistance * percentOfRadius << "%" << setw(11) << sumDistance / reference.size() * percentOfRadius << "%"
+				<< setw(8) << stats.acmr << setprecision(1) << setw(12) << radiusText(enterRadius[l]) << setw(12) << radiusText(leaveRadius[l])
+				<< (levelValid ? "" : "  INVALIDO") << defaultfloat << setprecision(6) << endl;
+
+			valid = valid && levelValid;
+			expectedFirst = lod.first + lod.count;
+			previousTriangles = triangles;
+		}
+		cout << "    " << levelsOfMesh.size() << " nivel(is) em " << fixed << setprecision(2) << ms << " ms; erros em % do raio da esfera envolvente ("
+			<< radius << "); raio na tela para limite de " << setprecision(1) << errorPixels << " px e margem de " << setprecision(0) << 100.0f * hysteresis << "%"
+			<< defaultfloat << setprecision(6) << endl;
+		allValid = allValid && valid;
+	}
+	return allValid;
+}
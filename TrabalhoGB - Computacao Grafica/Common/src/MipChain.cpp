@@ -0,0 +1,1038 @@
+#include "MipChain.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "Texture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// SSE2/AVX2 por função (target), escolhidos em tempo de execução: o executável
+// continua rodando em processadores sem AVX2
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MIP_CHAIN_X86 1
+#include <immintrin.h>
+#define MIP_TARGET_SSE2 __attribute__((target("sse2")))
+#define MIP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+namespace
+{
+	const char MIP_CHAIN_MAGIC[8] = { 'C', 'G', 'M', 'I', 'P', 'S', 0, 0 };
+
+	// Sufixo dos arquivos temporários: duas gravações do mesmo arquivo ao mesmo tempo
+	// não escrevem no mesmo temporário
+	atomic<unsigned> tempFileCounter(0);
+
+	// Cadeias sendo preparadas agora, por imagem, filtro e limite efetivo: quem pede a
+	// mesma cadeia enquanto ela é gerada espera a primeira e recebe uma cópia
+	struct PendingMipChain
+	{
+		shared_future<bool> done;
+		MipChain chain;
+		int waiters = 0;
+	};
+	mutex pendingChainsMutex;
+	map<string, shared_ptr<PendingMipChain>> pendingChains;
+
+	// Cabeçalho do arquivo, seguido da tabela de níveis; os dados começam em offsets
+	// alinhados a 16 bytes
+	struct MipChainHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t channels;
+		uint32_t filter;
+		uint32_t levelCount;
+		uint64_t sourceHash;
+		uint64_t sourceSize;
+	};
+
+	struct MipChainLevelEntry
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t bytes;
+	};
+
+	static_assert(sizeof(MipChainHeader) == 40, "MipChainHeader mudou de tamanho: incremente MIP_CHAIN_VERSION");
+	static_assert(sizeof(MipChainLevelEntry) == 24, "MipChainLevelEntry mudou de tamanho: incremente MIP_CHAIN_VERSION");
+
+	inline uint64_t alignTo16(uint64_t value)
+	{
+		return (value + 15) & ~(uint64_t)15;
+	}
+
+	// ---- Conversão sRGB <-> luz linear ----
+
+	// A luz linear é quantizada em 16 bits para a volta ao sRGB de 8 bits (a diferença
+	// entre dois tons escuros vizinhos do sRGB é maior que 1/65535)
+	const float LINEAR_SCALE = 65535.0f;
+	const float ALPHA_SCALE = 255.0f;
+
+	struct ConversionTables
+	{
+		float toLinear[256];
+		float alphaToFloat[256];
+		unsigned char toSrgb[65536];
+
+		ConversionTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				double c = i / 255.0;
+				toLinear[i] = (float)(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+				alphaToFloat[i] = (float)c;
+			}
+			for (int i = 0; i < 65536; i++)
+			{
+				double l = i / 65535.0;
+				double c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+				toSrgb[i] = (unsigned char)std::clamp((int)(c * 255.0 + 0.5), 0, 255);
+			}
+		}
+	};
+
+	const ConversionTables& tables()
+	{
+		static ConversionTables conversion;
+		return conversion;
+	}
+
+	// Uma linha RGB/RGBA de 8 bits para RGBA em luz linear (alfa 1 nas imagens RGB)
+	void bytesToLinear(const unsigned char* src, int width, int channels, float* dst)
+	{
+		const ConversionTables& t = tables();
+		for (int x = 0; x < width; x++, src += channels, dst += 4)
+		{
+			dst[0] = t.toLinear[src[0]];
+			dst[1] = t.toLinear[src[1]];
+			dst[2] = t.toLinear[src[2]];
+			dst[3] = channels == 4 ? t.alphaToFloat[src[3]] : 1.0f;
+		}
+	}
+
+	inline int quantize(float value, float scale)
+	{
+		return (int)(std::min(std::max(value, 0.0f), 1.0f) * scale + 0.5f);
+	}
+
+	// ---- Filtros ----
+
+	// Cada texel de saída x combina os texels 2x + offset + k da origem (k < taps),
+	// com as bordas repetidas. Dimensão 1 na origem não é filtrada
+	struct Kernel
+	{
+		int taps = 1;
+		int offset = 0;
+		float weights[8] = { 1.0f };
+	};
+
+	double besselI0(double x)
+	{
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	Kernel makeKernel(MipFilter filter, int sourceSize)
+	{
+		Kernel kernel;
+		if (sourceSize == 1)
+			return kernel;
+
+		if (filter == MIP_FILTER_BOX)
+		{
+			kernel.taps = 2;
+			kernel.weights[0] = kernel.weights[1] = 0.5f;
+			return kernel;
+		}
+
+		// Sinc com corte na metade da frequência (redução por 2), janela de Kaiser de
+		// raio 4 texels (beta = 4); o centro da saída fica entre os texels 2x e 2x + 1
+		const double pi = 3.14159265358979323846;
+		const double beta = 4.0, radius = 4.0;
+		kernel.taps = 8;
+		kernel.offset = -3;
+		double weights[8], sum = 0.0;
+		for (int k = 0; k < 8; k++)
+		{
+			double distance = k - 3.5;
+			double t = distance / 2.0;
+			double sinc = sin(pi * t) / (pi * t);
+			double ratio = distance / radius;
+			double window = besselI0(beta * sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+			weights[k] = sinc * window;
+			sum += weights[k];
+		}
+		for (int k = 0; k < 8; k++)
+			kernel.weights[k] = (float)(weights[k] / sum);
+		return kernel;
+	}
+
+	// Fases do redimensionamento de um eixo: cada texel de saída combina taps texels da
+	// origem (índices com as bordas já repetidas), cada um com o seu peso
+	struct Polyphase
+	{
+		int taps = 1;
+		vector<int> index;      // outSize * taps
+		vector<float> weights;  // outSize * taps
+	};
+
+	Polyphase makePolyphase(int sourceSize, int outSize)
+	{
+		// O mesmo sinc janelado por Kaiser do filtro de mipmaps (raio de 2 texels de
+		// saída), com o corte na frequência da saída: o suporte cresce com a redução.
+		// Na escala 2 as fases coincidem com o makeKernel(MIP_FILTER_KAISER)
+		const double pi = 3.14159265358979323846;
+		const double beta = 4.0, lobes = 2.0;
+		double scale = (double)sourceSize / outSize;
+		double filterScale = std::max(1.0, scale);
+		double support = lobes * filterScale;
+
+		Polyphase phases;
+		phases.taps = std::max(1, (int)ceil(2.0 * support));
+		phases.index.resize((size_t)outSize * phases.taps);
+		phases.weights.resize((size_t)outSize * phases.taps);
+		vector<double> weights(phases.taps);
+		for (int i = 0; i < outSize; i++)
+		{
+			double center = (i + 0.5) * scale - 0.5;
+			int first = (int)floor(center - support) + 1;
+			double sum = 0.0;
+			for (int k = 0; k < phases.taps; k++)
+			{
+				double t = (first + k - center) / filterScale;
+				double weight = 0.0;
+				if (fabs(t) < 1e-9)
+					weight = 1.0;
+				else if (fabs(t) < lobes)
+				{
+					double ratio = t / lobes;
+					weight = sin(pi * t) / (pi * t) * besselI0(beta * sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+				}
+				weights[k] = weight;
+				sum += weight;
+			}
+			for (int k = 0; k < phases.taps; k++)
+			{
+				phases.index[(size_t)i * phases.taps + k] = std::clamp(first + k, 0, sourceSize - 1);
+				phases.weights[(size_t)i * phases.taps + k] = (float)(weights[k] / sum);
+			}
+		}
+		return phases;
+	}
+
+	// As três versões somam na mesma ordem (w0 * t0 + w1 * t1 + ...), então geram os
+	// mesmos bytes; só a quantidade de texels por instrução muda
+
+	// ---- Escalar (referência) ----
+
+	// out[i] = soma de weights[k] * rows[k][i] (i < count floats)
+	void verticalScalar(const float* const* rows, const float* weights, int taps, size_t count, float* out)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			float sum = weights[0] * rows[0][i];
+			for (int k = 1; k < taps; k++)
+				sum += weights[k] * rows[k][i];
+			out[i] = sum;
+		}
+	}
+
+	void horizontalScalar(const float* row, int width, const Kernel& kernel, float* out, int outWidth)
+	{
+		for (int x = 0; x < outWidth; x++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < kernel.taps; k++)
+				{
+					int source = std::clamp(2 * x + kernel.offset + k, 0, width - 1);
+					float term = kernel.weights[k] * row[source * 4 + c];
+					sum = k == 0 ? term : sum + term;
+				}
+				out[x * 4 + c] = sum;
+			}
+		}
+	}
+
+	void polyphaseScalar(const float* row, const Polyphase& phases, float* out, int outWidth)
+	{
+		for (int x = 0; x < outWidth; x++)
+		{
+			const int* index = phases.index.data() + (size_t)x * phases.taps;
+			const float* weights = phases.weights.data() + (size_t)x * phases.taps;
+			for (int c = 0; c < 4; c++)
+			{
+				float sum = weights[0] * row[index[0] * 4 + c];
+				for (int k = 1; k < phases.taps; k++)
+					sum += weights[k] * row[index[k] * 4 + c];
+				out[x * 4 + c] = sum;
+			}
+		}
+	}
+
+	void linearToBytesScalar(const float* linear, int width, int channels, unsigned char* out)
+	{
+		const ConversionTables& t = tables();
+		for (int x = 0; x < width; x++, linear += 4, out += channels)
+		{
+			out[0] = t.toSrgb[quantize(linear[0], LINEAR_SCALE)];
+			out[1] = t.toSrgb[quantize(linear[1], LINEAR_SCALE)];
+			out[2] = t.toSrgb[quantize(linear[2], LINEAR_SCALE)];
+			if (channels == 4)
+				out[3] = (unsigned char)quantize(linear[3], ALPHA_SCALE);
+		}
+	}
+
+#ifdef MIP_CHAIN_X86
+	// ---- SSE2: um texel RGBA (4 floats) por registrador ----
+
+	MIP_TARGET_SSE2 void verticalSSE2(const float* const* rows, const float* weights, int taps, size_t count, float* out)
+	{
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+			for (int k = 1; k < taps; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+			_mm_storeu_ps(out + i, sum);
+		}
+	}
+
+	MIP_TARGET_SSE2 inline __m128 filterTexelSSE2(const float* row, int width, const Kernel& kernel, int x)
+	{
+		int first = 2 * x + kernel.offset;
+		if (first >= 0 && first + kernel.taps <= width)
+		{
+			const float* p = row + first * 4;
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(kernel.weights[0]), _mm_loadu_ps(p));
+			for (int k = 1; k < kernel.taps; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[k]), _mm_loadu_ps(p + k * 4)));
+			return sum;
+		}
+
+		// Borda: índices repetidos
+		__m128 sum = _mm_mul_ps(_mm_set1_ps(kernel.weights[0]), _mm_loadu_ps(row + std::clamp(first, 0, width - 1) * 4));
+		for (int k = 1; k < kernel.taps; k++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[k]), _mm_loadu_ps(row + std::clamp(first + k, 0, width - 1) * 4)));
+		return sum;
+	}
+
+	MIP_TARGET_SSE2 void horizontalSSE2(const float* row, int width, const Kernel& kernel, float* out, int outWidth)
+	{
+		for (int x = 0; x < outWidth; x++)
+			_mm_storeu_ps(out + x * 4, filterTexelSSE2(row, width, kernel, x));
+	}
+
+	MIP_TARGET_SSE2 void polyphaseSSE2(const float* row, const Polyphase& phases, float* out, int outWidth)
+	{
+		for (int x = 0; x < outWidth; x++)
+		{
+			const int* index = phases.index.data() + (size_t)x * phases.taps;
+			const float* weights = phases.weights.data() + (size_t)x * phases.taps;
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(row + index[0] * 4));
+			for (int k = 1; k < phases.taps; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(row + index[k] * 4)));
+			_mm_storeu_ps(out + x * 4, sum);
+		}
+	}
+
+	// Índices das tabelas: min(max(v, 0), 1) * escala + 0.5, truncado
+	MIP_TARGET_SSE2 inline __m128i quantizeSSE2(__m128 value)
+	{
+		const __m128 scale = _mm_setr_ps(LINEAR_SCALE, LINEAR_SCALE, LINEAR_SCALE, ALPHA_SCALE);
+		__m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), _mm_set1_ps(0.5f)));
+	}
+
+	MIP_TARGET_SSE2 void linearToBytesSSE2(const float* linear, int width, int channels, unsigned char* out)
+	{
+		const ConversionTables& t = tables();
+		alignas(16) int32_t index[4];
+		for (int x = 0; x < width; x++, linear += 4, out += channels)
+		{
+			_mm_store_si128((__m128i*)index, quantizeSSE2(_mm_loadu_ps(linear)));
+			out[0] = t.toSrgb[index[0]];
+			out[1] = t.toSrgb[index[1]];
+			out[2] = t.toSrgb[index[2]];
+			if (channels == 4)
+				out[3] = (unsigned char)index[3];
+		}
+	}
+
+	// ---- AVX2: dois texels por registrador ----
+
+	MIP_TARGET_AVX2 void verticalAVX2(const float* const* rows, const float* weights, int taps, size_t count, float* out)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 sum = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + i));
+			for (int k = 1; k < taps; k++)
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+			_mm256_storeu_ps(out + i, sum);
+		}
+		// Último texel de uma linha de largura ímpar
+		if (i < count)
+		{
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+			for (int k = 1; k < taps; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+			_mm_storeu_ps(out + i, sum);
+		}
+	}
+
+	MIP_TARGET_AVX2 void horizontalAVX2(const float* row, int width, const Kernel& kernel, float* out, int outWidth)
+	{
+		int x = 0;
+		// Pares de texels de saída (x, x + 1) cujos taps estão todos dentro da linha;
+		// os taps do segundo texel ficam 2 texels depois dos do primeiro
+		for (; x + 1 < outWidth; x += 2)
+		{
+			int first = 2 * x + kernel.offset;
+			if (first < 0)
+			{
+				_mm_storeu_ps(out + x * 4, filterTexelSSE2(row, width, kernel, x));
+				_mm_storeu_ps(out + x * 4 + 4, filterTexelSSE2(row, width, kernel, x + 1));
+				continue;
+			}
+			if (first + 2 + kernel.taps > width)
+				break;
+
+			const float* p = row + first * 4;
+			__m256 sum = _mm256_mul_ps(_mm256_set1_ps(kernel.weights[0]),
+				_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 8), 1));
+			for (int k = 1; k < kernel.taps; k++)
+			{
+				const float* q = p + k * 4;
+				__m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q)), _mm_loadu_ps(q + 8), 1);
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel.weights[k]), texels));
+			}
+			_mm256_storeu_ps(out + x * 4, sum);
+		}
+		for (; x < outWidth; x++)
+			_mm_storeu_ps(out + x * 4, filterTexelSSE2(row, width, kernel, x));
+	}
+
+	// Dois texels de saída por registrador, cada um com as suas fases
+	MIP_TARGET_AVX2 void polyphaseAVX2(const float* row, const Polyphase& phases, float* out, int outWidth)
+	{
+		int x = 0;
+		for (; x + 1 < outWidth; x += 2)
+		{
+			const int* index = phases.index.data() + (size_t)x * phases.taps;
+			const float* weights = phases.weights.data() + (size_t)x * phases.taps;
+			const int* nextIndex = index + phases.taps;
+			const float* nextWeights = weights + phases.taps;
+			__m256 sum = _mm256_setzero_ps();
+			for (int k = 0; k < phases.taps; k++)
+			{
+				__m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(row + index[k] * 4)), _mm_loadu_ps(row + nextIndex[k] * 4), 1);
+				__m256 weight = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights[k])), _mm_set1_ps(nextWeights[k]), 1);
+				sum = k == 0 ? _mm256_mul_ps(weight, texels) : _mm256_add_ps(sum, _mm256_mul_ps(weight, texels));
+			}
+			_mm256_storeu_ps(out + x * 4, sum);
+		}
+		// Último texel de uma linha de largura ímpar
+		if (x < outWidth)
+		{
+			const int* index = phases.index.data() + (size_t)x * phases.taps;
+			const float* weights = phases.weights.data() + (size_t)x * phases.taps;
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(row + index[0] * 4));
+			for (int k = 1; k < phases.taps; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(row + index[k] * 4)));
+			_mm_storeu_ps(out + x * 4, sum);
+		}
+	}
+
+	MIP_TARGET_AVX2 void linearToBytesAVX2(const float* linear, int width, int channels, unsigned char* out)
+	{
+		const ConversionTables& t = tables();
+		const __m256 scale = _mm256_setr_ps(LINEAR_SCALE, LINEAR_SCALE, LINEAR_SCALE, ALPHA_SCALE, LINEAR_SCALE, LINEAR_SCALE, LINEAR_SCALE, ALPHA_SCALE);
+		alignas(32) int32_t index[8];
+		int x = 0;
+		for (; x + 1 < width; x += 2, linear += 8)
+		{
+			__m256 clamped = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(linear), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+			_mm256_store_si256((__m256i*)index, _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(clamped, scale), _mm256_set1_ps(0.5f))));
+			for (int i = 0; i < 2; i++, out += channels)
+			{
+				out[0] = t.toSrgb[index[i * 4 + 0]];
+				out[1] = t.toSrgb[index[i * 4 + 1]];
+				out[2] = t.toSrgb[index[i * 4 + 2]];
+				if (channels == 4)
+					out[3] = (unsigned char)index[i * 4 + 3];
+			}
+		}
+		if (x < width)
+			linearToBytesSSE2(linear, width - x, channels, out);
+	}
+#endif
+
+	struct MipKernels
+	{
+		void (*vertical)(const float* const* rows, const float* weights, int taps, size_t count, float* out);
+		void (*horizontal)(const float* row, int width, const Kernel& kernel, float* out, int outWidth);
+		void (*polyphase)(const float* row, const Polyphase& phases, float* out, int outWidth);
+		void (*toBytes)(const float* linear, int width, int channels, unsigned char* out);
+	};
+
+	MipKernels kernelsFor(MipSimd simd)
+	{
+#ifdef MIP_CHAIN_X86
+		if (simd == MIP_SIMD_AVX2)
+			return { verticalAVX2, horizontalAVX2, polyphaseAVX2, linearToBytesAVX2 };
+		if (simd == MIP_SIMD_SSE2)
+			return { verticalSSE2, horizontalSSE2, polyphaseSSE2, linearToBytesSSE2 };
+#endif
+		return { verticalScalar, horizontalScalar, polyphaseScalar, linearToBytesScalar };
+	}
+
+	// Maior diferença entre os bytes de duas cadeias (-1 se os tamanhos não batem)
+	int maxDifference(const MipChain& a, const MipChain& b)
+	{
+		if (a.levels.size() != b.levels.size())
+			return -1;
+		int difference = 0;
+		for (size_t i = 0; i < a.levels.size(); i++)
+		{
+			const vector<unsigned char>& x = a.levels[i].data;
+			const vector<unsigned char>& y = b.levels[i].data;
+			if (x.size() != y.size())
+				return -1;
+			for (size_t j = 0; j < x.size(); j++)
+				difference = std::max(difference, abs((int)x[j] - (int)y[j]));
+		}
+		return difference;
+	}
+}
+
+MipFilter mipFilterFromString(const string& name)
+{
+	return name == "kaiser" ? MIP_FILTER_KAISER : MIP_FILTER_BOX;
+}
+
+const char* mipFilterName(MipFilter filter)
+{
+	return filter == MIP_FILTER_KAISER ? "kaiser" : "box";
+}
+
+MipSimd bestMipSimd()
+{
+#ifdef MIP_CHAIN_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return MIP_SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return MIP_SIMD_SSE2;
+#endif
+	return MIP_SIMD_SCALAR;
+}
+
+const char* mipSimdName(MipSimd simd)
+{
+	const char* names[] = { "escalar", "SSE2", "AVX2" };
+	return names[simd];
+}
+
+size_t MipChain::totalBytes() const
+{
+	size_t total = 0;
+	for (const MipLevel& level : levels)
+		total += level.data.size();
+	return total;
+}
+
+void generateMipChain(const unsigned char* pixels, int width, int height, int channels, MipFilter filter, MipChain& chain, MipSimd simd)
+{
+	chain.channels = channels;
+	chain.filter = filter;
+	chain.fromCache = false;
+	chain.levels.clear();
+	chain.levels.emplace_back();
+	chain.levels[0].width = width;
+	chain.levels[0].height = height;
+	chain.levels[0].data.assign(pixels, pixels + (size_t)width * height * channels);
+
+	MipKernels kernels = kernelsFor(simd);
+
+	// Nível atual e seguinte em luz linear (RGBA float). O nível 0 não é convertido
+	// inteiro: as linhas usadas pelo filtro são convertidas em um anel de taps linhas
+	vector<float> current, next, ring, column;
+	vector<int> ringRow;
+	const unsigned char* sourceBytes = pixels;
+	while (width > 1 || height > 1)
+	{
+		int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+		Kernel horizontal = makeKernel(filter, width);
+		Kernel vertical = makeKernel(filter, height);
+		size_t rowFloats = (size_t)width * 4;
+
+		if (sourceBytes != nullptr)
+		{
+			ring.resize(vertical.taps * rowFloats);
+			ringRow.assign(vertical.taps, -1);
+		}
+		auto sourceRow = [&](int y) -> const float*
+		{
+			if (sourceBytes == nullptr)
+				return current.data() + y * rowFloats;
+			// As linhas de uma janela são consecutivas, então caem em posições diferentes do anel
+			int slot = y % vertical.taps;
+			float* row = ring.data() + slot * rowFloats;
+			if (ringRow[slot] != y)
+			{
+				bytesToLinear(sourceBytes + (size_t)y * width * channels, width, channels, row);
+				ringRow[slot] = y;
+			}
+			return row;
+		};
+
+		next.resize((size_t)nextWidth * nextHeight * 4);
+		column.resize(rowFloats);
+		chain.levels.emplace_back();
+		MipLevel& level = chain.levels.back();
+		level.width = nextWidth;
+		level.height = nextHeight;
+		level.data.resize((size_t)nextWidth * nextHeight * channels);
+
+		for (int y = 0; y < nextHeight; y++)
+		{
+			const float* rows[8];
+			for (int k = 0; k < vertical.taps; k++)
+				rows[k] = sourceRow(std::clamp(2 * y + vertical.offset + k, 0, height - 1));
+
+			const float* filtered = rows[0];
+			if (vertical.taps > 1)
+			{
+				kernels.vertical(rows, vertical.weights, vertical.taps, rowFloats, column.data());
+				filtered = column.data();
+			}
+
+			float* out = next.data() + (size_t)y * nextWidth * 4;
+			kernels.horizontal(filtered, width, horizontal, out, nextWidth);
+			kernels.toBytes(out, nextWidth, channels, level.data.data() + (size_t)y * nextWidth * channels);
+		}
+
+		current.swap(next);
+		sourceBytes = nullptr;
+		width = nextWidth;
+		height = nextHeight;
+	}
+}
+
+void fitImageSize(int width, int height, int maxSize, int& fitWidth, int& fitHeight)
+{
+	fitWidth = width;
+	fitHeight = height;
+	if (maxSize <= 0 || std::max(width, height) <= maxSize)
+		return;
+
+	double scale = (double)maxSize / std::max(width, height);
+	fitWidth = std::clamp((int)lround(width * scale), 1, maxSize);
+	fitHeight = std::clamp((int)lround(height * scale), 1, maxSize);
+}
+
+void resampleImage(const unsigned char* pixels, int width, int height, int channels, int outWidth, int outHeight, vector<unsigned char>& out, MipSimd simd)
+{
+	MipKernels kernels = kernelsFor(simd);
+	Polyphase horizontal = makePolyphase(width, outWidth);
+	Polyphase vertical = makePolyphase(height, outHeight);
+	out.resize((size_t)outWidth * outHeight * channels);
+
+	// Como no generateMipChain: as linhas da origem são convertidas para luz linear em um
+	// anel de taps linhas (as linhas de uma janela são consecutivas)
+	size_t rowFloats = (size_t)width * 4;
+	vector<float> ring(vertical.taps * rowFloats), column(rowFloats), linear((size_t)outWidth * 4);
+	vector<int> ringRow(vertical.taps, -1);
+	vector<const float*> rows(vertical.taps);
+	for (int y = 0; y < outHeight; y++)
+	{
+		for (int k = 0; k < vertical.taps; k++)
+		{
+			int sourceY = vertical.index[(size_t)y * vertical.taps + k];
+			int slot = sourceY % vertical.taps;
+			float* row = ring.data() + slot * rowFloats;
+			if (ringRow[slot] != sourceY)
+			{
+				bytesToLinear(pixels + (size_t)sourceY * width * channels, width, channels, row);
+				ringRow[slot] = sourceY;
+			}
+			rows[k] = row;
+		}
+
+		kernels.vertical(rows.data(), vertical.weights.data() + (size_t)y * vertical.taps, vertical.taps, rowFloats, column.data());
+		kernels.polyphase(column.data(), horizontal, linear.data(), outWidth);
+		kernels.toBytes(linear.data(), outWidth, channels, out.data() + (size_t)y * outWidth * channels);
+	}
+}
+
+string mipChainPath(const string& imagePath, int maxSize)
+{
+	if (maxSize > 0)
+		return imagePath + "." + to_string(maxSize) + ".mips";
+	return imagePath + ".mips";
+}
+
+bool saveMipChain(const string& path, const MipChain& chain)
+{
+	MipChainHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MIP_CHAIN_MAGIC, sizeof(header.magic));
+	header.version = MIP_CHAIN_VERSION;
+	header.channels = (uint32_t)chain.channels;
+	header.filter = (uint32_t)chain.filter;
+	header.levelCount = (uint32_t)chain.levels.size();
+	header.sourceHash = chain.sourceHash;
+	header.sourceSize = chain.sourceSize;
+
+	vector<MipChainLevelEntry> entries(chain.levels.size());
+	uint64_t offset = alignTo16(sizeof(header) + entries.size() * sizeof(MipChainLevelEntry));
+	for (size_t i = 0; i < chain.levels.size(); i++)
+	{
+		entries[i].width = (uint32_t)chain.levels[i].width;
+		entries[i].height = (uint32_t)chain.levels[i].height;
+		entries[i].offset = offset;
+		entries[i].bytes = chain.levels[i].data.size();
+		offset = alignTo16(offset + entries[i].bytes);
+	}
+
+	string tempPath = path + "." + to_string(tempFileCounter++) + ".tmp";
+	{
+		ofstream out(tempPath, ios::binary | ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		const char padding[16] = { 0 };
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)entries.data(), entries.size() * sizeof(MipChainLevelEntry));
+		uint64_t written = sizeof(header) + entries.size() * sizeof(MipChainLevelEntry);
+		for (size_t i = 0; i < chain.levels.size(); i++)
+		{
+			out.write(padding, entries[i].offset - written);
+			out.write((const char*)chain.levels[i].data.data(), chain.levels[i].data.size());
+			written = entries[i].offset + entries[i].bytes;
+		}
+		if (!out.good())
+		{
+			out.close();
+			error_code error;
+			filesystem::remove(tempPath, error);
+			return false;
+		}
+	}
+
+	error_code error;
+	filesystem::rename(tempPath, path, error);
+	if (error)
+	{
+		filesystem::remove(tempPath, error);
+		return false;
+	}
+	return true;
+}
+
+bool loadMipChain(const string& imagePath, MipFilter filter, MipChain& chain, int maxSize)
+{
+	MappedFile file;
+	if (!file.open(mipChainPath(imagePath, maxSize)) || file.size() < sizeof(MipChainHeader))
+		return false;
+
+	MipChainHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, MIP_CHAIN_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != MIP_CHAIN_VERSION ||
+		header.filter != (uint32_t)filter ||
+		(header.channels != 3 && header.channels != 4) ||
+		header.levelCount == 0 || header.levelCount > 32 ||
+		sizeof(header) + (uint64_t)header.levelCount * sizeof(MipChainLevelEntry) > file.size())
+		return false;
+
+	// Imagem alterada depois da geração: o arquivo não vale mais
+	MappedFile source;
+	if (!source.open(imagePath) || header.sourceSize != source.size() || header.sourceHash != hashBytes(source.data(), source.size()))
+		return false;
+
+	chain.channels = (int)header.channels;
+	chain.filter = filter;
+	chain.sourceHash = header.sourceHash;
+	chain.sourceSize = header.sourceSize;
+	chain.levels.assign(header.levelCount, MipLevel());
+	for (uint32_t i = 0; i < header.levelCount; i++)
+	{
+		MipChainLevelEntry entry;
+		memcpy(&entry, file.data() + sizeof(header) + i * sizeof(MipChainLevelEntry), sizeof(entry));
+		if (entry.bytes != (uint64_t)entry.width * entry.height * header.channels || entry.offset + entry.bytes > file.size())
+		{
+			chain.levels.clear();
+			return false;
+		}
+		if (i == 0 && maxSize > 0 && (int)std::max(entry.width, entry.height) > maxSize)
+		{
+			chain.levels.clear();
+			return false;
+		}
+		MipLevel& level = chain.levels[i];
+		level.width = (int)entry.width;
+		level.height = (int)entry.height;
+		level.data.assign(file.data() + entry.offset, file.data() + entry.offset + entry.bytes);
+	}
+	chain.fromCache = true;
+	return true;
+}
+
+namespace
+{
+	// Lê o arquivo da cadeia ou decodifica a imagem, gera a cadeia e grava o arquivo
+	bool buildMipChain(const string& imagePath, MipFilter filter, MipChain& chain, int maxSize)
+	{
+		if (loadMipChain(imagePath, filter, chain, maxSize))
+			return true;
+
+		MappedFile source;
+		DecodedImage image;
+		if (!source.open(imagePath) || !decodeImage(imagePath, image))
+			return false;
+
+		// Tons de cinza (com ou sem alfa) viram RGBA
+		if (image.channels != 3 && image.channels != 4)
+		{
+			freeImage(image);
+			if (!decodeImage(imagePath, image, 4))
+				return false;
+		}
+
+		limitImageSize(image, maxSize);
+		generateMipChain(image.data, image.width, image.height, image.channels, filter, chain);
+		freeImage(image);
+		chain.sourceHash = hashBytes(source.data(), source.size());
+		chain.sourceSize = source.size();
+
+		if (!saveMipChain(mipChainPath(imagePath, maxSize), chain))
+			cout << "Nao foi possivel gravar " << mipChainPath(imagePath, maxSize) << endl;
+		return true;
+	}
+}
+
+bool prepareMipChain(const string& imagePath, MipFilter filter, MipChain& chain, int maxSize)
+{
+	// O limite só muda o arquivo se a imagem passa dele (o cabeçalho da imagem basta)
+	int width, height;
+	if (maxSize > 0 && readImageSize(imagePath, width, height) && std::max(width, height) <= maxSize)
+		maxSize = 0;
+
+	// Amostragens diferentes da mesma imagem usam a mesma cadeia: se ela já está sendo
+	// preparada, espera a outra thread e copia o resultado
+	string key = imagePath + "|" + to_string((int)filter) + "|" + to_string(maxSize);
+	shared_ptr<PendingMipChain> pending;
+	promise<bool> finished;
+	bool owner = false;
+	{
+		lock_guard<mutex> lock(pendingChainsMutex);
+		shared_ptr<PendingMipChain>& entry = pendingChains[key];
+		if (!entry)
+		{
+			entry = make_shared<PendingMipChain>();
+			entry->done = finished.get_future().share();
+			owner = true;
+		}
+		else
+		{
+			entry->waiters++;
+		}
+		pending = entry;
+	}
+
+	if (!owner)
+	{
+		if (!pending->done.get())
+			return false;
+		chain = pending->chain;
+		return true;
+	}
+
+	bool prepared = buildMipChain(imagePath, filter, chain, maxSize);
+
+	// Sai da lista antes de publicar: quem chegar depois lê o arquivo já gravado. A
+	// cópia só é feita se alguém esperou
+	int waiters;
+	{
+		lock_guard<mutex> lock(pendingChainsMutex);
+		pendingChains.erase(key);
+		waiters = pending->waiters;
+	}
+	if (prepared && waiters > 0)
+		pending->chain = chain;
+	finished.set_value(prepared);
+	return prepared;
+}
+
+void benchmarkMipChain(const vector<string>& files, int repetitions)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	MipSimd best = bestMipSimd();
+	cout << "Melhor conjunto de instrucoes: " << mipSimdName(best) << endl;
+	cout << left << setw(40) << "Arquivo" << right << setw(12) << "tamanho" << setw(8) << "filtro"
+		<< setw(12) << "escalar ms" << setw(10) << "SSE2 ms" << setw(10) << "AVX2 ms" << setw(10) << "ganho"
+		<< setw(10) << "dif. max" << endl;
+
+	for (const string& file : files)
+	{
+		DecodedImage image;
+		if (!decodeImage(file, image))
+		{
+			cout << "Erro ao tentar ler o arquivo " << file << endl;
+			continue;
+		}
+		if (image.channels != 3 && image.channels != 4)
+		{
+			freeImage(image);
+			decodeImage(file, image, 4);
+		}
+
+		for (int filter = MIP_FILTER_BOX; filter <= MIP_FILTER_KAISER; filter++)
+		{
+			// Melhor tempo de cada versão; as saídas são comparadas com a escalar
+			double milliseconds[3] = { 0.0, 0.0, 0.0 };
+			int difference = 0;
+			MipChain reference;
+			for (int simd = MIP_SIMD_SCALAR; simd <= best; simd++)
+			{
+				MipChain chain;
+				double bestTime = 1e30;
+				for (int r = 0; r < repetitions; r++)
+				{
+					Clock::time_point start = Clock::now();
+					generateMipChain(image.data, image.width, image.height, image.channels, (MipFilter)filter, chain, (MipSimd)simd);
+					bestTime = std::min(bestTime, chrono::duration<double, milli>(Clock::now() - start).count());
+				}
+				milliseconds[simd] = bestTime;
+				if (simd == MIP_SIMD_SCALAR)
+					reference = std::move(chain);
+				else
+					difference = std::max(difference, maxDifference(reference, chain));
+			}
+
+			string name = file.substr(file.size() > 39 ? file.size() - 39 : 0);
+			cout << left << setw(40) << (filter == MIP_FILTER_BOX ? name : "") << right
+				<< setw(12) << (to_string(image.width) + "x" + to_string(image.height) + "x" + to_string(image.channels))
+				<< setw(8) << mipFilterName((MipFilter)filter) << fixed << setprecision(2)
+				<< setw(12) << milliseconds[MIP_SIMD_SCALAR] << setw(10) << milliseconds[MIP_SIMD_SSE2] << setw(10) << milliseconds[MIP_SIMD_AVX2]
+				<< setw(9) << milliseconds[MIP_SIMD_SCALAR] / milliseconds[best] << "x" << setw(10) << difference
+				<< defaultfloat << setprecision(6) << endl;
+		}
+		freeImage(image);
+
+		// Carga na execução seguinte: decodificar + gerar contra ler o arquivo .mips
+		MipChain chain;
+		filesystem::remove(mipChainPath(file));
+		Clock::time_point start = Clock::now();
+		prepareMipChain(file, MIP_FILTER_BOX, chain);
+		double generated = chrono::duration<double, milli>(Clock::now() - start).count();
+		start = Clock::now();
+		bool cached = prepareMipChain(file, MIP_FILTER_BOX, chain) && chain.fromCache;
+		double loaded = chrono::duration<double, milli>(Clock::now() - start).count();
+		cout << "    decodificar + gerar + gravar: " << fixed << setprecision(2) << generated << " ms, ler "
+			<< mipChainPath(file) << ": " << loaded << " ms" << (cached ? "" : " (FALHOU)")
+			<< ", " << chain.totalBytes() / 1024 << " KB" << defaultfloat << setprecision(6) << endl;
+	}
+}
+
+void benchmarkResample(const vector<string>& files, int maxSize, int repetitions)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	MipSimd best = bestMipSimd();
+	cout << "Lado maximo: " << maxSize << ", melhor conjunto de instrucoes: " << mipSimdName(best) << endl;
+	cout << left << setw(40) << "Arquivo" << right << setw(14) << "tamanho" << setw(12) << "escalar ms"
+		<< setw(10) << "SSE2 ms" << setw(10) << "AVX2 ms" << setw(10) << "ganho" << setw(10) << "dif. max" << endl;
+
+	for (const string& file : files)
+	{
+		DecodedImage image;
+		if (!decodeImage(file, image))
+		{
+			cout << "Erro ao tentar ler o arquivo " << file << endl;
+			continue;
+		}
+		if (image.channels != 3 && image.channels != 4)
+		{
+			freeImage(image);
+			decodeImage(file, image, 4);
+		}
+
+		int width, height;
+		fitImageSize(image.width, image.height, maxSize, width, height);
+		string name = file.substr(file.size() > 39 ? file.size() - 39 : 0);
+		if (width == image.width && height == image.height)
+		{
+			cout << left << setw(40) << name << right << " ja cabe no limite (" << image.width << "x" << image.height << ")" << endl;
+			freeImage(image);
+			continue;
+		}
+
+		// Melhor tempo de cada versão; as saídas são comparadas com a escalar
+		double milliseconds[3] = { 0.0, 0.0, 0.0 };
+		int difference = 0;
+		vector<unsigned char> reference, out;
+		for (int simd = MIP_SIMD_SCALAR; simd <= best; simd++)
+		{
+			double bestTime = 1e30;
+			for (int r = 0; r < repetitions; r++)
+			{
+				Clock::time_point start = Clock::now();
+				resampleImage(image.data, image.width, image.height, image.channels, width, height, out, (MipSimd)simd);
+				bestTime = std::min(bestTime, chrono::duration<double, milli>(Clock::now() - start).count());
+			}
+			milliseconds[simd] = bestTime;
+			if (simd == MIP_SIMD_SCALAR)
+				reference = out;
+			for (size_t i = 0; i < out.size(); i++)
+				difference = std::max(difference, abs((int)out[i] - (int)reference[i]));
+		}
+		cout << left << setw(40) << name << right
+			<< setw(14) << (to_string(image.width) + "x" + to_string(image.height) + ">" + to_string(width) + "x" + to_string(height))
+			<< fixed << setprecision(2) << setw(12) << milliseconds[MIP_SIMD_SCALAR] << setw(10) << milliseconds[MIP_SIMD_SSE2]
+			<< setw(10) << milliseconds[MIP_SIMD_AVX2] << setw(9) << milliseconds[MIP_SIMD_SCALAR] / milliseconds[best] << "x"
+			<< setw(10) << difference << defaultfloat << setprecision(6) << endl;
+		freeImage(image);
+
+		// Carga sem o limite e com ele: primeira execução (decodificar, reduzir, gerar e
+		// gravar) e seguintes (ler o arquivo .mips)
+		for (int limit : { 0, maxSize })
+		{
+			MipChain chain;
+			filesystem::remove(mipChainPath(file, limit));
+			Clock::time_point start = Clock::now();
+			prepareMipChain(file, MIP_FILTER_BOX, chain, limit);
+			double generated = chrono::duration<double, milli>(Clock::now() - start).count();
+			start = Clock::now();
+			bool cached = prepareMipChain(file, MIP_FILTER_BOX, chain, limit) && chain.fromCache;
+			double loaded = chrono::duration<double, milli>(Clock::now() - start).count();
+			cout << "    " << (limit > 0 ? "limite " + to_string(limit) : string("sem limite")) << ": primeira carga "
+				<< fixed << setprecision(2) << generated << " ms, seguintes " << loaded << " ms" << (cached ? "" : " (FALHOU)")
+				<< ", " << chain.totalBytes() / 1024 << " KB" << defaultfloat << setprecision(6) << endl;
+		}
+	}
+}
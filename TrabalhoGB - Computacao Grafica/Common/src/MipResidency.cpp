@@ -0,0 +1,351 @@
+#include "MipResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+MipResidency::MipResidency(size_t budgetBytes, int tailSize)
+	: budgetBytes(budgetBytes), tailSize(std::max(1, tailSize))
+{
+}
+
+int MipResidency::addTexture(int width, int height, const vector<size_t>& levelBytes)
+{
+	Texture texture;
+	texture.levelBytes = levelBytes;
+	texture.lastNeeded.assign(levelBytes.size(), 0);
+
+	// Primeiro nível com os dois lados dentro do rabo (ou o último nível)
+	int levels = (int)levelBytes.size();
+	while (texture.tail + 1 < levels && (std::max(width, height) >> texture.tail) > tailSize)
+		texture.tail++;
+	texture.first = texture.tail;
+
+	textures.push_back(texture);
+	int id = (int)textures.size() - 1;
+	resident += residentBytes(id);
+	return id;
+}
+
+void MipResidency::removeTexture(int texture)
+{
+	Texture& entry = textures[texture];
+	resident -= residentBytes(texture);
+	if (entry.loading >= 0)
+		resident -= entry.levelBytes[entry.loading];
+	entry = Texture();
+}
+
+size_t MipResidency::residentBytes(int texture) const
+{
+	const Texture& entry = textures[texture];
+	size_t total = 0;
+	for (size_t level = entry.first; level < entry.levelBytes.size(); level++)
+		total += entry.levelBytes[level];
+	return total;
+}
+
+float MipResidency::requiredLevel(int width, int height, float projectedPixels)
+{
+	float size = (float)std::max(1, std::max(width, height));
+	if (projectedPixels <= 1.0f)
+		return std::log2(size);
+	return std::max(0.0f, std::log2(size / projectedPixels));
+}
+
+void MipResidency::require(int texture, float level)
+{
+	Texture& entry = textures[texture];
+	if (entry.levelBytes.empty())
+		return;
+
+	int needed = std::min((int)std::floor(std::max(0.0f, level)), entry.tail);
+	if (entry.wanted < 0 || needed < entry.wanted)
+		entry.wanted = needed;
+	for (size_t i = needed; i < entry.lastNeeded.size(); i++)
+		entry.lastNeeded[i] = frame;
+}
+
+bool MipResidency::evictOldest(uint64_t limit, vector<Action>& actions)
+{
+	// Só o primeiro nível residente de cada textura pode sair (os residentes ficam
+	// contíguos); empate: o nível maior sai primeiro
+	int victim = -1;
+	for (int id = 0; id < (int)textures.size(); id++)
+	{
+		const Texture& entry = textures[id];
+		if (entry.first >= entry.tail || entry.loading >= 0 || entry.lastNeeded[entry.first] >= limit)
+			continue;
+		if (victim < 0)
+		{
+			victim = id;
+			continue;
+		}
+		const Texture& best = textures[victim];
+		uint64_t age = entry.lastNeeded[entry.first], bestAge = best.lastNeeded[best.first];
+		if (age < bestAge || (age == bestAge && entry.levelBytes[entry.first] > best.levelBytes[best.first]))
+			victim = id;
+	}
+	if (victim < 0)
+		return false;
+
+	Texture& entry = textures[victim];
+	actions.push_back({ MIP_EVICT, victim, entry.first });
+	resident -= entry.levelBytes[entry.first];
+	entry.first++;
+	evictionCount++;
+	return true;
+}
+
+void MipResidency::schedule(size_t uploadBudget, vector<Action>& actions)
+{
+	actions.clear();
+
+	// Orçamento reduzido: sai o que foi pedido há mais tempo, mesmo que ainda seja usado
+	while (resident > budgetBytes && evictOldest(frame + 1, actions))
+	{
+	}
+
+	// Texturas abaixo do nível pedido, as mais distantes dele primeiro; no empate, a
+	// carga menor primeiro
+	vector<int> candidates;
+	for (int id = 0; id < (int)textures.size(); id++)
+	{
+		const Texture& entry = textures[id];
+		if (entry.wanted >= 0 && entry.wanted < entry.first && entry.loading < 0)
+			candidates.push_back(id);
+	}
+	stable_sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+		const Texture& ta = textures[a];
+		const Texture& tb = textures[b];
+		int missingA = ta.first - ta.wanted, missingB = tb.first - tb.wanted;
+		if (missingA != missingB)
+			return missingA > missingB;
+		return ta.levelBytes[ta.first - 1] < tb.levelBytes[tb.first - 1];
+	});
+
+	size_t spent = 0;
+	for (int id : candidates)
+	{
+		if (spent > 0 && spent >= uploadBudget)
+			break;
+
+		// Abre espaço só com níveis que nenhum objeto pediu neste frame, para duas
+		// texturas visíveis não se revezarem no orçamento
+		Texture& entry = textures[id];
+		int level = entry.first - 1;
+		size_t bytes = entry.levelBytes[level];
+		while (resident + bytes > budgetBytes && evictOldest(frame, actions))
+		{
+		}
+		if (resident + bytes > budgetBytes)
+			continue;
+
+		actions.push_back({ MIP_LOAD, id, level });
+		entry.loading = level;
+		resident += bytes;
+		spent += bytes;
+		loadCount++;
+	}
+
+	for (Texture& entry : textures)
+	{
+		entry.lastWanted = entry.wanted;
+		entry.wanted = -1;
+	}
+	frame++;
+}
+
+void MipResidency::loaded(int texture, int level)
+{
+	Texture& entry = textures[texture];
+	if (entry.loading != level)
+		return;
+	entry.first = level;
+	entry.loading = -1;
+}
+
+MipResidency::Stats MipResidency::stats() const
+{
+	Stats stats;
+	stats.residentBytes = resident;
+	stats.budgetBytes = budgetBytes;
+	stats.loads = loadCount;
+	stats.evictions = evictionCount;
+	for (const Texture& entry : textures)
+	{
+		if (entry.levelBytes.empty())
+			continue;
+		stats.textures++;
+		int needed = entry.lastWanted >= 0 ? entry.lastWanted : entry.tail;
+		for (size_t level = 0; level < entry.levelBytes.size(); level++)
+		{
+			stats.fullBytes += entry.levelBytes[level];
+			if ((int)level >= needed)
+				stats.requiredBytes += entry.levelBytes[level];
+		}
+		if (entry.lastWanted >= 0)
+		{
+			stats.requested++;
+			if (entry.first <= entry.lastWanted)
+				stats.satisfied++;
+		}
+	}
+	return stats;
+}
+
+void MipResidency::report(ostream& out) const
+{
+	Stats current = stats();
+	out << "Mipmaps residentes: " << current.residentBytes / 1024 << " KB de " << current.budgetBytes / 1024
+		<< " KB do orcamento (pedidos: " << current.requiredBytes / 1024 << " KB, todos os niveis: "
+		<< current.fullBytes / 1024 << " KB), " << current.satisfied << "/" << current.requested
+		<< " textura(s) no nivel pedido, " << current.loads << " carga(s), " << current.evictions << " descarte(s)" << endl;
+}
+
+namespace
+{
+	// Níveis de uma imagem RGBA8 quadrada de lado size, do maior para 1x1
+	vector<size_t> squareLevels(int size)
+	{
+		vector<size_t> levels;
+		for (int side = size; ; side /= 2)
+		{
+			levels.push_back((size_t)side * side * 4);
+			if (side == 1)
+				break;
+		}
+		return levels;
+	}
+
+	// Agenda e conclui todas as cargas até o agendador parar de pedir
+	int settle(MipResidency& residency, const vector<int>& visible, int level, size_t uploadBudget = 1 << 30)
+	{
+		vector<MipResidency::Action> actions;
+		int frames = 0;
+		for (; frames < 64; frames++)
+		{
+			for (int texture : visible)
+				residency.require(texture, (float)level);
+			residency.schedule(uploadBudget, actions);
+			bool loading = false;
+			for (const MipResidency::Action& action : actions)
+			{
+				if (action.type == MipResidency::MIP_LOAD)
+				{
+					residency.loaded(action.texture, action.level);
+					loading = true;
+				}
+			}
+			if (!loading)
+				break;
+		}
+		return frames;
+	}
+}
+
+bool checkMipResidency()
+{
+	bool allPassed = true;
+	auto check = [&allPassed](bool passed, const char* description) {
+		cout << (passed ? "ok      " : "FALHOU  ") << description << endl;
+		allPassed = allPassed && passed;
+	};
+
+	const vector<size_t> levels1024 = squareLevels(1024);  // 11 níveis
+	size_t tailBytes = 0;
+	for (size_t level = 3; level < levels1024.size(); level++)
+		tailBytes += levels1024[level];
+
+	{
+		MipResidency residency(64 << 20, 128);
+		int texture = residency.addTexture(1024, 1024, levels1024);
+		check(residency.firstResident(texture) == 3 && residency.stats().residentBytes == tailBytes,
+			"a textura comeca so com os niveis de ate 128x128");
+
+		vector<MipResidency::Action> actions;
+		residency.schedule(1 << 30, actions);
+		check(actions.empty(), "sem pedidos nada e carregado");
+
+		check(MipResidency::requiredLevel(2048, 1024, 200.0f) > 3.0f && MipResidency::requiredLevel(2048, 1024, 200.0f) < 4.0f &&
+			MipResidency::requiredLevel(2048, 1024, 4096.0f) == 0.0f, "nivel pedido pelo tamanho projetado (2048 em 200 px: entre 3 e 4)");
+
+		residency.require(texture, 1.5f);
+		residency.schedule(1 << 30, actions);
+		check(actions.size() == 1 && actions[0].type == MipResidency::MIP_LOAD && actions[0].level == 2,
+			"o nivel 1 e pedido do mais grosso para o mais fino: primeiro o 2");
+		residency.require(texture, 1.5f);
+		residency.schedule(1 << 30, actions);
+		check(actions.empty(), "uma carga por textura de cada vez");
+		residency.loaded(texture, 2);
+		settle(residency, { texture }, 1);
+		check(residency.firstResident(texture) == 1 && residency.stats().satisfied == 1, "depois das cargas o nivel pedido fica residente");
+
+		settle(residency, { texture }, 5);
+		check(residency.firstResident(texture) == 1 && residency.stats().evictions == 0, "dentro do orcamento nada e descartado");
+	}
+
+	{
+		// Orçamento para o rabo das duas texturas e os níveis 0-2 de uma só
+		size_t fullBytes = 0;
+		for (size_t bytes : levels1024)
+			fullBytes += bytes;
+		MipResidency residency(fullBytes + tailBytes, 128);
+		int a = residency.addTexture(1024, 1024, levels1024);
+		int b = residency.addTexture(1024, 1024, levels1024);
+
+		settle(residency, { a }, 0);
+		check(residency.firstResident(a) == 0 && residency.firstResident(b) == 3, "a textura visivel carrega ate o nivel 0");
+
+		settle(residency, { b }, 0);
+		check(residency.firstResident(b) == 0 && residency.firstResident(a) == 3 && residency.stats().residentBytes <= residency.budget(),
+			"a textura que deixou de ser vista cede o orcamento");
+
+		settle(residency, { a, b }, 0);
+		vector<MipResidency::Action> actions;
+		residency.require(a, 0.0f);
+		residency.require(b, 0.0f);
+		residency.schedule(1 << 30, actions);
+		check(actions.empty() && residency.stats().residentBytes <= residency.budget(),
+			"duas texturas visiveis que nao cabem nao se revezam");
+
+		residency.setBudget(2 * tailBytes);
+		residency.schedule(1 << 30, actions);
+		check(residency.stats().residentBytes == 2 * tailBytes && residency.firstResident(a) == 3 && residency.firstResident(b) == 3,
+			"com o orcamento reduzido sobram so os niveis pequenos");
+
+		residency.setBudget(0);
+		residency.schedule(1 << 30, actions);
+		check(actions.empty() && residency.stats().residentBytes == 2 * tailBytes, "os niveis pequenos nunca sao descartados");
+	}
+
+	{
+		// Orçamento de envio por frame: várias texturas pedindo, uma carga por frame
+		MipResidency residency(64 << 20, 128);
+		vector<int> visible;
+		for (int i = 0; i < 4; i++)
+			visible.push_back(residency.addTexture(1024, 1024, levels1024));
+		vector<MipResidency::Action> actions;
+		for (int texture : visible)
+			residency.require(texture, 0.0f);
+		residency.schedule(1, actions);
+		check(actions.size() == 1, "o limite de bytes por frame deixa passar uma carga");
+		residency.loaded(actions[0].texture, actions[0].level);
+
+		int frames = settle(residency, visible, 0, levels1024[0]);
+		check(residency.stats().satisfied == 4 && frames <= 12, "as cargas terminam em poucos frames");
+	}
+
+	{
+		// Imagem menor que o rabo: nada a gerenciar
+		MipResidency residency(64 << 20, 128);
+		int texture = residency.addTexture(64, 64, squareLevels(64));
+		vector<MipResidency::Action> actions;
+		residency.require(texture, 0.0f);
+		residency.schedule(1 << 30, actions);
+		check(residency.firstResident(texture) == 0 && actions.empty(), "imagem pequena fica inteira desde o inicio");
+	}
+
+	return allPassed;
+}
@@ -0,0 +1,1156 @@
+#include "OBJLoader.h"
+#include "MappedFile.h"
+#include "MemoryStats.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+	inline bool isBlank(char c) { return c == ' ' || c == '\t'; }
+	inline bool isLineEnd(char c) { return c == '\n' || c == '\r'; }
+
+	inline const char* skipBlanks(const char* p, const char* end)
+	{
+		while (p < end && isBlank(*p))
+			++p;
+		return p;
+	}
+
+	inline const char* skipLine(const char* p, const char* end)
+	{
+		while (p < end && *p != '\n')
+			++p;
+		return p < end ? p + 1 : end;
+	}
+
+	inline const char* skipToken(const char* p, const char* end)
+	{
+		while (p < end && !isBlank(*p) && !isLineEnd(*p))
+			++p;
+		return p;
+	}
+
+	// Lê um float; em caso de falha o valor fica zero, como no operator>> do istream
+	inline const char* parseFloat(const char* p, const char* end, float& value)
+	{
+		p = skipBlanks(p, end);
+		if (p < end && *p == '+')
+			++p;
+		from_chars_result result = from_chars(p, end, value);
+		if (result.ec != errc())
+		{
+			value = 0.0f;
+			return p;
+		}
+		return result.ptr;
+	}
+
+	// Lê um inteiro com sinal; retorna nullptr se não houver dígitos
+	inline const char* parseInt(const char* p, const char* end, int& value)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = (*p == '-');
+			++p;
+		}
+		if (p >= end || *p < '0' || *p > '9')
+			return nullptr;
+
+		int result = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			result = result * 10 + (*p - '0');
+			++p;
+		}
+		value = negative ? -result : result;
+		return p;
+	}
+
+	// Converte o índice do .obj (base 1, ou negativo = relativo ao fim) para base 0
+	inline int resolveIndex(int index, size_t count)
+	{
+		if (index > 0)
+			return index - 1;
+		if (index < 0)
+			return (int)count + index;
+		return -1;
+	}
+}
+
+namespace
+{
+	// Lê um canto de face (v, v/t, v//n ou v/t/n); índices ausentes ficam zero.
+	// Retorna nullptr se o token não começa com um número
+	inline const char* parseCorner(const char* p, const char* end, int& v, int& t, int& n)
+	{
+		v = t = n = 0;
+		const char* next = parseInt(p, end, v);
+		if (next == nullptr)
+			return nullptr;
+		p = next;
+		if (p < end && *p == '/')
+		{
+			++p;
+			if (p < end && *p != '/')
+			{
+				next = parseInt(p, end, t);
+				if (next != nullptr)
+					p = next;
+			}
+			if (p < end && *p == '/')
+			{
+				++p;
+				next = parseInt(p, end, n);
+				if (next != nullptr)
+					p = next;
+			}
+		}
+		return skipToken(p, end);
+	}
+
+	// Nome do material de um usemtl: o resto da linha, sem espaços nas pontas
+	inline string parseMaterialName(const char* p, const char* end)
+	{
+		p = skipBlanks(p, end);
+		const char* nameEnd = p;
+		while (nameEnd < end && !isLineEnd(*nameEnd) && *nameEnd != '#')
+			++nameEnd;
+		while (nameEnd > p && isBlank(nameEnd[-1]))
+			--nameEnd;
+		return string(p, nameEnd);
+	}
+
+	// Começa um novo trecho de material no elemento first; um trecho ainda vazio
+	// é só renomeado (usemtl seguidos, ou usemtl antes da primeira face)
+	inline void beginSubMesh(vector<SubMesh>& submeshes, const string& material, unsigned int first)
+	{
+		if (!submeshes.empty() && submeshes.back().first == first)
+			submeshes.back().material = material;
+		else
+			submeshes.push_back({ material, first, 0 });
+	}
+
+	// Calcula o tamanho de cada trecho a partir do início do seguinte
+	inline void finishSubMeshes(vector<SubMesh>& submeshes, unsigned int elementCount)
+	{
+		if (!submeshes.empty() && submeshes.back().first == elementCount && submeshes.size() > 1)
+			submeshes.pop_back();
+		for (size_t i = 0; i < submeshes.size(); i++)
+		{
+			unsigned int next = (i + 1 < submeshes.size()) ? submeshes[i + 1].first : elementCount;
+			submeshes[i].count = next - submeshes[i].first;
+		}
+	}
+
+	// Reordena os elementos para que cada material ocupe um único trecho contínuo.
+	// Na malha indexada só os índices mudam de lugar; na não indexada, os vértices
+	void groupSubMeshesByMaterial(MeshData& mesh)
+	{
+		vector<SubMesh>& runs = mesh.submeshes;
+
+		vector<SubMesh> grouped;
+		vector<vector<size_t>> runsOfMaterial;
+		for (size_t r = 0; r < runs.size(); r++)
+		{
+			size_t m = 0;
+			while (m < grouped.size() && grouped[m].material != runs[r].material)
+				m++;
+			if (m == grouped.size())
+			{
+				grouped.push_back({ runs[r].material, 0, 0 });
+				runsOfMaterial.emplace_back();
+			}
+			runsOfMaterial[m].push_back(r);
+		}
+		if (grouped.size() == runs.size())
+			return;
+
+		if (mesh.indices.empty())
+		{
+			// Malha não indexada: permuta os vértices no próprio buffer seguindo os ciclos
+			// da permutação, sem uma segunda cópia dos vértices
+			vector<unsigned int> destination(mesh.vertexCount());
+			unsigned int first = 0;
+			for (size_t m = 0; m < grouped.size(); m++)
+			{
+				grouped[m].first = first;
+				for (size_t r : runsOfMaterial[m])
+				{
+					for (unsigned int i = 0; i < runs[r].count; i++)
+						destination[runs[r].first + i] = first + i;
+					first += runs[r].count;
+				}
+				grouped[m].count = first - grouped[m].first;
+			}
+
+			float* vertices = mesh.vertices.data();
+			for (size_t i = 0; i < destination.size(); i++)
+			{
+				while (destination[i] != i)
+				{
+					unsigned int j = destination[i];
+					swap_ranges(vertices + i * OBJ_FLOATS_PER_VERTEX, vertices + (i + 1) * OBJ_FLOATS_PER_VERTEX, vertices + (size_t)j * OBJ_FLOATS_PER_VERTEX);
+					swap(destination[i], destination[j]);
+				}
+			}
+			runs.swap(grouped);
+			return;
+		}
+
+		vector<unsigned int> indices;
+		indices.reserve(mesh.indices.size());
+		unsigned int first = 0;
+		for (size_t m = 0; m < grouped.size(); m++)
+		{
+			grouped[m].first = first;
+			for (size_t r : runsOfMaterial[m])
+			{
+				indices.insert(indices.end(), mesh.indices.begin() + runs[r].first, mesh.indices.begin() + runs[r].first + runs[r].count);
+				first += runs[r].count;
+			}
+			grouped[m].count = first - grouped[m].first;
+		}
+
+		mesh.indices.swap(indices);
+		runs.swap(grouped);
+	}
+
+	inline bool isValidCorner(int vi, int ti, int ni, size_t nPositions, size_t nTexCoords, size_t nNormals)
+	{
+		return vi >= 0 && vi < (int)nPositions && ti < (int)nTexCoords && ni < (int)nNormals;
+	}
+
+	// Escreve os OBJ_FLOATS_PER_VERTEX floats do vértice em out
+	inline void writeVertex(float* out, const float* positions, const float* texCoords, const float* normals, int vi, int ti, int ni)
+	{
+		//Atributo posição
+		out[0] = positions[vi * 3 + 0];
+		out[1] = positions[vi * 3 + 1];
+		out[2] = positions[vi * 3 + 2];
+
+		//Atributo cor
+		out[3] = 1.0f;
+		out[4] = 0.0f;
+		out[5] = 0.0f;
+
+		//Atributo coordenada de textura (zero se a face não referencia uma)
+		out[6] = ti >= 0 ? texCoords[ti * 2 + 0] : 0.0f;
+		out[7] = ti >= 0 ? texCoords[ti * 2 + 1] : 0.0f;
+
+		//Atributo vetor normal
+		out[8] = ni >= 0 ? normals[ni * 3 + 0] : 0.0f;
+		out[9] = ni >= 0 ? normals[ni * 3 + 1] : 0.0f;
+		out[10] = ni >= 0 ? normals[ni * 3 + 2] : 0.0f;
+	}
+
+	// Quantidade de cada registro do arquivo (primeira passada do parser sequencial)
+	struct OBJCounts
+	{
+		size_t positions = 0, texCoords = 0, normals = 0, corners = 0;
+	};
+
+	OBJCounts countOBJRecords(const char* begin, const char* end)
+	{
+		OBJCounts counts;
+		const char* p = begin;
+		while (p < end)
+		{
+			p = skipBlanks(p, end);
+			if (p + 1 < end && p[0] == 'v' && isBlank(p[1]))
+			{
+				counts.positions++;
+			}
+			else if (p + 2 < end && p[0] == 'v' && isBlank(p[2]))
+			{
+				counts.texCoords += (p[1] == 't');
+				counts.normals += (p[1] == 'n');
+			}
+			else if (p + 1 < end && p[0] == 'f' && isBlank(p[1]))
+			{
+				// Um canto por token até o fim da linha ou comentário
+				p++;
+				while (true)
+				{
+					p = skipBlanks(p, end);
+					if (p >= end || isLineEnd(*p) || *p == '#')
+						break;
+					counts.corners++;
+					p = skipToken(p, end);
+				}
+			}
+			p = skipLine(p, end);
+		}
+		return counts;
+	}
+
+	bool parseOBJMeshSequential(const char* begin, const char* end, MeshData& mesh, const OBJLoadOptions& options, const string& sourceName)
+	{
+		vector<float>& vBuffer = mesh.vertices;
+
+		vector<float> positions;
+		vector<float> texCoords;
+		vector<float> normals;
+
+		// Deduplicação: para cada posição, uma lista encadeada dos vértices únicos que a
+		// usam (com textura e normal). Os vértices são numerados na ordem da primeira
+		// ocorrência e só são escritos no fim, quando a quantidade exata é conhecida
+		struct UniqueCorner { int v, t, n, next; };
+		vector<UniqueCorner> uniqueCorners;
+		vector<int> firstCornerOfPosition;
+		const unsigned int baseVertex = (unsigned int)mesh.vertexCount();
+
+		if (options.countFirst)
+		{
+			OBJCounts counts = countOBJRecords(begin, end);
+			positions.reserve(counts.positions * 3);
+			texCoords.reserve(counts.texCoords * 2);
+			normals.reserve(counts.normals * 3);
+			if (options.indexed)
+			{
+				firstCornerOfPosition.reserve(counts.positions);
+				mesh.indices.reserve(mesh.indices.size() + counts.corners);
+			}
+			else
+			{
+				vBuffer.reserve(vBuffer.size() + counts.corners * OBJ_FLOATS_PER_VERTEX);
+			}
+		}
+
+		// Elementos já gerados: índices (malha indexada) ou vértices
+		auto elementCount = [&mesh, &options]() {
+			return (unsigned int)(options.indexed ? mesh.indices.size() : mesh.vertexCount());
+		};
+		beginSubMesh(mesh.submeshes, "", 0);
+
+		const char* p = begin;
+		while (p < end)
+		{
+			p = skipBlanks(p, end);
+			if (p >= end)
+				break;
+
+			const char* keyword = p;
+			p = skipToken(p, end);
+			size_t keywordLength = p - keyword;
+
+			if (keywordLength == 1 && keyword[0] == 'v')
+			{
+				float x, y, z;
+				p = parseFloat(p, end, x);
+				p = parseFloat(p, end, y);
+				p = parseFloat(p, end, z);
+				positions.push_back(x);
+				positions.push_back(y);
+				positions.push_back(z);
+				if (options.indexed)
+					firstCornerOfPosition.push_back(-1);
+			}
+			else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 't')
+			{
+				float s, t;
+				p = parseFloat(p, end, s);
+				p = parseFloat(p, end, t);
+				texCoords.push_back(s);
+				texCoords.push_back(t);
+			}
+			else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 'n')
+			{
+				float x, y, z;
+				p = parseFloat(p, end, x);
+				p = parseFloat(p, end, y);
+				p = parseFloat(p, end, z);
+				normals.push_back(x);
+				normals.push_back(y);
+				normals.push_back(z);
+			}
+			else if (keywordLength == 1 && keyword[0] == 'f')
+			{
+				size_t nPositions = positions.size() / 3;
+				size_t nTexCoords = texCoords.size() / 2;
+				size_t nNormals = normals.size() / 3;
+
+				while (true)
+				{
+					p = skipBlanks(p, end);
+					if (p >= end || isLineEnd(*p) || *p == '#')
+						break;
+
+					int v, t, n;
+					const char* next = parseCorner(p, end, v, t, n);
+					if (next == nullptr)
+					{
+						p = skipToken(p, end);
+						continue;
+					}
+					p = next;
+
+					int vi = resolveIndex(v, nPositions);
+					int ti = resolveIndex(t, nTexCoords);
+					int ni = resolveIndex(n, nNormals);
+
+					if (!isValidCorner(vi, ti, ni, nPositions, nTexCoords, nNormals))
+					{
+						cout << "Indice de face invalido em " << sourceName << endl;
+						return false;
+					}
+
+					if (options.indexed)
+					{
+						// Reaproveita o vértice se a mesma tripla já apareceu
+						int corner = firstCornerOfPosition[vi];
+						while (corner >= 0 && (uniqueCorners[corner].t != ti || uniqueCorners[corner].n != ni))
+							corner = uniqueCorners[corner].next;
+						if (corner < 0)
+						{
+							corner = (int)uniqueCorners.size();
+							uniqueCorners.push_back({ vi, ti, ni, firstCornerOfPosition[vi] });
+							firstCornerOfPosition[vi] = corner;
+						}
+						mesh.indices.push_back(baseVertex + (unsigned int)corner);
+						continue;
+					}
+
+					vBuffer.resize(vBuffer.size() + OBJ_FLOATS_PER_VERTEX);
+					writeVertex(&vBuffer[vBuffer.size() - OBJ_FLOATS_PER_VERTEX], positions.data(), texCoords.data(), normals.data(), vi, ti, ni);
+				}
+			}
+			else if (keywordLength == 6 && memcmp(keyword, "usemtl", 6) == 0)
+			{
+				beginSubMesh(mesh.submeshes, parseMaterialName(p, end), elementCount());
+			}
+
+			// Ignora o resto da linha (comentários, mtllib, o, g, s...)
+			p = skipLine(p, end);
+		}
+
+		if (options.indexed)
+		{
+			// Os vértices únicos são escritos de uma vez, no tamanho exato
+			vector<int>().swap(firstCornerOfPosition);
+			vBuffer.reserve(vBuffer.size() + uniqueCorners.size() * OBJ_FLOATS_PER_VERTEX);
+			vBuffer.resize(vBuffer.size() + uniqueCorners.size() * OBJ_FLOATS_PER_VERTEX);
+			float* out = vBuffer.data() + (size_t)baseVertex * OBJ_FLOATS_PER_VERTEX;
+			for (const UniqueCorner& corner : uniqueCorners)
+			{
+				writeVertex(out, positions.data(), texCoords.data(), normals.data(), corner.v, corner.t, corner.n);
+				out += OBJ_FLOATS_PER_VERTEX;
+			}
+		}
+
+		finishSubMeshes(mesh.submeshes, elementCount());
+		return true;
+	}
+
+	// Resultado do parsing de um pedaço do arquivo. Os índices das faces ficam
+	// crus (como no arquivo); cada face guarda quantos atributos o pedaço já tinha
+	// lido até ela, para resolver índices negativos depois da soma de prefixos
+	struct OBJChunk
+	{
+		const char* begin;
+		const char* end;
+		vector<float> positions;
+		vector<float> texCoords;
+		vector<float> normals;
+		vector<int> corners;           // v, t, n crus de cada canto
+		vector<unsigned int> faces;    // por face: cantos, posições, texturas e normais locais até ela
+		vector<SubMesh> materials;     // usemtl do pedaço; first = cantos locais até ele
+
+		// Deslocamentos globais (soma de prefixos dos pedaços anteriores)
+		size_t positionOffset = 0, texCoordOffset = 0, normalOffset = 0, cornerOffset = 0;
+		bool valid = true;
+	};
+
+	void parseOBJChunk(OBJChunk& chunk)
+	{
+		const char* p = chunk.begin;
+		const char* end = chunk.end;
+		while (p < end)
+		{
+			p = skipBlanks(p, end);
+			if (p >= end)
+				break;
+
+			const char* keyword = p;
+			p = skipToken(p, end);
+			size_t keywordLength = p - keyword;
+
+			if (keywordLength == 1 && keyword[0] == 'v')
+			{
+				float x, y, z;
+				p = parseFloat(p, end, x);
+				p = parseFloat(p, end, y);
+				p = parseFloat(p, end, z);
+				chunk.positions.push_back(x);
+				chunk.positions.push_back(y);
+				chunk.positions.push_back(z);
+			}
+			else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 't')
+			{
+				float s, t;
+				p = parseFloat(p, end, s);
+				p = parseFloat(p, end, t);
+				chunk.texCoords.push_back(s);
+				chunk.texCoords.push_back(t);
+			}
+			else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 'n')
+			{
+				float x, y, z;
+				p = parseFloat(p, end, x);
+				p = parseFloat(p, end, y);
+				p = parseFloat(p, end, z);
+				chunk.normals.push_back(x);
+				chunk.normals.push_back(y);
+				chunk.normals.push_back(z);
+			}
+			else if (keywordLength == 1 && keyword[0] == 'f')
+			{
+				unsigned int cornerCount = 0;
+				while (true)
+				{
+					p = skipBlanks(p, end);
+					if (p >= end || isLineEnd(*p) || *p == '#')
+						break;
+
+					int v, t, n;
+					const char* next = parseCorner(p, end, v, t, n);
+					if (next == nullptr)
+					{
+						p = skipToken(p, end);
+						continue;
+					}
+					p = next;
+					chunk.corners.push_back(v);
+					chunk.corners.push_back(t);
+					chunk.corners.push_back(n);
+					cornerCount++;
+				}
+				chunk.faces.push_back(cornerCount);
+				chunk.faces.push_back((unsigned int)(chunk.positions.size() / 3));
+				chunk.faces.push_back((unsigned int)(chunk.texCoords.size() / 2));
+				chunk.faces.push_back((unsigned int)(chunk.normals.size() / 3));
+			}
+			else if (keywordLength == 6 && memcmp(keyword, "usemtl", 6) == 0)
+			{
+				chunk.materials.push_back({ parseMaterialName(p, end), (unsigned int)(chunk.corners.size() / 3), 0 });
+			}
+
+			p = skipLine(p, end);
+		}
+	}
+
+	// Converte os índices crus do pedaço para índices globais (base 0) e valida
+	void resolveOBJChunk(OBJChunk& chunk, int* resolved)
+	{
+		const int* raw = chunk.corners.data();
+		for (size_t f = 0; f < chunk.faces.size(); f += 4)
+		{
+			unsigned int cornerCount = chunk.faces[f];
+			size_t nPositions = chunk.positionOffset + chunk.faces[f + 1];
+			size_t nTexCoords = chunk.texCoordOffset + chunk.faces[f + 2];
+			size_t nNormals = chunk.normalOffset + chunk.faces[f + 3];
+
+			for (unsigned int c = 0; c < cornerCount; c++)
+			{
+				int vi = resolveIndex(raw[0], nPositions);
+				int ti = resolveIndex(raw[1], nTexCoords);
+				int ni = resolveIndex(raw[2], nNormals);
+				if (!isValidCorner(vi, ti, ni, nPositions, nTexCoords, nNormals))
+					chunk.valid = false;
+				resolved[0] = vi;
+				resolved[1] = ti;
+				resolved[2] = ni;
+				raw += 3;
+				resolved += 3;
+			}
+		}
+	}
+}
+
+bool parseOBJMeshParallel(const char* begin, const char* end, MeshData& mesh, const OBJLoadOptions& options, const string& sourceName, ThreadPool& pool)
+{
+	// 1. Divide o arquivo em pedaços que terminam em fim de linha
+	const size_t minChunkBytes = 256 * 1024;
+	size_t totalBytes = end - begin;
+	size_t nChunks = (size_t)(pool.size() + 1) * 4;
+	nChunks = max((size_t)1, min(nChunks, totalBytes / minChunkBytes));
+
+	vector<OBJChunk> chunks(nChunks);
+	const char* chunkBegin = begin;
+	for (size_t i = 0; i < nChunks; i++)
+	{
+		const char* chunkEnd = (i + 1 == nChunks) ? end : begin + totalBytes * (i + 1) / nChunks;
+		if (chunkEnd < chunkBegin)
+			chunkEnd = chunkBegin;
+		while (chunkEnd < end && chunkEnd[-1] != '\n')
+			++chunkEnd;
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	// 2. Parsing de cada pedaço em paralelo
+	pool.parallelFor(nChunks, [&chunks](size_t i) { parseOBJChunk(chunks[i]); });
+
+	// 3. Soma de prefixos: onde os atributos e cantos de cada pedaço entram no resultado
+	size_t nPositions = 0, nTexCoords = 0, nNormals = 0, nCorners = 0;
+	for (OBJChunk& chunk : chunks)
+	{
+		chunk.positionOffset = nPositions;
+		chunk.texCoordOffset = nTexCoords;
+		chunk.normalOffset = nNormals;
+		chunk.cornerOffset = nCorners;
+		nPositions += chunk.positions.size() / 3;
+		nTexCoords += chunk.texCoords.size() / 2;
+		nNormals += chunk.normals.size() / 3;
+		nCorners += chunk.corners.size() / 3;
+	}
+
+	// 4. Junta os atributos em ordem e resolve os índices (inclusive os negativos)
+	vector<float> positions(nPositions * 3), texCoords(nTexCoords * 2), normals(nNormals * 3);
+	vector<int> corners(nCorners * 3);
+	pool.parallelFor(nChunks, [&](size_t i)
+	{
+		OBJChunk& chunk = chunks[i];
+		copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionOffset * 3);
+		copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordOffset * 2);
+		copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalOffset * 3);
+		resolveOBJChunk(chunk, corners.data() + chunk.cornerOffset * 3);
+		vector<float>().swap(chunk.positions);
+		vector<float>().swap(chunk.texCoords);
+		vector<float>().swap(chunk.normals);
+		vector<int>().swap(chunk.corners);
+	});
+
+	for (const OBJChunk& chunk : chunks)
+	{
+		if (!chunk.valid)
+		{
+			cout << "Indice de face invalido em " << sourceName << endl;
+			return false;
+		}
+	}
+
+	// Trechos de material: cada canto vira um elemento (índice ou vértice), então os
+	// deslocamentos em cantos valem para as duas formas da malha
+	beginSubMesh(mesh.submeshes, "", 0);
+	for (const OBJChunk& chunk : chunks)
+	{
+		for (const SubMesh& material : chunk.materials)
+			beginSubMesh(mesh.submeshes, material.material, (unsigned int)(chunk.cornerOffset + material.first));
+	}
+	finishSubMeshes(mesh.submeshes, (unsigned int)nCorners);
+
+	// Faixas de cantos processadas por tarefa nas etapas seguintes
+	size_t nRanges = min(nCorners, (size_t)(pool.size() + 1) * 4);
+	nRanges = max(nRanges, (size_t)1);
+	auto rangeBegin = [nCorners, nRanges](size_t r) { return nCorners * r / nRanges; };
+
+	if (!options.indexed)
+	{
+		// 5a. Um vértice por canto: cada faixa escreve direto na sua posição final
+		mesh.vertices.resize(nCorners * OBJ_FLOATS_PER_VERTEX);
+		pool.parallelFor(nRanges, [&](size_t r)
+		{
+			for (size_t c = rangeBegin(r); c < rangeBegin(r + 1); c++)
+			{
+				const int* corner = &corners[c * 3];
+				writeVertex(&mesh.vertices[c * OBJ_FLOATS_PER_VERTEX], positions.data(), texCoords.data(), normals.data(), corner[0], corner[1], corner[2]);
+			}
+		});
+		return true;
+	}
+
+	// 5b. Deduplicação paralela com a mesma numeração do parser sequencial (ordem da
+	// primeira ocorrência). Cada tarefa é dona das posições vi % nOwners e marca, para
+	// os cantos dessas posições, qual canto anterior tem a mesma tripla
+	size_t nOwners = (size_t)pool.size() + 1;
+	vector<unsigned int> firstCorner(nCorners);
+	vector<int> head(nPositions, -1);
+	pool.parallelFor(nOwners, [&](size_t owner)
+	{
+		struct Node { int t, n; unsigned int corner; int next; };
+		vector<Node> nodes;
+		for (size_t c = 0; c < nCorners; c++)
+		{
+			const int* corner = &corners[c * 3];
+			if ((size_t)corner[0] % nOwners != owner)
+				continue;
+
+			int node = head[corner[0]];
+			while (node >= 0 && (nodes[node].t != corner[1] || nodes[node].n != corner[2]))
+				node = nodes[node].next;
+
+			if (node >= 0)
+			{
+				firstCorner[c] = nodes[node].corner;
+			}
+			else
+			{
+				nodes.push_back({ corner[1], corner[2], (unsigned int)c, head[corner[0]] });
+				head[corner[0]] = (int)nodes.size() - 1;
+				firstCorner[c] = (unsigned int)c;
+			}
+		}
+	});
+
+	// Soma de prefixos das primeiras ocorrências: índice final de cada vértice único
+	vector<size_t> rangeUnique(nRanges + 1, 0);
+	pool.parallelFor(nRanges, [&](size_t r)
+	{
+		size_t count = 0;
+		for (size_t c = rangeBegin(r); c < rangeBegin(r + 1); c++)
+			count += (firstCorner[c] == c);
+		rangeUnique[r + 1] = count;
+	});
+	for (size_t r = 0; r < nRanges; r++)
+		rangeUnique[r + 1] += rangeUnique[r];
+
+	mesh.vertices.resize(rangeUnique[nRanges] * OBJ_FLOATS_PER_VERTEX);
+	mesh.indices.resize(nCorners);
+	pool.parallelFor(nRanges, [&](size_t r)
+	{
+		unsigned int nextVertex = (unsigned int)rangeUnique[r];
+		for (size_t c = rangeBegin(r); c < rangeBegin(r + 1); c++)
+		{
+			if (firstCorner[c] != c)
+				continue;
+			const int* corner = &corners[c * 3];
+			writeVertex(&mesh.vertices[(size_t)nextVertex * OBJ_FLOATS_PER_VERTEX], positions.data(), texCoords.data(), normals.data(), corner[0], corner[1], corner[2]);
+			mesh.indices[c] = nextVertex++;
+		}
+	});
+
+	// Atributos e cantos já foram consumidos: libera antes da última etapa
+	vector<float>().swap(positions);
+	vector<float>().swap(texCoords);
+	vector<float>().swap(normals);
+	vector<int>().swap(corners);
+	pool.parallelFor(nRanges, [&](size_t r)
+	{
+		for (size_t c = rangeBegin(r); c < rangeBegin(r + 1); c++)
+		{
+			if (firstCorner[c] != c)
+				mesh.indices[c] = mesh.indices[firstCorner[c]];
+		}
+	});
+
+	return true;
+}
+
+bool parseOBJMesh(const char* begin, const char* end, MeshData& mesh, const OBJLoadOptions& options, const string& sourceName)
+{
+	// Arquivos pequenos não compensam o custo de dividir e juntar os pedaços
+	bool parsed;
+	if (options.parallel && (size_t)(end - begin) >= OBJ_PARALLEL_MIN_BYTES && defaultThreadPool().size() > 0)
+		parsed = parseOBJMeshParallel(begin, end, mesh, options, sourceName, defaultThreadPool());
+	else
+		parsed = parseOBJMeshSequential(begin, end, mesh, options, sourceName);
+
+	if (parsed && options.groupByMaterial)
+		groupSubMeshesByMaterial(mesh);
+	return parsed;
+}
+
+bool loadOBJMesh(const string& filePath, MeshData& mesh, const OBJLoadOptions& options)
+{
+	MappedFile file;
+	if (!file.open(filePath))
+		return false;
+	return parseOBJMesh(file.begin(), file.end(), mesh, options, filePath);
+}
+
+bool loadOBJBuffer(const string& filePath, vector<float>& vBuffer)
+{
+	OBJLoadOptions options;
+	options.indexed = false;
+	options.groupByMaterial = false;
+
+	MeshData mesh;
+	mesh.vertices.swap(vBuffer);
+	bool loaded = loadOBJMesh(filePath, mesh, options);
+	vBuffer.swap(mesh.vertices);
+	return loaded;
+}
+
+bool loadOBJBufferStream(const string& filePath, vector<float>& vBuffer)
+{
+	vector <float> vertices;
+	vector <float> texCoords;
+	vector <float> normals;
+
+	const float color[3] = { 1.0f, 0.0f, 0.0f };
+
+	ifstream arqEntrada;
+
+	arqEntrada.open(filePath.c_str());
+	if (!arqEntrada.is_open())
+	{
+		cout << "Erro ao tentar ler o arquivo " << filePath << endl;
+		return false;
+	}
+
+	string line;
+	while (!arqEntrada.eof())
+	{
+		getline(arqEntrada, line);
+		istringstream ssline(line);
+		string word;
+		ssline >> word;
+		if (word == "v")
+		{
+			float x, y, z;
+			ssline >> x >> y >> z;
+			vertices.push_back(x);
+			vertices.push_back(y);
+			vertices.push_back(z);
+		}
+		if (word == "vt")
+		{
+			float s, t;
+			ssline >> s >> t;
+			texCoords.push_back(s);
+			texCoords.push_back(t);
+		}
+		if (word == "vn")
+		{
+			float x, y, z;
+			ssline >> x >> y >> z;
+			normals.push_back(x);
+			normals.push_back(y);
+			normals.push_back(z);
+		}
+		else if (word == "f")
+		{
+			while (ssline >> word)
+			{
+				int vi, ti, ni;
+				istringstream ss(word);
+				std::string index;
+
+				std::getline(ss, index, '/');
+				vi = std::stoi(index) - 1;
+
+				std::getline(ss, index, '/');
+				ti = std::stoi(index) - 1;
+
+				std::getline(ss, index);
+				ni = std::stoi(index) - 1;
+
+				vBuffer.push_back(vertices[vi * 3 + 0]);
+				vBuffer.push_back(vertices[vi * 3 + 1]);
+				vBuffer.push_back(vertices[vi * 3 + 2]);
+
+				vBuffer.push_back(color[0]);
+				vBuffer.push_back(color[1]);
+				vBuffer.push_back(color[2]);
+
+				vBuffer.push_back(texCoords[ti * 2 + 0]);
+				vBuffer.push_back(texCoords[ti * 2 + 1]);
+
+				vBuffer.push_back(normals[ni * 3 + 0]);
+				vBuffer.push_back(normals[ni * 3 + 1]);
+				vBuffer.push_back(normals[ni * 3 + 2]);
+			}
+		}
+	}
+
+	arqEntrada.close();
+	return true;
+}
+
+void benchmarkOBJLoaders(const vector<string>& files, int repetitions)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	cout << left << setw(40) << "Arquivo" << right
+		<< setw(12) << "MB"
+		<< setw(16) << "stream MB/s"
+		<< setw(16) << "mmap MB/s"
+		<< setw(10) << "ganho"
+		<< "  buffer" << endl;
+
+	for (const string& filePath : files)
+	{
+		MappedFile file;
+		if (!file.open(filePath))
+		{
+			cout << "Erro ao tentar ler o arquivo " << filePath << endl;
+			continue;
+		}
+		double megabytes = file.size() / (1024.0 * 1024.0);
+		file.close();
+
+		vector<float> streamBuffer, mappedBuffer;
+		double streamSeconds = 0.0, mappedSeconds = 0.0;
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			vector<float> vBuffer;
+			Clock::time_point start = Clock::now();
+			loadOBJBufferStream(filePath, vBuffer);
+			streamSeconds += chrono::duration<double>(Clock::now() - start).count();
+			if (i == 0)
+				streamBuffer.swap(vBuffer);
+		}
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			vector<float> vBuffer;
+			Clock::time_point start = Clock::now();
+			loadOBJBuffer(filePath, vBuffer);
+			mappedSeconds += chrono::duration<double>(Clock::now() - start).count();
+			if (i == 0)
+				mappedBuffer.swap(vBuffer);
+		}
+
+		double streamRate = megabytes * repetitions / streamSeconds;
+		double mappedRate = megabytes * repetitions / mappedSeconds;
+
+		cout << left << setw(40) << filePath.substr(filePath.find_last_of("/\\") + 1) << right << fixed
+			<< setw(12) << setprecision(3) << megabytes
+			<< setw(16) << setprecision(1) << streamRate
+			<< setw(16) << setprecision(1) << mappedRate
+			<< setw(9) << setprecision(1) << mappedRate / streamRate << "x"
+			<< "  " << (streamBuffer == mappedBuffer ? "identico" : "DIFERENTE") << endl;
+	}
+}
+
+namespace
+{
+	// Gera um .obj com várias cópias do original, deslocando os índices das faces.
+	// As cópias ímpares usam índices negativos (relativos) para exercitar esse caminho
+	bool writeEnlargedOBJ(const string& sourcePath, int copies, const string& outputPath)
+	{
+		MappedFile source;
+		if (!source.open(sourcePath))
+			return false;
+
+		size_t nPositions = 0, nTexCoords = 0, nNormals = 0;
+		for (const char* p = source.begin(); p < source.end(); p = skipLine(p, source.end()))
+		{
+			const char* line = skipBlanks(p, source.end());
+			if (source.end() - line > 2 && line[0] == 'v' && isBlank(line[1])) nPositions++;
+			else if (source.end() - line > 3 && line[0] == 'v' && line[1] == 't' && isBlank(line[2])) nTexCoords++;
+			else if (source.end() - line > 3 && line[0] == 'v' && line[1] == 'n' && isBlank(line[2])) nNormals++;
+		}
+
+		ofstream out(outputPath, ios::binary | ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		string face;
+		char number[16];
+		for (int copy = 0; copy < copies; copy++)
+		{
+			bool relative = (copy % 2) == 1;
+			size_t localPositions = 0, localTexCoords = 0, localNormals = 0;
+			const char* p = source.begin();
+			while (p < source.end())
+			{
+				const char* lineEnd = skipLine(p, source.end());
+				const char* line = skipBlanks(p, lineEnd);
+				if (lineEnd - line > 2 && line[0] == 'f' && isBlank(line[1]))
+				{
+					face = "f";
+					const char* c = line + 1;
+					while (true)
+					{
+						c = skipBlanks(c, lineEnd);
+						if (c >= lineEnd || isLineEnd(*c) || *c == '#')
+							break;
+						int v, t, n;
+						const char* next = parseCorner(c, lineEnd, v, t, n);
+						if (next == nullptr)
+						{
+							c = skipToken(c, lineEnd);
+							continue;
+						}
+						c = next;
+
+						// Índice global (base 1) na cópia atual, escrito como absoluto ou relativo
+						int indices[3] = { resolveIndex(v, localPositions), resolveIndex(t, localTexCoords), resolveIndex(n, localNormals) };
+						size_t counts[3] = { nPositions, nTexCoords, nNormals };
+						size_t locals[3] = { localPositions, localTexCoords, localNormals };
+						for (int k = 0; k < 3; k++)
+						{
+							if (k > 0)
+								face += '/';
+							if (indices[k] < 0)
+								continue;
+							long long global = (long long)counts[k] * copy + indices[k] + 1;
+							long long written = relative ? global - (long long)(counts[k] * copy + locals[k]) - 1 : global;
+							snprintf(number, sizeof(number), "%lld", written);
+							face = (k == 0 ? face + ' ' : face) + number;
+						}
+					}
+					face += '\n';
+					out.write(face.data(), face.size());
+				}
+				else
+				{
+					if (lineEnd - line > 2 && line[0] == 'v' && isBlank(line[1])) localPositions++;
+					else if (lineEnd - line > 3 && line[0] == 'v' && line[1] == 't' && isBlank(line[2])) localTexCoords++;
+					else if (lineEnd - line > 3 && line[0] == 'v' && line[1] == 'n' && isBlank(line[2])) localNormals++;
+					out.write(p, lineEnd - p);
+					if (lineEnd == source.end() && lineEnd > p && lineEnd[-1] != '\n')
+						out.put('\n');
+				}
+				p = lineEnd;
+			}
+		}
+		return out.good();
+	}
+}
+
+void benchmarkOBJParallel(const string& sourcePath, int copies, unsigned int maxThreads)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	string enlargedPath = (filesystem::temp_directory_path() / "obj_ampliado.obj").string();
+	cout << "Gerando " << enlargedPath << " com " << copies << " copias de " << sourcePath << "..." << endl;
+	if (!writeEnlargedOBJ(sourcePath, copies, enlargedPath))
+	{
+		cout << "Erro ao gerar o arquivo ampliado" << endl;
+		return;
+	}
+
+	MappedFile file;
+	if (!file.open(enlargedPath))
+	{
+		cout << "Erro ao tentar ler o arquivo " << enlargedPath << endl;
+		return;
+	}
+	double megabytes = file.size() / (1024.0 * 1024.0);
+
+	// Lê o arquivo inteiro uma vez para que as faltas de página não entrem na primeira medição
+	volatile unsigned char touched = 0;
+	for (size_t i = 0; i < file.size(); i += 4096)
+		touched ^= (unsigned char)file.data()[i];
+
+	OBJLoadOptions options;
+
+	MeshData reference;
+	Clock::time_point start = Clock::now();
+	parseOBJMeshSequential(file.begin(), file.end(), reference, options, enlargedPath);
+	double sequentialSeconds = chrono::duration<double>(Clock::now() - start).count();
+
+	cout << fixed << setprecision(1) << megabytes << " MB, " << reference.vertexCount() << " vertices unicos, "
+		<< reference.indices.size() / 3 << " triangulos" << endl;
+	cout << left << setw(12) << "threads" << right << setw(12) << "segundos" << setw(12) << "MB/s"
+		<< setw(12) << "speedup" << setw(12) << "eficiencia" << "  resultado" << endl;
+	cout << left << setw(12) << "sequencial" << right << setw(12) << setprecision(3) << sequentialSeconds
+		<< setw(12) << setprecision(1) << megabytes / sequentialSeconds << endl;
+
+	vector<unsigned int> threadCounts;
+	for (unsigned int t = 1; t < maxThreads; t *= 2)
+		threadCounts.push_back(t);
+	threadCounts.push_back(maxThreads);
+
+	double singleThreadSeconds = 0.0;
+	for (unsigned int threads : threadCounts)
+	{
+		ThreadPool pool(threads - 1);
+		MeshData mesh;
+		start = Clock::now();
+		parseOBJMeshParallel(file.begin(), file.end(), mesh, options, enlargedPath, pool);
+		double seconds = chrono::duration<double>(Clock::now() - start).count();
+		if (threads == 1)
+			singleThreadSeconds = seconds;
+
+		bool identical = mesh.vertices == reference.vertices && mesh.indices == reference.indices && mesh.submeshes == reference.submeshes;
+		double speedup = singleThreadSeconds / seconds;
+		cout << left << setw(12) << threads << right << setw(12) << setprecision(3) << seconds
+			<< setw(12) << setprecision(1) << megabytes / seconds
+			<< setw(11) << setprecision(2) << speedup << "x"
+			<< setw(11) << setprecision(0) << 100.0 * speedup / threads << "%"
+			<< "  " << (identical ? "identico" : "DIFERENTE") << endl;
+	}
+
+	file.close();
+	error_code error;
+	filesystem::remove(enlargedPath, error);
+}
+
+void benchmarkOBJMemory(const string& sourcePath, int copies)
+{
+	typedef chrono::high_resolution_clock Clock;
+
+	string enlargedPath = (filesystem::temp_directory_path() / "obj_ampliado.obj").string();
+	cout << "Gerando " << enlargedPath << " com " << copies << " copias de " << sourcePath << "..." << endl;
+	if (!writeEnlargedOBJ(sourcePath, copies, enlargedPath))
+	{
+		cout << "Erro ao gerar o arquivo ampliado" << endl;
+		return;
+	}
+
+	MappedFile file;
+	if (!file.open(enlargedPath))
+	{
+		cout << "Erro ao tentar ler o arquivo " << enlargedPath << endl;
+		return;
+	}
+	const double MB = 1024.0 * 1024.0;
+
+	// As páginas do arquivo mapeado contam no RSS: lidas antes, entram na linha de base
+	volatile unsigned char touched = 0;
+	for (size_t i = 0; i < file.size(); i += 4096)
+		touched ^= (unsigned char)file.data()[i];
+
+	bool canResetPeak = resetPeakRSS();
+	cout << fixed << setprecision(1) << file.size() / MB << " MB de .obj" << endl;
+	if (!canResetPeak)
+		cout << "Aviso: o sistema nao permite reiniciar o pico de memoria; os picos abaixo sao do processo inteiro" << endl;
+
+	cout << left << setw(14) << "malha" << setw(14) << "contagem" << right << setw(12) << "segundos"
+		<< setw(14) << "pico (MB)" << setw(16) << "resultado (MB)" << setw(12) << "pico/res." << "  saida" << endl;
+
+	for (int indexed = 1; indexed >= 0; indexed--)
+	{
+		// Resultado de uma passada, para conferir que a contagem prévia não muda a saída
+		MeshData reference;
+		for (int countFirst = 0; countFirst <= 1; countFirst++)
+		{
+			OBJLoadOptions options;
+			options.indexed = indexed == 1;
+			options.countFirst = countFirst == 1;
+			options.parallel = false;
+
+			releaseFreeMemory();
+			size_t baseline = currentRSS();
+			resetPeakRSS();
+
+			MeshData mesh;
+			Clock::time_point start = Clock::now();
+			parseOBJMesh(file.begin(), file.end(), mesh, options, enlargedPath);
+			double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+			// Pico acima da linha de base, comparado ao tamanho do resultado
+			double peak = (peakRSS() > baseline ? peakRSS() - baseline : 0) / MB;
+			double result = (mesh.vertices.size() * sizeof(float) + mesh.indices.size() * sizeof(unsigned int)) / MB;
+			cout << left << setw(14) << (indexed ? "indexada" : "nao indexada") << setw(14) << (countFirst ? "2 passadas" : "1 passada")
+				<< right << setw(12) << setprecision(3) << seconds
+				<< setw(14) << setprecision(1) << peak << setw(16) << result
+				<< setw(11) << setprecision(2) << (result > 0.0 ? peak / result : 0.0) << "x"
+				<< "  " << (countFirst ? (mesh.vertices == reference.vertices && mesh.indices == reference.indices ? "identica" : "DIFERENTE") : "referencia") << endl;
+			if (!countFirst)
+				reference = std::move(mesh);
+		}
+	}
+
+	file.close();
+	error_code error;
+	filesystem::remove(enlargedPath, error);
+}
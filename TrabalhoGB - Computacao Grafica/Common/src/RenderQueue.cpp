@@ -0,0 +1,125 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+uint64_t makeDrawKey(unsigned pass, unsigned program, unsigned material, unsigned mesh, float depth, float farDepth)
+{
+	const uint64_t depthMax = (uint64_t(1) << DRAW_KEY_DEPTH_BITS) - 1;
+	float normalized = farDepth > 0.0f ? depth / farDepth : 0.0f;
+	normalized = std::min(std::max(normalized, 0.0f), 1.0f);
+
+	uint64_t key = pass & ((1u << DRAW_KEY_PASS_BITS) - 1);
+	key = (key << DRAW_KEY_PROGRAM_BITS) | (program & ((1u << DRAW_KEY_PROGRAM_BITS) - 1));
+	key = (key << DRAW_KEY_MATERIAL_BITS) | (material & ((1u << DRAW_KEY_MATERIAL_BITS) - 1));
+	key = (key << DRAW_KEY_MESH_BITS) | (mesh & ((1u << DRAW_KEY_MESH_BITS) - 1));
+	key = (key << DRAW_KEY_DEPTH_BITS) | (uint64_t)(normalized * (float)depthMax);
+	return key;
+}
+
+void RenderQueue::sort()
+{
+	radixSort(queue, scratch);
+}
+
+void RenderQueue::radixSort(vector<Item>& items, vector<Item>& scratch)
+{
+	const size_t count = items.size();
+	if (count < 2)
+		return;
+
+	// Histogramas dos 8 bytes em uma única leitura das chaves
+	size_t histograms[8][256] = {};
+	for (const Item& item : items)
+	{
+		uint64_t key = item.key;
+		for (int byte = 0; byte < 8; byte++)
+			histograms[byte][(key >> (8 * byte)) & 0xFF]++;
+	}
+
+	scratch.resize(count);
+	vector<Item>* source = &items;
+	vector<Item>* target = &scratch;
+	for (int byte = 0; byte < 8; byte++)
+	{
+		size_t* histogram = histograms[byte];
+
+		// Byte igual em todas as chaves: a passada não mudaria a ordem
+		if (histogram[(items[0].key >> (8 * byte)) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (int digit = 0; digit < 256; digit++)
+		{
+			size_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+
+		const Item* in = source->data();
+		Item* out = target->data();
+		for (size_t i = 0; i < count; i++)
+			out[histogram[(in[i].key >> (8 * byte)) & 0xFF]++] = in[i];
+		std::swap(source, target);
+	}
+
+	if (source != &items)
+		items.swap(scratch);
+}
+
+void benchmarkRenderQueue(size_t draws, int repetitions)
+{
+	typedef chrono::high_resolution_clock Clock;
+	typedef RenderQueue::Item Item;
+
+	mt19937_64 random(42);
+	vector<Item> scene(draws), uniform(draws);
+	uniform_int_distribution<unsigned> textures(0, 15), meshes(0, 31);
+	uniform_real_distribution<float> depths(0.1f, 100.0f);
+	for (size_t i = 0; i < draws; i++)
+	{
+		scene[i] = { makeDrawKey(0, 0, textures(random), meshes(random), depths(random), 100.0f), (int)i };
+		uniform[i] = { random(), (int)i };
+	}
+
+	auto byKey = [](const Item& a, const Item& b) { return a.key < b.key; };
+	cout << left << setw(12) << "Chaves" << setw(16) << "ordenacao" << right << setw(12) << "ms" << setw(10) << "igual" << endl;
+	for (const vector<Item>* input : { &scene, &uniform })
+	{
+		const char* name = input == &scene ? "cena" : "aleatorias";
+		vector<Item> reference = *input;
+		std::stable_sort(reference.begin(), reference.end(), byKey);
+
+		for (int method = 0; method < 3; method++)
+		{
+			const char* methods[] = { "radix", "std::sort", "stable_sort" };
+			vector<Item> items, scratch;
+			double total = 0.0;
+			for (int r = 0; r < repetitions; r++)
+			{
+				items = *input;
+				Clock::time_point start = Clock::now();
+				if (method == 0)
+					RenderQueue::radixSort(items, scratch);
+				else if (method == 1)
+					std::sort(items.begin(), items.end(), byKey);
+				else
+					std::stable_sort(items.begin(), items.end(), byKey);
+				total += chrono::duration<double, milli>(Clock::now() - start).count();
+			}
+
+			// std::sort não é estável: só as chaves precisam bater
+			bool same = items.size() == reference.size();
+			for (size_t i = 0; same && i < items.size(); i++)
+				same = items[i].key == reference[i].key && (method == 1 || items[i].index == reference[i].index);
+			cout << left << setw(12) << (method == 0 ? name : "") << setw(16) << methods[method] << right
+				<< fixed << setprecision(3) << setw(12) << total / repetitions << setw(10) << (same ? "sim" : "NAO") << endl;
+		}
+	}
+	cout << defaultfloat << setprecision(6);
+}
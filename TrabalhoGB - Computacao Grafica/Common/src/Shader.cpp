@@ -1 +1,70 @@
-#include "Shader.h"
\ No newline at end of file
+#include "Shader.h"
+
+#include <algorithm>
+
+bool UniformInt::accepts(GLenum type)
+{
+	switch (type)
+	{
+	case GL_INT:
+	case GL_BOOL:
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_BUFFER:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void Shader::loadUniforms()
+{
+	uniforms.clear();
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	vector<GLchar> name(std::max(maxLength, 1) + 1);
+	for (GLint i = 0; i < count; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		name[0] = '\0';
+		glGetActiveUniform(this->ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+		if (length <= 0)
+			continue;
+
+		ActiveUniform uniform;
+		uniform.name.assign(name.data(), length);
+		uniform.location = glGetUniformLocation(this->ID, uniform.name.c_str());
+		uniform.type = type;
+		uniform.size = size;
+		// Uniforms de blocos (location -1) não são definidos por glUniform*
+		if (uniform.location < 0)
+			continue;
+		// Arrays aparecem como "nome[0]"
+		if (uniform.name.size() > 3 && uniform.name.compare(uniform.name.size() - 3, 3, "[0]") == 0)
+			uniform.name.resize(uniform.name.size() - 3);
+		uniforms.push_back(uniform);
+	}
+
+	sort(uniforms.begin(), uniforms.end(), [](const ActiveUniform& a, const ActiveUniform& b) { return a.name < b.name; });
+}
+
+const Shader::ActiveUniform* Shader::find(const string& name) const
+{
+	auto found = lower_bound(uniforms.begin(), uniforms.end(), name,
+		[](const ActiveUniform& uniform, const string& key) { return uniform.name < key; });
+	return found != uniforms.end() && found->name == name ? &*found : nullptr;
+}
+
+GLint Shader::location(const string& name) const
+{
+	const ActiveUniform* found = find(name);
+	return found != nullptr ? found->location : -1;
+}
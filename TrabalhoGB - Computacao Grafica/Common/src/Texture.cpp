@@ -0,0 +1,365 @@
+#include "Texture.h"
+#include "CompressedTexture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+//STB_IMAGE
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+using namespace std;
+
+bool decodeImage(const string& filePath, DecodedImage& image, int desiredChannels)
+{
+	// Carregamento da imagem usando a função stbi_load da biblioteca stb_image
+	image.data = stbi_load(filePath.c_str(), &image.width, &image.height, &image.channels, desiredChannels);
+	if (desiredChannels != 0)
+		image.channels = desiredChannels;
+	return image.data != nullptr;
+}
+
+void freeImage(DecodedImage& image)
+{
+	stbi_image_free(image.data);
+	image.data = nullptr;
+}
+
+bool readImageSize(const string& filePath, int& width, int& height)
+{
+	int channels;
+	return stbi_info(filePath.c_str(), &width, &height, &channels) != 0;
+}
+
+bool limitImageSize(DecodedImage& image, int maxSize)
+{
+	int width, height;
+	fitImageSize(image.width, image.height, maxSize, width, height);
+	if (image.data == nullptr || (width == image.width && height == image.height))
+		return false;
+
+	// Os pixels reduzidos ficam em memória do stb_image, para o freeImage continuar valendo
+	vector<unsigned char> resampled;
+	resampleImage(image.data, image.width, image.height, image.channels, width, height, resampled);
+	freeImage(image);
+	image.data = (unsigned char*)STBI_MALLOC(resampled.size());
+	memcpy(image.data, resampled.data(), resampled.size());
+	image.width = width;
+	image.height = height;
+	return true;
+}
+
+GLint textureWrapFromString(const string& name)
+{
+	if (name == "clamp")
+		return GL_CLAMP_TO_EDGE;
+	if (name == "mirror")
+		return GL_MIRRORED_REPEAT;
+	return GL_REPEAT;
+}
+
+void applyTextureFilter(const string& name, SamplerSettings& sampler)
+{
+	if (name == "nearest")
+	{
+		sampler.minFilter = GL_NEAREST;
+		sampler.magFilter = GL_NEAREST;
+	}
+	else if (name == "trilinear")
+	{
+		sampler.minFilter = GL_LINEAR_MIPMAP_LINEAR;
+		sampler.magFilter = GL_LINEAR;
+		sampler.mipmaps = true;
+	}
+	else
+	{
+		sampler.minFilter = GL_LINEAR;
+		sampler.magFilter = GL_LINEAR;
+	}
+}
+
+size_t textureBytes(int width, int height, bool mipmaps)
+{
+	// GL_RGB8 costuma ser guardado como RGBA pelo driver: 4 bytes por texel nos dois casos
+	size_t texelBytes = 4;
+	size_t total = 0;
+	while (true)
+	{
+		total += (size_t)width * height * texelBytes;
+		if (!mipmaps || (width == 1 && height == 1))
+			break;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	return total;
+}
+
+GLuint createTexture(const string& filePath, DecodedImage& image, const SamplerSettings& sampler)
+{
+	if (image.data == nullptr)
+	{
+		cout << "Failed to load texture " << filePath << endl;
+		return 0;
+	}
+
+	GLuint texID; // id da textura a ser carregada
+
+	// Gera o identificador da textura na memória
+	glGenTextures(1, &texID);
+	glBindTexture(GL_TEXTURE_2D, texID);
+
+	// Ajuste dos parâmetros de wrapping e filtering
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrapT);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+
+	if (image.channels == 3) // jpg, bmp
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.data);
+	}
+	else // assume que é 4 canais png
+	{
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
+	}
+
+	if (sampler.mipmaps)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	freeImage(image);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texID;
+}
+
+GLuint createTexture(const string& filePath, MipChain& chain, const SamplerSettings& sampler)
+{
+	if (chain.levels.empty())
+	{
+		cout << "Failed to load texture " << filePath << endl;
+		return 0;
+	}
+
+	GLuint texID;
+	glGenTextures(1, &texID);
+	glBindTexture(GL_TEXTURE_2D, texID);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrapT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+
+	// Os níveis pequenos de uma imagem RGB têm linhas que não são múltiplas de 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLenum format = chain.channels == 3 ? GL_RGB : GL_RGBA;
+	size_t levelCount = sampler.mipmaps ? chain.levels.size() : 1;
+	for (size_t i = 0; i < levelCount; i++)
+	{
+		const MipLevel& level = chain.levels[i];
+		glTexImage2D(GL_TEXTURE_2D, (GLint)i, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, level.data.data());
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levelCount - 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	chain.levels.clear();
+	chain.levels.shrink_to_fit();
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texID;
+}
+
+TextureCache::~TextureCache()
+{
+	// As texturas devem ser apagadas com clear() enquanto o contexto existe; aqui só
+	// se avisa, porque no fim do programa o contexto OpenGL pode já ter sido destruído
+	if (!entries.empty())
+		cout << entries.size() << " textura(s) ainda no cache ao final" << endl;
+}
+
+string TextureCache::key(const string& filePath, const SamplerSettings& sampler)
+{
+	error_code error;
+	filesystem::path canonical = filesystem::weakly_canonical(filePath, error);
+	if (error)
+		canonical = filesystem::absolute(filePath, error).lexically_normal();
+
+	return canonical.generic_string() + "|" + to_string(sampler.wrapS) + "," + to_string(sampler.wrapT) + ","
+		+ to_string(sampler.minFilter) + "," + to_string(sampler.magFilter) + "," + (sampler.mipmaps ? "m" : "-")
+		+ (sampler.maxSize > 0 ? "," + to_string(sampler.maxSize) : "");
+}
+
+bool TextureCache::contains(const string& filePath, const SamplerSettings& sampler) const
+{
+	return textureOfKey.count(key(filePath, sampler)) > 0;
+}
+
+GLuint TextureCache::find(const string& key)
+{
+	auto found = textureOfKey.find(key);
+	if (found == textureOfKey.end())
+		return 0;
+
+	entries[found->second].references++;
+	hitCount++;
+	return found->second;
+}
+
+GLuint TextureCache::acquire(const string& filePath, const SamplerSettings& sampler)
+{
+	GLuint texture = find(key(filePath, sampler));
+	if (texture != 0)
+		return texture;
+
+	// Prefere o KTX2 já comprimido; a imagem original só é decodificada sem ele
+	CompressedImage compressed;
+	if (useCompressed && loadCompressedTexture(filePath, compressed))
+	{
+		limitCompressedSize(compressed, sampler.maxSize);
+		return acquire(filePath, sampler, compressed);
+	}
+
+	// Depois a cadeia de mipmaps já gerada (ou gerada agora e gravada para a próxima vez)
+	MipChain chain;
+	if (cpuMipmaps && sampler.mipmaps && prepareMipChain(filePath, mipmapFilter, chain, sampler.maxSize))
+		return acquire(filePath, sampler, chain);
+
+	DecodedImage image;
+	decodeImage(filePath, image);
+	limitImageSize(image, sampler.maxSize);
+	return acquire(filePath, sampler, image);
+}
+
+GLuint TextureCache::acquire(const string& filePath, const SamplerSettings& sampler, DecodedImage& image)
+{
+	string textureKey = key(filePath, sampler);
+	GLuint texture = find(textureKey);
+	if (texture != 0)
+	{
+		freeImage(image);
+		return texture;
+	}
+
+	int width = image.width, height = image.height;
+	texture = createTexture(filePath, image, sampler);
+	if (texture != 0)
+		insert(textureKey, texture, textureBytes(width, height, sampler.mipmaps));
+	return texture;
+}
+
+GLuint TextureCache::acquire(const string& filePath, const SamplerSettings& sampler, CompressedImage& image)
+{
+	string textureKey = key(filePath, sampler);
+	GLuint texture = find(textureKey);
+	if (texture != 0)
+	{
+		image.levels.clear();
+		return texture;
+	}
+
+	size_t compressedBytes = sampler.mipmaps ? image.totalBytes() : (image.levels.empty() ? 0 : image.levels[0].data.size());
+	texture = createCompressedTexture(filePath, image, sampler);
+	if (texture != 0)
+	{
+		insert(textureKey, texture, compressedBytes);
+		compressedCount++;
+	}
+	return texture;
+}
+
+GLuint TextureCache::acquire(const string& filePath, const SamplerSettings& sampler, MipChain& chain)
+{
+	string textureKey = key(filePath, sampler);
+	GLuint texture = find(textureKey);
+	if (texture != 0)
+	{
+		chain.levels.clear();
+		return texture;
+	}
+
+	int width = chain.levels.empty() ? 0 : chain.levels[0].width;
+	int height = chain.levels.empty() ? 0 : chain.levels[0].height;
+	texture = createTexture(filePath, chain, sampler);
+	if (texture != 0)
+		insert(textureKey, texture, textureBytes(width, height, sampler.mipmaps));
+	return texture;
+}
+
+GLuint TextureCache::adopt(const string& filePath, const SamplerSettings& sampler, GLuint texture, size_t size, int references, bool compressed)
+{
+	string textureKey = key(filePath, sampler);
+	auto found = textureOfKey.find(textureKey);
+	if (found != textureOfKey.end())
+	{
+		glDeleteTextures(1, &texture);
+		entries[found->second].references += references;
+		hitCount += references;
+		return found->second;
+	}
+
+	insert(textureKey, texture, size);
+	entries[texture].references = references;
+	hitCount += references - 1;
+	if (compressed)
+		compressedCount++;
+	return texture;
+}
+
+void TextureCache::insert(const string& key, GLuint texture, size_t size)
+{
+	Entry& entry = entries[texture];
+	entry.key = key;
+	entry.bytes = size;
+	entry.references = 1;
+	textureOfKey[key] = texture;
+	bytes += size;
+	uploadCount++;
+}
+
+void TextureCache::resize(GLuint texture, size_t size)
+{
+	auto found = entries.find(texture);
+	if (found == entries.end())
+		return;
+
+	bytes = bytes - found->second.bytes + size;
+	found->second.bytes = size;
+}
+
+void TextureCache::addReference(GLuint texture)
+{
+	auto found = entries.find(texture);
+	if (found != entries.end())
+		found->second.references++;
+}
+
+void TextureCache::release(GLuint texture)
+{
+	auto found = entries.find(texture);
+	if (found == entries.end() || --found->second.references > 0)
+		return;
+
+	bytes -= found->second.bytes;
+	textureOfKey.erase(found->second.key);
+	entries.erase(found);
+	glDeleteTextures(1, &texture);
+}
+
+void TextureCache::clear()
+{
+	for (auto& entry : entries)
+		glDeleteTextures(1, &entry.first);
+	entries.clear();
+	textureOfKey.clear();
+	bytes = 0;
+}
+
+void TextureCache::report(ostream& out) const
+{
+	out << "Texturas na GPU: " << entries.size() << " (" << bytes / 1024 << " KB), "
+		<< uploadCount << " envio(s) (" << compressedCount << " comprimido(s)), " << hitCount << " reaproveitada(s) do cache" << endl;
+}
@@ -0,0 +1,254 @@
+#include "TextureArrays.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+namespace
+{
+	inline GLenum compressedFormat(BlockFormat format)
+	{
+		return format == BLOCK_FORMAT_BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+}
+
+TextureArrays::~TextureArrays()
+{
+	if (!arrays.empty())
+		cout << arrays.size() << " array(s) de textura ainda alocado(s) ao final" << endl;
+}
+
+int TextureArrays::addEntry(const string& filePath, const SamplerSettings& sampler, bool& added)
+{
+	string key = TextureCache::key(filePath, sampler);
+	auto found = entryOfKey.find(key);
+	if (found != entryOfKey.end())
+	{
+		entries[found->second].references++;
+		added = false;
+		return found->second;
+	}
+
+	int id = (int)entries.size();
+	entries.emplace_back();
+	entries.back().filePath = filePath;
+	entries.back().sampler = sampler;
+	entryOfKey[key] = id;
+	added = true;
+	return id;
+}
+
+int TextureArrays::add(const string& filePath, const SamplerSettings& sampler, MipChain& chain)
+{
+	bool added;
+	int id = addEntry(filePath, sampler, added);
+	if (added)
+		entries[id].chain = std::move(chain);
+	chain.levels.clear();
+	return id;
+}
+
+int TextureArrays::add(const string& filePath, const SamplerSettings& sampler, CompressedImage& image)
+{
+	bool added;
+	int id = addEntry(filePath, sampler, added);
+	if (added)
+	{
+		entries[id].image = std::move(image);
+		entries[id].compressed = true;
+	}
+	image.levels.clear();
+	return id;
+}
+
+string TextureArrays::groupKey(Entry& entry)
+{
+	// Tamanho de cada nível da imagem
+	vector<pair<int, int>> sizes;
+	if (entry.compressed)
+	{
+		for (const CompressedLevel& level : entry.image.levels)
+			sizes.push_back({ level.width, level.height });
+	}
+	else
+	{
+		for (const MipLevel& level : entry.chain.levels)
+			sizes.push_back({ level.width, level.height });
+	}
+	if (sizes.empty())
+		return "";
+
+	entry.firstLevel = 0;
+	while (maxSize > 0 && entry.firstLevel + 1 < (int)sizes.size() &&
+		(sizes[entry.firstLevel].first > maxSize || sizes[entry.firstLevel].second > maxSize))
+		entry.firstLevel++;
+
+	int levels = entry.sampler.mipmaps ? (int)sizes.size() - entry.firstLevel : 1;
+	const SamplerSettings& sampler = entry.sampler;
+	string format = entry.compressed ? (entry.image.format == BLOCK_FORMAT_BC3 ? "bc3" : "bc1") : "rgba8";
+	return format + "|" + to_string(sizes[entry.firstLevel].first) + "x" + to_string(sizes[entry.firstLevel].second) + "|"
+		+ to_string(levels) + "|" + to_string(sampler.wrapS) + "," + to_string(sampler.wrapT) + ","
+		+ to_string(sampler.minFilter) + "," + to_string(sampler.magFilter);
+}
+
+void TextureArrays::build(int maxArrays, TextureCache& cache)
+{
+	// Grupos em ordem de chave (resultado estável entre execuções)
+	map<string, vector<int>> groups;
+	vector<int> failed;
+	for (int id = 0; id < (int)entries.size(); id++)
+	{
+		if (entries[id].placement.array >= 0 || entries[id].placement.texture != 0)
+			continue;
+		string key = groupKey(entries[id]);
+		if (key.empty())
+			failed.push_back(id);
+		else
+			groups[key].push_back(id);
+	}
+
+	vector<const vector<int>*> ordered;
+	for (const auto& group : groups)
+		ordered.push_back(&group.second);
+	stable_sort(ordered.begin(), ordered.end(), [](const vector<int>* a, const vector<int>* b) { return a->size() > b->size(); });
+
+	for (const vector<int>* members : ordered)
+	{
+		if ((int)arrays.size() < maxArrays)
+		{
+			arrays.emplace_back();
+			upload(arrays.back(), *members);
+			continue;
+		}
+
+		// Sem unidade livre para mais um array: texturas comuns, compartilhadas pelo cache
+		for (int id : *members)
+		{
+			Entry& entry = entries[id];
+			GLuint texture = entry.compressed ? cache.acquire(entry.filePath, entry.sampler, entry.image)
+				: cache.acquire(entry.filePath, entry.sampler, entry.chain);
+			for (int i = 1; i < entry.references && texture != 0; i++)
+				cache.addReference(texture);
+			entry.placement.texture = texture;
+		}
+	}
+
+	for (int id : failed)
+		cout << "Failed to load texture " << entries[id].filePath << endl;
+}
+
+void TextureArrays::upload(Array& array, const vector<int>& members)
+{
+	Entry& first = entries[members[0]];
+	const SamplerSettings& sampler = first.sampler;
+	array.compressed = first.compressed;
+	array.layers = (int)members.size();
+	if (array.compressed)
+	{
+		array.width = first.image.levels[first.firstLevel].width;
+		array.height = first.image.levels[first.firstLevel].height;
+		array.levels = sampler.mipmaps ? (int)first.image.levels.size() - first.firstLevel : 1;
+	}
+	else
+	{
+		array.width = first.chain.levels[first.firstLevel].width;
+		array.height = first.chain.levels[first.firstLevel].height;
+		array.levels = sampler.mipmaps ? (int)first.chain.levels.size() - first.firstLevel : 1;
+	}
+
+	glGenTextures(1, &array.texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, sampler.wrapS);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, sampler.wrapT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, array.levels - 1);
+
+	// Alocação de todos os níveis com todas as camadas; RGB e RGBA ficam juntos em RGBA8
+	GLenum blockFormat = array.compressed ? compressedFormat(first.image.format) : 0;
+	int width = array.width, height = array.height;
+	for (int level = 0; level < array.levels; level++)
+	{
+		if (array.compressed)
+		{
+			size_t levelBytes = compressedLevelBytes(first.image.format, width, height) * array.layers;
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, blockFormat, width, height, array.layers, 0, (GLsizei)levelBytes, nullptr);
+			array.bytes += levelBytes;
+		}
+		else
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, width, height, array.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			array.bytes += (size_t)width * height * 4 * array.layers;
+		}
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	// Uma camada por imagem; os níveis pequenos de uma imagem RGB têm linhas que não são múltiplas de 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int layer = 0; layer < array.layers; layer++)
+	{
+		Entry& entry = entries[members[layer]];
+		for (int level = 0; level < array.levels; level++)
+		{
+			if (array.compressed)
+			{
+				const CompressedLevel& source = entry.image.levels[entry.firstLevel + level];
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, source.width, source.height, 1, blockFormat, (GLsizei)source.data.size(), source.data.data());
+			}
+			else
+			{
+				const MipLevel& source = entry.chain.levels[entry.firstLevel + level];
+				GLenum format = entry.chain.channels == 3 ? GL_RGB : GL_RGBA;
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, source.width, source.height, 1, format, GL_UNSIGNED_BYTE, source.data.data());
+			}
+		}
+
+		entry.placement.array = (int)(&array - arrays.data());
+		entry.placement.layer = layer;
+		entry.chain.levels.clear();
+		entry.chain.levels.shrink_to_fit();
+		entry.image.levels.clear();
+		entry.image.levels.shrink_to_fit();
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArrays::bind(GLenum firstUnit) const
+{
+	for (size_t i = 0; i < arrays.size(); i++)
+	{
+		glActiveTexture(firstUnit + (GLenum)i);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[i].texture);
+	}
+}
+
+size_t TextureArrays::residentBytes() const
+{
+	size_t total = 0;
+	for (const Array& array : arrays)
+		total += array.bytes;
+	return total;
+}
+
+void TextureArrays::clear()
+{
+	for (Array& array : arrays)
+		glDeleteTextures(1, &array.texture);
+	arrays.clear();
+	entries.clear();
+	entryOfKey.clear();
+}
+
+void TextureArrays::report(ostream& out) const
+{
+	if (arrays.empty())
+		return;
+
+	out << "Arrays de textura: " << arrays.size() << " (" << residentBytes() / 1024 << " KB):";
+	for (const Array& array : arrays)
+		out << " " << array.width << "x" << array.height << "x" << array.layers << (array.compressed ? " comprimido" : "");
+	out << endl;
+}
@@ -0,0 +1,479 @@
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+	// Formato de envio das imagens decodificadas (mesma regra do createTexture)
+	inline GLenum pixelFormat(const DecodedImage& image)
+	{
+		return image.channels == 3 ? GL_RGB : GL_RGBA;
+	}
+
+	inline GLenum compressedFormat(BlockFormat format)
+	{
+		return format == BLOCK_FORMAT_BC3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+}
+
+TextureStreamer::TextureStreamer(size_t ringSize, size_t slotBytes)
+	: ringSize(std::max<size_t>(1, ringSize)), slotBytes(slotBytes)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// As threads de trabalho escrevem nos pedidos: espera terminarem antes de liberar
+	for (unique_ptr<Job>& job : jobs)
+	{
+		if (job->decoded.valid())
+			job->decoded.wait();
+		freeImage(job->image);
+	}
+}
+
+void TextureStreamer::initialize()
+{
+	ring.assign(ringSize, Slot());
+	for (Slot& slot : ring)
+	{
+		glGenBuffers(1, &slot.buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, slotBytes, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	glGenTextures(1, &placeholderTexture);
+	glBindTexture(GL_TEXTURE_2D, placeholderTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextureStreamer::shutdown()
+{
+	for (Slot& slot : ring)
+	{
+		if (slot.fence)
+			glDeleteSync(slot.fence);
+		glDeleteBuffers(1, &slot.buffer);
+	}
+	ring.clear();
+
+	for (unique_ptr<Job>& job : jobs)
+	{
+		if (job->state == JOB_UPLOADING)
+			glDeleteTextures(1, &job->texture);
+	}
+
+	glDeleteTextures(1, &placeholderTexture);
+	placeholderTexture = 0;
+}
+
+int TextureStreamer::request(const string& filePath, const SamplerSettings& sampler, const TextureCache& cache)
+{
+	string key = TextureCache::key(filePath, sampler);
+	auto found = jobOfKey.find(key);
+	if (found != jobOfKey.end())
+	{
+		jobs[found->second]->references++;
+		return found->second;
+	}
+
+	int id = (int)jobs.size();
+	jobs.push_back(make_unique<Job>());
+	Job* job = jobs.back().get();
+	job->filePath = filePath;
+	job->sampler = sampler;
+	job->references = 1;
+	jobOfKey[key] = id;
+	pending++;
+
+	// Prefere o KTX2 atualizado, depois a cadeia de mipmaps da CPU; senão decodifica a
+	// imagem. Os três respeitam o lado máximo do pedido
+	bool useCompressed = cache.usesCompressed();
+	bool cpuMipmaps = cache.usesCpuMipmaps() && sampler.mipmaps;
+	MipFilter filter = cache.mipFilter();
+	job->decoded = defaultThreadPool().submit([job, useCompressed, cpuMipmaps, filter] {
+		int maxSize = job->sampler.maxSize;
+		if (useCompressed && loadCompressedTexture(job->filePath, job->compressed))
+		{
+			limitCompressedSize(job->compressed, maxSize);
+			job->isCompressed = true;
+			return true;
+		}
+		if (cpuMipmaps && prepareMipChain(job->filePath, filter, job->chain, maxSize))
+			return true;
+		if (!decodeImage(job->filePath, job->image))
+			return false;
+
+		// Tons de cinza (com ou sem alfa) são convertidos: o envio só trata RGB e RGBA
+		if (job->image.channels != 3 && job->image.channels != 4)
+		{
+			freeImage(job->image);
+			if (!decodeImage(job->filePath, job->image, 4))
+				return false;
+		}
+		limitImageSize(job->image, maxSize);
+		return true;
+	});
+	return id;
+}
+
+void TextureStreamer::setMipStreaming(bool enabled, size_t budgetBytes)
+{
+	mipStreaming = enabled;
+	mips.setBudget(budgetBytes);
+}
+
+void TextureStreamer::levelSize(const Job& job, int level, int& width, int& height) const
+{
+	if (job.isCompressed)
+	{
+		width = job.compressed.levels[level].width;
+		height = job.compressed.levels[level].height;
+	}
+	else
+	{
+		width = job.chain.levels[level].width;
+		height = job.chain.levels[level].height;
+	}
+}
+
+void TextureStreamer::specifyLevel(const Job& job, int level, bool allocate)
+{
+	int width = 0, height = 0;
+	if (allocate)
+		levelSize(job, level, width, height);
+
+	if (job.isCompressed)
+	{
+		GLsizei size = allocate ? (GLsizei)job.compressed.levels[level].data.size() : 0;
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, compressedFormat(job.compressed.format), width, height, 0, size, nullptr);
+	}
+	else
+	{
+		GLenum format = job.chain.channels == 3 ? GL_RGB : GL_RGBA;
+		glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+	}
+}
+
+void TextureStreamer::beginUpload(Job& job)
+{
+	glGenTextures(1, &job.texture);
+	glBindTexture(GL_TEXTURE_2D, job.texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, job.sampler.wrapS);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, job.sampler.wrapT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, job.sampler.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, job.sampler.magFilter);
+
+	// Só a alocação (sem dados): os texels chegam depois, pelos PBOs
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	job.level = 0;
+	job.row = 0;
+	job.state = JOB_UPLOADING;
+	if (!job.isCompressed && job.chain.levels.empty())
+	{
+		GLenum format = pixelFormat(job.image);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, job.image.width, job.image.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+		job.textureBytes = textureBytes(job.image.width, job.image.height, job.sampler.mipmaps);
+		return;
+	}
+
+	if (job.isCompressed && !job.sampler.mipmaps)
+		job.compressed.levels.resize(1);
+	int levels = (int)levelCount(job);
+
+	// Com o streaming de mipmaps a textura fica pronta só com os níveis pequenos
+	if (mipStreaming && job.sampler.mipmaps && levels > 1)
+	{
+		vector<size_t> levelBytes;
+		for (int level = 0; level < levels; level++)
+		{
+			int width, height;
+			levelSize(job, level, width, height);
+			levelBytes.push_back(job.isCompressed ? job.compressed.levels[level].data.size() : (size_t)width * height * 4);
+		}
+		int width, height;
+		levelSize(job, 0, width, height);
+		job.residency = mips.addTexture(width, height, levelBytes);
+		jobOfResidency.push_back(&job);
+		job.level = mips.tailLevel(job.residency);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.level);
+	}
+
+	for (int level = job.level; level < levels; level++)
+		specifyLevel(job, level, true);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+	if (job.residency >= 0)
+		job.textureBytes = mips.residentBytes(job.residency);
+	else if (job.isCompressed)
+		job.textureBytes = job.compressed.totalBytes();
+	else
+		job.textureBytes = textureBytes(job.chain.levels[0].width, job.chain.levels[0].height, true);
+}
+
+size_t TextureStreamer::levelCount(const Job& job)
+{
+	if (job.isCompressed)
+		return job.compressed.levels.size();
+	return job.chain.levels.empty() ? 1 : job.chain.levels.size();
+}
+
+size_t TextureStreamer::uploadSlice(Job& job, size_t byteBudget)
+{
+	// Linhas do nível atual: de texels, ou de blocos de 4x4 na textura comprimida
+	int width, height, rowCount;
+	size_t rowBytes;
+	const unsigned char* source;
+	GLenum format = GL_RGBA;
+	if (job.isCompressed)
+	{
+		const CompressedLevel& level = job.compressed.levels[job.level];
+		width = level.width;
+		height = level.height;
+		rowCount = (height + 3) / 4;
+		rowBytes = level.data.size() / rowCount;
+		source = level.data.data();
+	}
+	else if (!job.chain.levels.empty())
+	{
+		const MipLevel& level = job.chain.levels[job.level];
+		width = level.width;
+		height = level.height;
+		rowCount = height;
+		rowBytes = (size_t)width * job.chain.channels;
+		source = level.data.data();
+		format = job.chain.channels == 3 ? GL_RGB : GL_RGBA;
+	}
+	else
+	{
+		width = job.image.width;
+		height = job.image.height;
+		rowCount = height;
+		rowBytes = (size_t)width * job.image.channels;
+		source = job.image.data;
+		format = pixelFormat(job.image);
+	}
+
+	Slot& slot = ring[nextSlot];
+	if (slot.fence)
+	{
+		// PBO ainda em uso pela GPU: o envio continua no próximo frame
+		if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			return 0;
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+	}
+
+	size_t rowsThatFit = std::min(slotBytes, byteBudget) / rowBytes;
+	int rows = std::min(rowCount - job.row, (int)std::max<size_t>(1, rowsThatFit));
+	size_t bytes = (size_t)rows * rowBytes;
+	const unsigned char* rowData = source + (size_t)job.row * rowBytes;
+
+	// Uma linha maior que o PBO vai direto da memória da aplicação
+	const void* pixels = rowData;
+	bool throughBuffer = bytes <= slotBytes;
+	if (throughBuffer)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (mapped != nullptr)
+		{
+			memcpy(mapped, rowData, bytes);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			pixels = nullptr;  // deslocamento 0 dentro do PBO
+		}
+		else
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			throughBuffer = false;
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, job.texture);
+	if (job.isCompressed)
+	{
+		int y = job.row * 4;
+		int sliceHeight = std::min(rows * 4, height - y);
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, job.level, 0, y, width, sliceHeight, compressedFormat(job.compressed.format), (GLsizei)bytes, pixels);
+	}
+	else
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, job.row, width, rows, format, GL_UNSIGNED_BYTE, pixels);
+	}
+
+	if (throughBuffer)
+	{
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		nextSlot = (nextSlot + 1) % ring.size();
+	}
+
+	job.row += rows;
+	if (job.row == rowCount)
+	{
+		job.level++;
+		job.row = 0;
+	}
+	uploaded += bytes;
+	return bytes;
+}
+
+void TextureStreamer::finish(Job& job, TextureCache& cache, vector<Completed>& completed, int id)
+{
+	GLuint texture = 0;
+	if (job.texture != 0)
+	{
+		if (!job.isCompressed && job.chain.levels.empty() && job.sampler.mipmaps)
+		{
+			glBindTexture(GL_TEXTURE_2D, job.texture);
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		texture = cache.adopt(job.filePath, job.sampler, job.texture, job.textureBytes, job.references, job.isCompressed);
+	}
+	else
+	{
+		cout << "Failed to load texture " << job.filePath << endl;
+	}
+	pending--;
+	completed.push_back({ id, texture });
+
+	// Textura gerenciada: a cadeia fica na memória para os níveis maiores
+	if (job.residency >= 0 && texture == job.texture)
+	{
+		job.state = JOB_RESIDENT;
+		return;
+	}
+	if (job.residency >= 0)
+	{
+		mips.removeTexture(job.residency);
+		job.residency = -1;
+	}
+
+	freeImage(job.image);
+	job.compressed.levels.clear();
+	job.compressed.levels.shrink_to_fit();
+	job.chain.levels.clear();
+	job.chain.levels.shrink_to_fit();
+	job.texture = 0;
+	job.state = JOB_DONE;
+}
+
+void TextureStreamer::require(int request, float projectedPixels)
+{
+	if (request < 0 || request >= (int)jobs.size() || jobs[request]->state != JOB_RESIDENT)
+		return;
+
+	const Job& job = *jobs[request];
+	int width, height;
+	levelSize(job, 0, width, height);
+	mips.require(job.residency, MipResidency::requiredLevel(width, height, projectedPixels));
+}
+
+size_t TextureStreamer::updateResidency(size_t byteBudget, TextureCache& cache)
+{
+	// Descartes valem na hora: o nível base sobe antes de o nível ser liberado, então a
+	// textura nunca fica incompleta. As cargas alocam o nível e seguem pelos PBOs
+	mips.schedule(byteBudget, actions);
+	for (const MipResidency::Action& action : actions)
+	{
+		Job& job = *jobOfResidency[action.texture];
+		glBindTexture(GL_TEXTURE_2D, job.texture);
+		if (action.type == MipResidency::MIP_EVICT)
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, action.level + 1);
+			specifyLevel(job, action.level, false);
+			cache.resize(job.texture, mips.residentBytes(job.residency));
+		}
+		else
+		{
+			specifyLevel(job, action.level, true);
+			job.level = action.level;
+			job.row = 0;
+			job.loadingLevel = action.level;
+		}
+	}
+
+	size_t spent = 0;
+	bool ringFull = false;
+	for (Job* job : jobOfResidency)
+	{
+		if (job->loadingLevel < 0)
+			continue;
+		while (!ringFull && spent < byteBudget && job->level == job->loadingLevel)
+		{
+			size_t bytes = uploadSlice(*job, byteBudget - spent);
+			ringFull = bytes == 0;
+			spent += bytes;
+		}
+
+		// Nível completo: passa a ser o nível base
+		if (job->level != job->loadingLevel)
+		{
+			glBindTexture(GL_TEXTURE_2D, job->texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job->loadingLevel);
+			mips.loaded(job->residency, job->loadingLevel);
+			job->loadingLevel = -1;
+			cache.resize(job->texture, mips.residentBytes(job->residency));
+		}
+	}
+	return spent;
+}
+
+void TextureStreamer::update(size_t byteBudget, TextureCache& cache, vector<Completed>& completed)
+{
+	completed.clear();
+	if (pending == 0 && jobOfResidency.empty())
+		return;
+
+	// Linhas de RGB com largura ímpar não são múltiplas de 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	size_t spent = 0;
+	bool ringFull = false;
+	for (size_t id = 0; id < jobs.size(); id++)
+	{
+		Job& job = *jobs[id];
+		if (job.state == JOB_DECODING)
+		{
+			if (job.decoded.wait_for(chrono::seconds(0)) != future_status::ready)
+				continue;
+			if (!job.decoded.get())
+			{
+				finish(job, cache, completed, (int)id);
+				continue;
+			}
+			beginUpload(job);
+		}
+
+		if (job.state != JOB_UPLOADING)
+			continue;
+
+		int levels = (int)levelCount(job);
+		while (!ringFull && spent < byteBudget && job.level < levels)
+		{
+			size_t bytes = uploadSlice(job, byteBudget - spent);
+			ringFull = bytes == 0;
+			spent += bytes;
+		}
+		if (job.level == levels)
+			finish(job, cache, completed, (int)id);
+	}
+
+	// Níveis maiores das texturas prontas, com o que sobrou do orçamento do frame
+	if (!jobOfResidency.empty())
+		updateResidency(spent < byteBudget ? byteBudget - spent : 0, cache);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
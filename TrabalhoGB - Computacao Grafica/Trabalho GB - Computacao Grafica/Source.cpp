@@ -8,8 +8,15 @@
 
 #include <filesystem>
 
+#include <map>
+#include <tuple>
 #include <unordered_map>
 
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <thread>
+
 using namespace std;
 
 // GLAD
@@ -23,12 +30,33 @@ using namespace std;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-//STB_IMAGE
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-//Classe gerenciadora de shaders
+//Classe gerenciadora de shaders e uniform buffer do frame
 #include "Shader.h"
+#include "FrameUniforms.h"
+#include "InstanceBuffer.h"
+#include "IndirectDraw.h"
+
+//Carregador de arquivos .obj e formatos de vértice
+#include "OBJLoader.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "GeometryPool.h"
+#include "DrawStats.h"
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+#include "FrustumCuller.h"
+#include "DynamicBVH.h"
+
+//Decodificação de imagens (stb_image) e cache de texturas
+#include "Texture.h"
+#include "CompressedTexture.h"
+#include "MipChain.h"
+#include "MipResidency.h"
+#include "TextureStreamer.h"
+#include "TextureArrays.h"
+#include "ThreadPool.h"
 
 // Biblioteca JSON
 #include "json.hpp"
@@ -40,13 +68,56 @@ struct Curve
     glm::mat4 M;                          // Matriz dos coeficientes da curva
 };
 
+// Material lido do .mtl (newmtl); os coeficientes padrão são os da cena original
+struct Material
+{
+	std::string name;
+	glm::vec3 ka = glm::vec3(0.2f);
+	glm::vec3 kd = glm::vec3(1.0f);
+	glm::vec3 ks = glm::vec3(1.0f);
+};
+
+// Faixa de índices (ou vértices) do VAO do objeto desenhada com um material
+struct DrawRange
+{
+	std::string materialName; //nome do usemtl no .obj
+	int material = -1; //índice em Object::materials (-1: material padrão)
+	int lod = 0; //nível de detalhe da faixa (0: malha completa)
+	GLint first = 0;
+	GLsizei count = 0;
+};
+
 struct Object
 {
-	GLuint VAO; //Índice do buffer de geometria
+	GLuint VAO = 0; //Índice do buffer de geometria
+	GLuint VBO = 0; //Buffer de vértices
+	GLuint EBO = 0; //Buffer de índices (0 se a malha não é indexada)
 	GLuint texID; //Identificador da textura carregada
-	int nVertices; //nro de vértices
+	int nVertices = 0; //nro de vértices
+	int nIndices = 0; //nro de índices (desenho com glDrawElements)
+	GLenum indexType = GL_UNSIGNED_INT; //GL_UNSIGNED_SHORT ou GL_UNSIGNED_INT
+	GLuint firstIndex = 0; //primeiro índice da malha no bloco do geometryPool
+	GLint baseVertex = 0; //primeiro vértice da malha no bloco (somado aos índices)
+	glm::vec3 posScale = glm::vec3(1.0f); //desquantização da posição (formato compacto)
+	glm::vec3 posOffset = glm::vec3(0.0f);
+	glm::vec3 boundsMin = glm::vec3(0.0f); //caixa envolvente em coordenadas do modelo
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	glm::vec3 sphereCenter = glm::vec3(0.0f); //esfera envolvente em coordenadas do modelo
+	float sphereRadius = 0.0f;
+	int lodCount = 1; //níveis de detalhe da malha, contando a malha completa
+	float lodError[MAX_MESH_LODS] = {}; //erro de cada nível, relativo a sphereRadius
+	size_t geometryBytes = 0; //bytes de VBO + EBO na GPU
+	int meshStats = -1; //identificador da malha no drawStats
+	int textureRequest = -1; //pedido no textureStreamer enquanto a textura não está pronta
+	int textureStream = -1; //pedido no textureStreamer (níveis de mipmap conforme o tamanho na tela)
+	int textureArray = -1; //array de textura (unidade 1 + textureArray) ou -1 para usar texID
+	int textureLayer = 0; //camada no array
+	int bvhLeaf = -1; //folha no objectBVH (-1 até o primeiro frame)
+	Aabb bvhBox; //última caixa enviada à folha (só muda a BVH quando muda)
+	bool sharedMesh = false; //buffers de outro objeto com a mesma malha ou do geometryPool (apagados pelo dono)
 	glm::mat4 model; //matriz de transformações do objeto
-	float ka, kd, ks; //coeficientes de iluminação - material do objeto
+	std::vector<Material> materials; //materiais do .mtl do objeto
+	std::vector<DrawRange> drawRanges; //uma faixa por nível de detalhe e material, nessa ordem
 	glm::vec3 position;
 	glm::vec3 scale;
 	glm::vec3 rotation;
@@ -57,18 +128,65 @@ struct Object
 	float curveAngle = 0.0;
 };
 
+// Uniforms do phong, resolvidos uma vez depois da compilação; no frame só há glUniform*
+struct PhongUniforms
+{
+	UniformMat4 model;
+	UniformVec3 posScale, posOffset;
+	UniformVec3 ka, kd, ks;
+	UniformFloat q;
+	UniformInt texBuffer, textureArrays, textureArray;
+	UniformFloat textureLayer;
+	UniformInt instanced;
+	UniformInt materialTable;
+
+	explicit PhongUniforms(const Shader& shader)
+	{
+		model = shader.uniform<UniformMat4>("model");
+		posScale = shader.uniform<UniformVec3>("posScale");
+		posOffset = shader.uniform<UniformVec3>("posOffset");
+		ka = shader.uniform<UniformVec3>("ka");
+		kd = shader.uniform<UniformVec3>("kd");
+		ks = shader.uniform<UniformVec3>("ks");
+		q = shader.uniform<UniformFloat>("q");
+		texBuffer = shader.uniform<UniformInt>("texBuffer");
+		textureArrays = shader.uniform<UniformInt>("textureArrays");
+		textureArray = shader.uniform<UniformInt>("textureArray");
+		textureLayer = shader.uniform<UniformFloat>("textureLayer");
+		instanced = shader.uniform<UniformInt>("instanced");
+		materialTable = shader.uniform<UniformInt>("materialTable");
+	}
+};
+
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn);
 
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+
 void userKeyInput(GLFWwindow* window);
 
 // Protótipos das funções
-int loadSimpleOBJ(string filePATH, int &nVertices);
-GLuint loadTexture(string filePATH, int &width, int &height);
-void loadMTL(string filePATH, Object &obj);
-void renderObjects(Shader& shader, float angle, GLint modelLoc);
+bool loadSimpleOBJ(string filePATH, Object &obj, bool indexed = true, VertexFormat format = VERTEX_FORMAT_PACKED);
+void uploadMesh(const string& filePATH, const PreparedMesh& prepared, Object &obj);
+void shareMesh(const Object& source, Object& obj);
+GLuint loadTexture(string filePATH);
+bool loadMTL(string filePATH, std::vector<Material> &materials);
+void bindMaterials(Object &obj);
+void renderObjects(const PhongUniforms& uniforms, float angle);
+void renderInstanced(const PhongUniforms& uniforms);
+void renderIndirect(const PhongUniforms& uniforms);
+void buildInstanceGroups();
+void buildIndirectCommands();
+void cullObjects();
+int pickObject(float ndcX, float ndcY);
+void updateObjectModel(Object& obj, float angle);
+int selectObjectLod(const Object& obj, int current);
+Aabb objectBounds(const Object& obj);
+void bindObjectTexture(const PhongUniforms& uniforms, const Object& obj);
+void drawObjectRanges(const PhongUniforms& uniforms, const Object& obj, int lod, GLsizei instances);
+void requireTextureMips();
 void loadSceneConfig(string filePATH);
 void loadObjectsFromFolder(string objFolderPath, string textureFolderPath, string mtlFolderPath, Curve& curve);
 
@@ -76,9 +194,14 @@ std::vector<glm::vec3> generateInfiniteControlPoints(int numPoints = 20);
 std::vector<glm::vec3> generateCircleControlPoints(int numPoints = 20);
 void generateGlobalBezierCurvePoints(Curve &curve, int numPoints);  
 
+int runCommandLineMode(int argc, char** argv);
+
 // Dimensões da janela (pode ser alterado em tempo de execução)
 const GLuint WIDTH = 1920, HEIGHT = 1080;
 
+// Campo de visão vertical da projeção (graus)
+const float FIELD_OF_VIEW = 39.6f;
+
 //Variáveis globais da câmera
 glm::vec3 cameraPos;
 glm::vec3 cameraFront;
@@ -97,11 +220,126 @@ bool cursorEnabled = false;
 
 std::vector<Object> objects;
 
+// Reaproveita os buffers processados entre execuções (arquivos .meshcache)
+bool useMeshCache = true;
+
+// Reordenação de triângulos/vértices aplicada às malhas indexadas
+MeshOptimization meshOptimization = MESH_OPTIMIZATION_VERTEX_CACHE;
+
+// Níveis de detalhe gerados na carga (contando a malha completa; 1 desliga) e escolhidos
+// por objeto a cada frame pelo raio da esfera envolvente na tela: o nível mais simples cujo
+// erro fica abaixo de lodErrorPixels; para simplificar o erro precisa ficar abaixo com a
+// margem lodHysteresis, para o objeto não alternar entre dois níveis na divisa
+int lodLevels = MAX_MESH_LODS;
+float lodErrorPixels = 1.0f;
+float lodHysteresis = 0.25f;
+std::vector<unsigned char> objectLod; //por objeto, nível escolhido no frame
+
+// Tamanho das malhas carregadas e triângulos enviados/reais por frame
+DrawStats drawStats;
+
+// Câmera, projeção e luz (bloco FrameData dos shaders), enviados uma vez por frame
+FrameUniforms frameUniforms;
+
+// Desenhos por objeto ordenados por textura, malha e profundidade (padrão: ligado) e
+// trocas de estado filtradas pelo stateCache em todos os caminhos de desenho
+bool sortDraws = true;
+RenderQueue renderQueue;
+GLStateCache stateCache;
+const float FAR_PLANE = 100.0f;
+
+// Objetos fora do tronco de visão não são desenhados em nenhum caminho (padrão: ligado)
+bool useFrustumCulling = true;
+FrustumCuller frustumCuller;
+std::vector<unsigned char> objectVisible; //por objeto, resultado do último frame
+
+// Recorte hierárquico pela BVH das caixas dos objetos no mundo, que também responde ao
+// clique de seleção (padrão: ligado; desligado, o frustumCuller testa todos os objetos)
+bool useBVH = true;
+DynamicBVH objectBVH;
+
+// Objetos com a mesma malha, materiais e textura desenhados juntos: um desenho
+// instanciado por faixa de material, com as matrizes no instanceBuffer (padrão: ligado)
+struct InstanceGroup
+{
+	std::vector<int> objects; //índices em objects; o primeiro dá malha, materiais e textura
+	GLsizei visible[MAX_MESH_LODS] = {}; //instâncias que passaram pelo recorte no frame, por nível de detalhe
+};
+bool useInstancing = true;
+InstanceBuffer instanceBuffer;
+std::vector<InstanceGroup> instanceGroups;
+std::vector<InstanceData> instanceData;
+bool instanceGroupsDirty = true; //refazer os grupos (ex: a textura de um objeto ficou pronta)
+
+// Malhas subalocadas em poucos buffers grandes, um VAO por layout de vértice (padrão: ligado)
+bool useGeometryPool = true;
+GeometryPool geometryPool;
+
+// Cena inteira em poucos glMultiDrawElementsIndirect: um comando por grupo de instâncias e
+// faixa de material, com os coeficientes na materialTable; um envio por VAO e textura
+// (padrão: ligado; exige o geometryPool)
+struct IndirectBatch
+{
+	GLuint VAO = 0;
+	GLuint texID = 0; //textura comum (textureArray < 0)
+	int textureArray = -1;
+	size_t first = 0; //primeiro comando em indirectCommands
+	size_t count = 0;
+};
+struct IndirectSource
+{
+	int group = -1; //grupo de instâncias em instanceGroups
+	int lod = 0; //nível de detalhe (o comando leva só os objetos do grupo nesse nível)
+	int material = -1; //índice na materialTable
+	int meshStats = -1;
+	GLint first = 0; //faixa de desenho (relativa à malha)
+};
+bool useMultiDrawIndirect = true;
+IndirectDrawBuffer indirectDraws;
+MaterialTable materialTable;
+const int MATERIAL_TABLE_UNIT = 1 + MAX_TEXTURE_ARRAYS; //depois da textura comum e dos arrays
+std::vector<DrawElementsIndirectCommand> indirectCommands;
+std::vector<IndirectSource> indirectSources; //origem de cada comando
+std::vector<IndirectBatch> indirectBatches;
+size_t indirectInstances = 0; //máximo de instâncias de um frame (cada objeto em um só nível)
+
+// Texturas compartilhadas entre os objetos (uma por arquivo e parâmetros de amostragem)
+TextureCache textureCache;
+
+// Decodificação das texturas em segundo plano e envio de até textureUploadBudget bytes
+// por frame; até lá os objetos usam a textura provisória
+TextureStreamer textureStreamer;
+bool streamTextures = true;
+size_t textureUploadBudget = 4 * 1024 * 1024;
+
+// Níveis de mipmap enviados conforme o tamanho dos objetos na tela, dentro do orçamento
+bool streamMips = true;
+size_t textureMemoryBudget = 64 * 1024 * 1024;
+
+// Lado máximo das imagens na GPU (0: tamanho original); cada objeto pode sobrescrever
+int maxTextureSize = 0;
+
+// Texturas da cena empacotadas em arrays (sem troca de textura entre os desenhos)
+TextureArrays textureArrays;
+bool useTextureArrays = false;
+
 int selectedObjectIndex = -1;
 
 // Função MAIN
-int main()
+int main(int argc, char** argv)
 {
+	// Modos de linha de comando (benchmarks) rodam sem abrir a janela; --scene só troca
+	// o arquivo da cena
+	std::string sceneJsonFilePath = "./sceneConfig.json";
+	if (argc > 2 && std::string(argv[1]) == "--scene")
+	{
+		sceneJsonFilePath = argv[2];
+	}
+	else if (argc > 1)
+	{
+		return runCommandLineMode(argc, argv);
+	}
+
 	// Inicialização da GLFW
 	glfwInit();
 
@@ -114,6 +352,8 @@ int main()
 
     glfwSetKeyCallback(window, key_callback);
 
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+
 	// Desabilita o cursor do mouse na janela
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -130,6 +370,10 @@ int main()
 	cout << "Renderer: " << renderer << endl;
 	cout << "OpenGL version supported " << version << endl;
 
+	// Desenho indireto de vários comandos por chamada (OpenGL 4.3, fora do GLAD)
+	if (!loadMultiDrawIndirect((GLADloadproc)glfwGetProcAddress))
+		cout << "glMultiDrawElementsIndirect indisponivel: desenho indireto desligado" << endl;
+
 	// Definindo as dimensões da viewport com as mesmas dimensões da janela da aplicação
 	int width, height;
 	glfwGetFramebufferSize(window, &width, &height);
@@ -138,39 +382,55 @@ int main()
 	// Compilando e buildando o programa de shader
 	Shader shader("phong.vs","phong.fs");
 
-	std::string sceneJsonFilePath = "./sceneConfig.json";
+	textureStreamer.initialize();
+	frameUniforms.initialize();
+	instanceBuffer.initialize();
+	indirectDraws.initialize();
+	materialTable.initialize();
+
+	double loadStartTime = glfwGetTime();
 	loadSceneConfig(sceneJsonFilePath);
+	cout << "Tempo de carregamento da cena: " << 1000.0 * (glfwGetTime() - loadStartTime) << " ms" << endl;
+	geometryPool.report(cout);
 	glUseProgram(shader.ID);
+	PhongUniforms uniforms(shader);
 
 	//Matriz de modelo
 	glm::mat4 model = glm::mat4(1); //matriz identidade;
-	GLint modelLoc = glGetUniformLocation(shader.ID, "model");
 	model = glm::rotate(model, /*(GLfloat)glfwGetTime()*/glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	uniforms.model.set(glm::value_ptr(model));
 
-	//Matriz de view
-	glm::mat4 view = glm::lookAt(cameraPos,glm::vec3(0.0f,0.0f,0.0f),cameraUp);
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-
-	//Matriz de projeção
-	glm::mat4 projection = glm::perspective(glm::radians(39.6f),(float)WIDTH/HEIGHT,0.1f,100.0f);
-	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	//Matriz de projeção e fonte de luz no uniform buffer do frame (view e câmera mudam a cada frame)
+	frameUniforms.attach(shader);
+	frameUniforms.setProjection(glm::perspective(glm::radians(FIELD_OF_VIEW),(float)WIDTH/HEIGHT,0.1f,FAR_PLANE));
+	frameUniforms.setLight(lightPos, lightColor);
 
 	//Buffer de textura no shader
-	glUniform1i(glGetUniformLocation(shader.ID, "texBuffer"), 0);
+	uniforms.texBuffer.set(0);
+
+	//Arrays de textura nas unidades seguintes (samplers de tipos diferentes não podem dividir uma unidade)
+	GLint arrayUnits[MAX_TEXTURE_ARRAYS];
+	for (int i = 0; i < MAX_TEXTURE_ARRAYS; i++)
+		arrayUnits[i] = 1 + i;
+	uniforms.textureArrays.set(arrayUnits, MAX_TEXTURE_ARRAYS);
+
+	//Tabela de materiais dos desenhos indiretos na unidade seguinte
+	uniforms.materialTable.set(MATERIAL_TABLE_UNIT);
 
 	glEnable(GL_DEPTH_TEST);
 	glActiveTexture(GL_TEXTURE0);
 
-	//Propriedades da superfície
-	shader.setFloat("ka",0.2);
-	shader.setFloat("ks", 1);
-	shader.setFloat("kd", 1);
-	shader.setFloat("q", 10.0);
+	//Propriedades da superfície (ka, kd e ks vêm do material de cada faixa de desenho)
+	uniforms.q.set(10.0f);
 
-	//Propriedades da fonte de luz
-	shader.setVec3("lightPos", lightPos.x, lightPos.y, lightPos.z);
-	shader.setVec3("lightColor", lightColor.r, lightColor.g, lightColor.b);  // Aumentar a intensidade
+	// Medição de desempenho: intervalo médio entre frames e tempos de CPU e GPU do renderObjects
+	GLuint gpuTimerQueries[2];
+	glGenQueries(2, gpuTimerQueries);
+	int frameCount = 0, statsFrames = 0;
+	double statsStartTime = glfwGetTime();
+	double gpuMilliseconds = 0.0, cpuMilliseconds = 0.0;
+	std::vector<TextureStreamer::Completed> completedTextures;
+	bool texturesResident = textureStreamer.pendingCount() == 0;
 
 	// Loop da aplicação - "game loop"
 	while (!glfwWindowShouldClose(window))
@@ -187,70 +447,717 @@ int main()
 
 		float angle = (GLfloat)glfwGetTime();
 
-		renderObjects(shader, angle, modelLoc);
+		// Envia mais uma parte das texturas e troca a provisória pelas que ficaram prontas
+		textureStreamer.update(textureUploadBudget, textureCache, completedTextures);
+		for (const TextureStreamer::Completed& completed : completedTextures)
+		{
+			for (Object& obj : objects)
+			{
+				if (obj.textureRequest == completed.request)
+				{
+					obj.texID = completed.texture;
+					obj.textureRequest = -1;
+					instanceGroupsDirty = true;
+				}
+			}
+		}
+		if (!texturesResident && textureStreamer.pendingCount() == 0)
+		{
+			texturesResident = true;
+			cout << "Texturas residentes apos " << 1000.0 * (glfwGetTime() - loadStartTime) << " ms e "
+				<< frameCount + 1 << " frames (" << textureStreamer.uploadedBytes() / 1024 << " KB pelos PBOs)" << endl;
+			textureCache.report(cout);
+		}
+
+		// Nível de mipmap de que cada objeto precisa neste frame (atendido nos próximos updates)
+		requireTextureMips();
+
+		glBeginQuery(GL_TIME_ELAPSED, gpuTimerQueries[frameCount % 2]);
+		double renderStartTime = glfwGetTime();
+		renderObjects(uniforms, angle);
+		cpuMilliseconds += 1000.0 * (glfwGetTime() - renderStartTime);
+		glEndQuery(GL_TIME_ELAPSED);
+		drawStats.endFrame();
+		stateCache.endFrame();
+		objectBVH.endFrame();
 
 		// Troca os buffers da tela
 		glfwSwapBuffers(window);
 
 		userKeyInput(window);
+
+		// Lê a consulta do frame anterior, que a GPU já terminou
+		if (frameCount > 0)
+		{
+			GLuint64 elapsedNs = 0;
+			glGetQueryObjectui64v(gpuTimerQueries[(frameCount + 1) % 2], GL_QUERY_RESULT, &elapsedNs);
+			gpuMilliseconds += elapsedNs / 1.0e6;
+			statsFrames++;
+		}
+		frameCount++;
+
+		double now = glfwGetTime();
+		if (now - statsStartTime >= 5.0 && statsFrames > 0)
+		{
+			cout << "Frame: " << 1000.0 * (now - statsStartTime) / statsFrames << " ms, CPU (renderObjects): "
+				<< cpuMilliseconds / statsFrames << " ms, GPU (renderObjects): " << gpuMilliseconds / statsFrames << " ms" << endl;
+			drawStats.report(cout);
+			drawStats.reset();
+			stateCache.report(cout);
+			stateCache.reset();
+			if (useBVH)
+			{
+				objectBVH.report(cout);
+				objectBVH.reset();
+			}
+			if (textureStreamer.streamsMips())
+				textureStreamer.residency().report(cout);
+			statsStartTime = now;
+			statsFrames = 0;
+			gpuMilliseconds = 0.0;
+			cpuMilliseconds = 0.0;
+		}
 	}
 
-	// Pede pra OpenGL desalocar os buffers
+	glDeleteQueries(2, gpuTimerQueries);
+
+	// Pede pra OpenGL desalocar os buffers e as texturas
 	for (int i = 0; i < objects.size(); i ++) {
-		glDeleteVertexArrays(1, &objects[i].VAO);
+		if (!objects[i].sharedMesh) {
+			glDeleteVertexArrays(1, &objects[i].VAO);
+			glDeleteBuffers(1, &objects[i].VBO);
+			glDeleteBuffers(1, &objects[i].EBO);
+		}
+		if (objects[i].textureRequest < 0)
+			textureCache.release(objects[i].texID);
 	}
+	textureStreamer.shutdown();
+	textureArrays.clear();
+	frameUniforms.shutdown();
+	instanceBuffer.shutdown();
+	indirectDraws.shutdown();
+	materialTable.shutdown();
+	geometryPool.clear();
 	// Finaliza a execução da GLFW, limpando os recursos alocados por ela
 	glfwTerminate();
 	return 0;
 }
 
-void renderObjects(Shader& shader, float angle, GLint modelLoc) {
-    for (Object& obj : objects) {
-        obj.model = glm::mat4(1.0f);
-		
-		if (!obj.curve.curvePoints.empty()){
-			obj.position = obj.curve.curvePoints[obj.curveIndex];
-
-			// Incrementando o índice do frame apenas quando fechar a taxa de FPS desejada
-			auto now = glfwGetTime();
-			auto dt = now - obj.curveLastTime;
+// Modos auxiliares, ex: Source.exe --bench-obj [arquivos .obj]
+int runCommandLineMode(int argc, char** argv)
+{
+	string mode = argv[1];
+	vector<string> args(argv + 2, argv + argc);
 
-			if (dt >= 1 / obj.curveFPS)
+	// Sem arquivos na linha de comando, os modos de malha usam todos os .obj do repositório (GB e GA)
+	bool meshMode = mode == "--bench-obj" || mode == "--bench-mesh-opt" || mode == "--check-meshes" || mode == "--check-lods";
+	if (meshMode && args.empty())
+	{
+		for (string folder : { "./obj", "../../TrabalhoGA - Computacao Grafica/Trabalho GA - Computacao Grafica/obj" })
+		{
+			if (!std::filesystem::exists(folder))
+				continue;
+			for (const auto& entry : std::filesystem::directory_iterator(folder))
 			{
-				obj.curveIndex = (obj.curveIndex + 1) % obj.curve.curvePoints.size(); // incrementando ciclicamente o indice do Frame
-				obj.curveLastTime = now;
-				glm::vec3 nextPos = obj.curve.curvePoints[obj.curveIndex];
-				glm::vec3 dir = glm::normalize(nextPos - obj.position);
-				obj.curveAngle = atan2(dir.y, dir.x) + glm::radians(-90.0f);
+				if (entry.path().extension() == ".obj")
+					args.push_back(entry.path().string());
 			}
 		}
+	}
+
+	if (mode == "--bench-obj")
+	{
+		benchmarkOBJLoaders(args);
+		return 0;
+	}
 
-		obj.model = glm::translate(obj.model, obj.position);
-		obj.model = glm::scale(obj.model, glm::vec3(obj.scale.x, obj.scale.y, obj.scale.z));
-		
-		if (obj.rotation.x != 0 || obj.rotation.y != 0 || obj.rotation.z != 0){
-			obj.model = glm::rotate(obj.model, angle, glm::vec3(obj.rotation.x, obj.rotation.y, obj.rotation.z));
+	if (mode == "--bench-mesh-opt")
+	{
+		benchmarkMeshOptimizer(args);
+		return 0;
+	}
+
+	if (mode == "--check-lods")
+	{
+		// Triângulos e erro medido de cada nível de detalhe: --check-lods [arquivos .obj]
+		return checkMeshLods(args) ? 0 : 1;
+	}
+
+	// Sem arquivos na linha de comando, os modos de textura usam as imagens de ./texture
+	bool textureMode = mode == "--bake-textures" || mode == "--bench-mips" || mode == "--bench-resample";
+
+	// --bench-resample aceita o lado máximo antes das imagens (padrão: 512)
+	int resampleSize = 512;
+	if (mode == "--bench-resample" && !args.empty() && !args[0].empty() && std::all_of(args[0].begin(), args[0].end(), ::isdigit))
+	{
+		resampleSize = std::stoi(args[0]);
+		args.erase(args.begin());
+	}
+	if (textureMode && args.empty() && std::filesystem::exists("./texture"))
+	{
+		for (const auto& entry : std::filesystem::directory_iterator("./texture"))
+		{
+			string extension = entry.path().extension().string();
+			if (extension == ".jpg" || extension == ".jpeg" || extension == ".png" || extension == ".bmp" || extension == ".tga")
+				args.push_back(entry.path().string());
 		}
+	}
+
+	if (mode == "--bench-mips")
+	{
+		// Geração dos mipmaps na CPU (escalar, SSE2, AVX2; caixa e Kaiser): --bench-mips [imagens]
+		benchmarkMipChain(args);
+		return 0;
+	}
+
+	if (mode == "--bench-resample")
+	{
+		// Redução das imagens a um lado máximo (escalar, SSE2, AVX2) e carga com o limite: --bench-resample [lado] [imagens]
+		benchmarkResample(args, resampleSize);
+		return 0;
+	}
 
-		shader.setFloat("ka", obj.ka);
-		shader.setFloat("ks", obj.ks);
-		shader.setFloat("kd", obj.kd);
+	if (mode == "--bake-textures")
+	{
+		// Comprime as imagens em KTX2 (BC1/BC3 com mipmaps): --bake-textures [imagens]
+		return bakeTextures(args) ? 0 : 1;
+	}
+
+	if (mode == "--bench-render-queue")
+	{
+		// Ordenação das chaves de desenho (radix, std::sort, std::stable_sort): --bench-render-queue [desenhos]
+		size_t draws = args.empty() ? 10000 : std::stoul(args[0]);
+		benchmarkRenderQueue(draws);
+		return 0;
+	}
+
+	if (mode == "--bench-culling")
+	{
+		// Recorte pelo tronco de visão (escalar, SSE2, AVX2): --bench-culling [objetos]
+		size_t count = args.empty() ? 100000 : std::stoul(args[0]);
+		benchmarkFrustumCulling(count);
+		return 0;
+	}
+
+	if (mode == "--bench-bvh")
+	{
+		// BVH dos objetos contra a busca linear, de 1 mil objetos até o máximo: --bench-bvh [objetos]
+		size_t count = args.empty() ? 1000000 : std::stoul(args[0]);
+		benchmarkBVH(count);
+		return 0;
+	}
+
+	if (mode == "--check-mip-residency")
+	{
+		// Cenários do agendador de níveis de mipmap (sem GPU): --check-mip-residency
+		return checkMipResidency() ? 0 : 1;
+	}
+
+	if (mode == "--check-meshes")
+	{
+		// Prepara cada malha como no carregamento da cena (sem GL) e confere faixas e índices
+		DrawStats stats;
+		bool allValid = true;
+		for (const string& file : args)
+		{
+			PreparedMesh prepared;
+			if (!prepareMesh(file, OBJLoadOptions(), meshOptimization, VERTEX_FORMAT_PACKED, lodLevels, false, prepared))
+			{
+				cout << "Erro ao tentar ler o arquivo " << file << endl;
+				allValid = false;
+				continue;
+			}
+			const MeshStats& mesh = stats.mesh(stats.registerMesh(file, prepared.layout, prepared.vertexBytes, prepared.indexData, prepared.indexBytes));
+			cout << file << ": " << mesh.vertexCount << " vertices, " << mesh.indexCount << " indices, "
+				<< mesh.triangleCount << " triangulos, " << mesh.lodCount << " nivel(is) de detalhe, " << prepared.layout.submeshes.size() << " faixa(s), "
+				<< (mesh.vertexBytes + mesh.indexBytes) / 1024 << " KB - " << (mesh.valid ? "ok" : "INVALIDA") << endl;
+			allValid = allValid && mesh.valid;
+		}
+		return allValid ? 0 : 1;
+	}
+
+	if (mode == "--bench-obj-threads")
+	{
+		// Parser paralelo em um .obj ampliado: --bench-obj-threads [arquivo] [copias] [threads]
+		string source = args.size() > 0 ? args[0] : "../../TrabalhoGA - Computacao Grafica/Trabalho GA - Computacao Grafica/obj/Nave.obj";
+		int copies = args.size() > 1 ? std::stoi(args[1]) : 300;
+		unsigned int maxThreads = args.size() > 2 ? (unsigned int)std::stoi(args[2]) : std::thread::hardware_concurrency();
+		maxThreads = std::max(1u, maxThreads);
+		benchmarkOBJParallel(source, copies, maxThreads);
+		return 0;
+	}
+
+	if (mode == "--bench-obj-memory")
+	{
+		// Pico de memória do parser com e sem a passada de contagem: --bench-obj-memory [arquivo] [copias]
+		string source = args.size() > 0 ? args[0] : "../../TrabalhoGA - Computacao Grafica/Trabalho GA - Computacao Grafica/obj/Nave.obj";
+		int copies = args.size() > 1 ? std::stoi(args[1]) : 300;
+		benchmarkOBJMemory(source, copies);
+		return 0;
+	}
+
+	cout << "Modo desconhecido: " << mode << endl;
+	cout << "Modos disponiveis: --bench-obj [arquivos .obj], --bench-obj-threads [arquivo .obj] [copias] [threads], --bench-obj-memory [arquivo .obj] [copias], --bench-mesh-opt [arquivos .obj], --check-meshes [arquivos .obj], --check-lods [arquivos .obj], --bake-textures [imagens], --bench-mips [imagens], --bench-resample [lado] [imagens], --check-mip-residency, --bench-render-queue [desenhos], --bench-culling [objetos], --bench-bvh [objetos]" << endl;
+	cout << "Outra cena na janela: --scene arquivo.json" << endl;
+	return 1;
+}
+
+void renderObjects(const PhongUniforms& uniforms, float angle) {
+    // Os arrays de textura (e a tabela de materiais) ficam ligados o frame inteiro; o
+    // envio das texturas entre os frames mexe nas ligações, então o stateCache recomeça
+    textureArrays.bind(GL_TEXTURE1);
+    if (useMultiDrawIndirect) {
+        materialTable.bind(GL_TEXTURE0 + MATERIAL_TABLE_UNIT);
+    }
+    stateCache.invalidate();
+
+    // Matriz de visão e posição da câmera valem para o frame inteiro: um envio do bloco
+    frameUniforms.setCamera(glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp), cameraPos);
+    frameUniforms.upload();
+
+    // Matriz de modelo e limites no mundo de cada objeto na mesma passada (os objetos são
+    // grandes: uma segunda leitura de todos custa mais que o próprio teste)
+    if (!useBVH) {
+        frustumCuller.resize(objects.size());
+    }
+    bool buildBVH = false;
+    for (size_t i = 0; i < objects.size(); i++) {
+        Object& obj = objects[i];
+        glm::mat4 previousModel = obj.model;
+        updateObjectModel(obj, angle);
+        if (useBVH) {
+            // Só quem mudou de matriz mexe na BVH: os objetos nas curvas se deslocam (a folha
+            // é reinserida ao sair da folga), os outros mudam a caixa no lugar (ex: giram)
+            if (obj.bvhLeaf < 0) {
+                buildBVH = true;
+            } else if (obj.model != previousModel) {
+                Aabb box = objectBounds(obj);
+                if (box.min != obj.bvhBox.min || box.max != obj.bvhBox.max) {
+                    obj.bvhBox = box;
+                    if (obj.curve.curvePoints.empty()) {
+                        objectBVH.refit(obj.bvhLeaf, box);
+                    } else {
+                        objectBVH.move(obj.bvhLeaf, box);
+                    }
+                }
+            }
+        } else if (useFrustumCulling) {
+            frustumCuller.setBounds(i, obj.model, obj.boundsMin, obj.boundsMax, obj.sphereCenter, obj.sphereRadius);
+        }
+    }
+    if (buildBVH) {
+        // Objetos novos (primeiro frame): a árvore inteira de uma vez
+        std::vector<Aabb> boxes(objects.size());
+        std::vector<int> leaves;
+        for (size_t i = 0; i < objects.size(); i++) {
+            objects[i].bvhBox = objectBounds(objects[i]);
+            boxes[i] = objects[i].bvhBox;
+        }
+        objectBVH.build(boxes, leaves);
+        for (size_t i = 0; i < objects.size(); i++) {
+            objects[i].bvhLeaf = leaves[i];
+        }
+    }
+    cullObjects();
+
+    // Nível de detalhe só dos objetos visíveis; os recortados guardam o último nível, de
+    // onde a escolha parte quando voltam
+    objectLod.resize(objects.size(), 0);
+    size_t lodObjects[MAX_MESH_LODS] = {};
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objectVisible[i] && objects[i].lodCount > 1) {
+            objectLod[i] = (unsigned char)selectObjectLod(objects[i], objectLod[i]);
+        }
+        lodObjects[objectLod[i]] += objectVisible[i];
+    }
+    drawStats.recordLods(lodObjects);
+
+    if (useMultiDrawIndirect) {
+        renderIndirect(uniforms);
+        return;
+    }
+    if (useInstancing) {
+        renderInstanced(uniforms);
+        return;
+    }
+
+    // Um desenho por objeto (e por faixa de material), na ordem da fila: textura, malha e
+    // profundidade da frente para trás (um só passo e um só programa: campos em zero)
+    renderQueue.clear();
+    glm::vec3 front = glm::normalize(cameraFront);
+    for (int i = 0; i < (int)objects.size(); i++) {
+        const Object& obj = objects[i];
+        if (!objectVisible[i]) {
+            continue;
+        }
+        unsigned texture = obj.textureArray >= 0 ? 1 + obj.textureArray : 1 + MAX_TEXTURE_ARRAYS + obj.texID;
+        glm::vec3 center = glm::vec3(obj.model * glm::vec4(0.5f * (obj.boundsMin + obj.boundsMax), 1.0f));
+        float depth = glm::dot(center - cameraPos, front);
+        renderQueue.push(makeDrawKey(0, 0, texture, (unsigned)(obj.meshStats + 1), depth, FAR_PLANE), i);
+    }
+    if (sortDraws) {
+        renderQueue.sort();
+    }
+
+    stateCache.set(uniforms.instanced, 0);
+    for (const RenderQueue::Item& item : renderQueue.items()) {
+        const Object& obj = objects[item.index];
+
+        // Desquantização da posição (escala 1 e deslocamento 0 no formato float)
+        stateCache.set(uniforms.posScale, glm::value_ptr(obj.posScale));
+        stateCache.set(uniforms.posOffset, glm::value_ptr(obj.posOffset));
 
         // Atualizar a matriz de modelo no shader
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(obj.model));
+        uniforms.model.set(glm::value_ptr(obj.model));
 
-        // Atualizar a matriz de visão no shader
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        // Um VAO por objeto (ou por malha, se compartilhada, ou por bloco do geometryPool)
+        stateCache.bindVertexArray(obj.VAO);
+        bindObjectTexture(uniforms, obj);
+        drawObjectRanges(uniforms, obj, objectLod[item.index], 0);
+    }
+}
 
-        // Propriedades da câmera
-        shader.setVec3("cameraPos", cameraPos.x, cameraPos.y, cameraPos.z);
+void renderInstanced(const PhongUniforms& uniforms) {
+    if (instanceGroupsDirty) {
+        buildInstanceGroups();
+        instanceGroupsDirty = false;
+    }
 
-        // Chamada de desenho - drawcall
-        // Poligono Preenchido - GL_TRIANGLES
-        glBindVertexArray(obj.VAO);
-		glBindTexture(GL_TEXTURE_2D,obj.texID);
-        glDrawArrays(GL_TRIANGLES, 0, obj.nVertices);
+    // Matrizes e desquantizações dos objetos visíveis no buffer de instâncias, na ordem dos
+    // grupos e, dentro de cada grupo, dos níveis de detalhe
+    size_t instanceCount = 0;
+    for (const InstanceGroup& group : instanceGroups) {
+        instanceCount += group.objects.size();
+    }
+    instanceData.resize(instanceCount);
+    size_t next = 0;
+    for (InstanceGroup& group : instanceGroups) {
+        int lodCount = objects[group.objects[0]].lodCount;
+        for (int lod = 0; lod < lodCount; lod++) {
+            group.visible[lod] = 0;
+            for (int index : group.objects) {
+                if (!objectVisible[index] || objectLod[index] != lod) {
+                    continue;
+                }
+                const Object& obj = objects[index];
+                instanceData[next].model = obj.model;
+                instanceData[next].posScale = glm::vec4(obj.posScale, (float)obj.textureLayer);
+                instanceData[next].posOffset = glm::vec4(obj.posOffset, -1.0f);
+                next++;
+                group.visible[lod]++;
+            }
+        }
+    }
+    instanceData.resize(next);
+    instanceBuffer.upload(instanceData);
+
+    // Um desenho por grupo, nível de detalhe e faixa de material; malha, textura e materiais
+    // vêm do primeiro objeto do grupo, que são iguais nos outros
+    stateCache.set(uniforms.instanced, 1);
+    size_t first = 0;
+    for (const InstanceGroup& group : instanceGroups) {
+        const Object& obj = objects[group.objects[0]];
+        for (int lod = 0; lod < obj.lodCount; lod++) {
+            if (group.visible[lod] == 0) {
+                continue;
+            }
+            stateCache.bindVertexArray(obj.VAO);
+            instanceBuffer.point(first);
+            bindObjectTexture(uniforms, obj);
+            drawObjectRanges(uniforms, obj, lod, group.visible[lod]);
+            first += group.visible[lod];
+        }
+    }
+}
+
+void renderIndirect(const PhongUniforms& uniforms) {
+    if (instanceGroupsDirty) {
+        buildInstanceGroups();
+        buildIndirectCommands();
+        instanceGroupsDirty = false;
+    }
+
+    // Dados por instância dos objetos visíveis de cada comando a partir do seu baseInstance;
+    // um grupo com várias faixas de material repete as suas instâncias em cada comando, e
+    // cada comando leva só os objetos do grupo no seu nível de detalhe. As quantidades
+    // mudam com o recorte e os níveis, então os comandos são reenviados a cada frame
+    instanceData.resize(indirectInstances);
+    size_t next = 0;
+    for (size_t c = 0; c < indirectCommands.size(); c++) {
+        indirectCommands[c].baseInstance = (GLuint)next;
+        float material = (float)indirectSources[c].material;
+        int lod = indirectSources[c].lod;
+        for (int index : instanceGroups[indirectSources[c].group].objects) {
+            if (!objectVisible[index] || objectLod[index] != lod) {
+                continue;
+            }
+            const Object& obj = objects[index];
+            instanceData[next].model = obj.model;
+            instanceData[next].posScale = glm::vec4(obj.posScale, (float)obj.textureLayer);
+            instanceData[next].posOffset = glm::vec4(obj.posOffset, material);
+            next++;
+        }
+        indirectCommands[c].instanceCount = (GLuint)(next - indirectCommands[c].baseInstance);
+    }
+    instanceData.resize(next);
+    instanceBuffer.upload(instanceData);
+    indirectDraws.upload(indirectCommands);
+
+    stateCache.set(uniforms.instanced, 1);
+
+    // Um envio por lote; os atributos de instância começam no início do buffer e o
+    // baseInstance de cada comando escolhe o seu trecho
+    for (const IndirectBatch& batch : indirectBatches) {
+        if (stateCache.bindVertexArray(batch.VAO)) {
+            instanceBuffer.point(0);
+        }
+        stateCache.set(uniforms.textureArray, batch.textureArray);
+        if (batch.textureArray < 0 && stateCache.bindTexture(GL_TEXTURE0, GL_TEXTURE_2D, batch.texID)) {
+            drawStats.recordTextureBind();
+        }
+        for (size_t c = batch.first; c < batch.first + batch.count; c++) {
+            const DrawElementsIndirectCommand& command = indirectCommands[c];
+            if (command.instanceCount == 0) {
+                continue;
+            }
+            drawStats.recordDraw(indirectSources[c].meshStats, indirectSources[c].first, (GLsizei)command.count, (GLsizei)command.instanceCount);
+        }
+        indirectDraws.draw(batch.first, batch.count);
+        drawStats.recordMultiDraw(batch.count);
+    }
+}
+
+void buildIndirectCommands() {
+    // Um comando por grupo, nível de detalhe e faixa de material (instanceCount e baseInstance
+    // vêm do recorte de cada frame); faixas inválidas (já relatadas no registerMesh) ficam de
+    // fora. Cada objeto entra nos comandos de um só nível: o máximo de instâncias por frame é
+    // o tamanho do grupo vezes o número de faixas do nível que mais tem
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<IndirectSource> sources;
+    materialTable.clear();
+    indirectInstances = 0;
+    for (int g = 0; g < (int)instanceGroups.size(); g++) {
+        const Object& obj = objects[instanceGroups[g].objects[0]];
+        size_t rangesOfLod[MAX_MESH_LODS] = {};
+        for (const DrawRange& range : obj.drawRanges) {
+            if (range.count == 0 || !drawStats.validateRange(obj.meshStats, range.first, range.count)) {
+                continue;
+            }
+            static const Material defaultMaterial;
+            const Material& material = range.material >= 0 ? obj.materials[range.material] : defaultMaterial;
+
+            DrawElementsIndirectCommand command;
+            command.count = (GLuint)range.count;
+            command.firstIndex = obj.firstIndex + (GLuint)range.first;
+            command.baseVertex = obj.baseVertex;
+            commands.push_back(command);
+
+            IndirectSource source;
+            source.group = g;
+            source.lod = range.lod;
+            source.material = materialTable.add(material.ka, material.kd, material.ks);
+            source.meshStats = obj.meshStats;
+            source.first = range.first;
+            sources.push_back(source);
+            rangesOfLod[range.lod]++;
+        }
+        indirectInstances += instanceGroups[g].objects.size() * *std::max_element(rangesOfLod, rangesOfLod + MAX_MESH_LODS);
+    }
+
+    // Lotes de mesmo VAO e textura; a ordem estável mantém a dos objetos dentro de cada lote
+    auto batchKey = [&](size_t c) {
+        const Object& obj = objects[instanceGroups[sources[c].group].objects[0]];
+        return std::make_tuple(obj.VAO, obj.textureArray, obj.textureArray < 0 ? obj.texID : 0u);
+    };
+    std::vector<size_t> order(commands.size());
+    for (size_t c = 0; c < order.size(); c++) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return batchKey(a) < batchKey(b); });
+
+    indirectCommands.clear();
+    indirectSources.clear();
+    indirectBatches.clear();
+    for (size_t c : order) {
+        const Object& obj = objects[instanceGroups[sources[c].group].objects[0]];
+        if (indirectBatches.empty() || batchKey(c) != batchKey(order[indirectCommands.size() - 1])) {
+            IndirectBatch batch;
+            batch.VAO = obj.VAO;
+            batch.texID = obj.texID;
+            batch.textureArray = obj.textureArray;
+            batch.first = indirectCommands.size();
+            indirectBatches.push_back(batch);
+        }
+        indirectCommands.push_back(commands[c]);
+        indirectSources.push_back(sources[c]);
+        indirectBatches.back().count++;
+    }
+    materialTable.upload();
+}
+
+void buildInstanceGroups() {
+    // Mesma malha (VAO e posição no geometryPool), mesma textura (ou o mesmo array) e
+    // materiais iguais; a camada do array muda de uma instância para a outra. Objetos
+    // sem malha ficam de fora
+    instanceGroups.clear();
+    std::map<std::tuple<GLuint, GLuint, GLint, GLuint, int>, std::vector<int>> groupsOfKey;
+    for (int i = 0; i < (int)objects.size(); i++) {
+        const Object& obj = objects[i];
+        if (obj.VAO == 0) {
+            continue;
+        }
+        std::vector<int>& candidates = groupsOfKey[std::make_tuple(obj.VAO, obj.firstIndex, obj.baseVertex, obj.texID, obj.textureArray)];
+        int group = -1;
+        for (int candidate : candidates) {
+            const Object& other = objects[instanceGroups[candidate].objects[0]];
+            bool sameMaterials = other.materials.size() == obj.materials.size();
+            for (size_t m = 0; sameMaterials && m < obj.materials.size(); m++) {
+                const Material& a = obj.materials[m];
+                const Material& b = other.materials[m];
+                sameMaterials = a.name == b.name && a.ka == b.ka && a.kd == b.kd && a.ks == b.ks;
+            }
+            if (sameMaterials) {
+                group = candidate;
+                break;
+            }
+        }
+        if (group < 0) {
+            group = (int)instanceGroups.size();
+            instanceGroups.emplace_back();
+            candidates.push_back(group);
+        }
+        instanceGroups[group].objects.push_back(i);
+    }
+}
+
+void cullObjects() {
+    // Limites no mundo (já atualizados com a matriz de modelo do frame) contra o tronco de
+    // projection * view
+    objectVisible.resize(objects.size());
+    if (!useFrustumCulling) {
+        std::fill(objectVisible.begin(), objectVisible.end(), 1);
+        return;
+    }
+    Frustum frustum = Frustum::fromMatrix(frameUniforms.values().viewProjection);
+    size_t visible = useBVH ? objectBVH.cull(frustum, objectVisible) : frustumCuller.cull(frustum, objectVisible);
+    drawStats.recordCulling(visible, objects.size() - visible);
+}
+
+Aabb objectBounds(const Object& obj) {
+    // Objetos que giram no lugar ficam com a caixa da esfera ao redor da origem do modelo que
+    // cobre todas as rotações: o ângulo do frame não muda a caixa e a BVH não é refeita
+    if (obj.rotation.x == 0 && obj.rotation.y == 0 && obj.rotation.z == 0) {
+        return Aabb::transformed(obj.model, obj.boundsMin, obj.boundsMax);
+    }
+    float maxScale = std::max(std::fabs(obj.scale.x), std::max(std::fabs(obj.scale.y), std::fabs(obj.scale.z)));
+    glm::vec3 reach = glm::vec3((glm::length(obj.sphereCenter) + obj.sphereRadius) * maxScale);
+    return { obj.position - reach, obj.position + reach };
+}
+
+void updateObjectModel(Object& obj, float angle) {
+    obj.model = glm::mat4(1.0f);
+
+    if (!obj.curve.curvePoints.empty()){
+        obj.position = obj.curve.curvePoints[obj.curveIndex];
+
+        // Incrementando o índice do frame apenas quando fechar a taxa de FPS desejada
+        auto now = glfwGetTime();
+        auto dt = now - obj.curveLastTime;
+
+        if (dt >= 1 / obj.curveFPS)
+        {
+            obj.curveIndex = (obj.curveIndex + 1) % obj.curve.curvePoints.size(); // incrementando ciclicamente o indice do Frame
+            obj.curveLastTime = now;
+            glm::vec3 nextPos = obj.curve.curvePoints[obj.curveIndex];
+            glm::vec3 dir = glm::normalize(nextPos - obj.position);
+            obj.curveAngle = atan2(dir.y, dir.x) + glm::radians(-90.0f);
+        }
+    }
+
+    obj.model = glm::translate(obj.model, obj.position);
+    obj.model = glm::scale(obj.model, glm::vec3(obj.scale.x, obj.scale.y, obj.scale.z));
+
+    if (obj.rotation.x != 0 || obj.rotation.y != 0 || obj.rotation.z != 0){
+        obj.model = glm::rotate(obj.model, angle, glm::vec3(obj.rotation.x, obj.rotation.y, obj.rotation.z));
+    }
+}
+
+int selectObjectLod(const Object& obj, int current) {
+    // Raio da esfera envolvente na tela pela distância até a câmera (não pela profundidade:
+    // girar a câmera no lugar não troca o nível)
+    static const float pixelsPerUnit = HEIGHT / (2.0f * tan(glm::radians(FIELD_OF_VIEW) / 2.0f));
+    glm::vec3 center = glm::vec3(obj.model * glm::vec4(obj.sphereCenter, 1.0f));
+    float maxScale = std::max(std::abs(obj.scale.x), std::max(std::abs(obj.scale.y), std::abs(obj.scale.z)));
+    float radius = obj.sphereRadius * maxScale;
+    float distance = glm::length(center - cameraPos);
+    float projectedRadius = distance > radius ? radius / distance * pixelsPerUnit : (float)HEIGHT;
+    return selectMeshLod(obj.lodError, obj.lodCount, current, projectedRadius, lodErrorPixels, lodHysteresis);
+}
+
+void bindObjectTexture(const PhongUniforms& uniforms, const Object& obj) {
+    stateCache.set(uniforms.textureArray, obj.textureArray);
+    stateCache.set(uniforms.textureLayer, (float)obj.textureLayer);
+    if (obj.textureArray < 0 && stateCache.bindTexture(GL_TEXTURE0, GL_TEXTURE_2D, obj.texID)) {
+        drawStats.recordTextureBind();
+    }
+}
+
+void drawObjectRanges(const PhongUniforms& uniforms, const Object& obj, int lod, GLsizei instances) {
+    // Chamada de desenho - drawcall
+    // Poligono Preenchido - GL_TRIANGLES
+    // As faixas do nível vêm ordenadas por material, então cada material é ativado uma
+    // única vez; com instances > 0 cada faixa é um desenho instanciado
+    GLsizei indexSize = (obj.indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+    int currentMaterial = -2;
+    for (const DrawRange& range : obj.drawRanges) {
+        if (range.lod != lod) {
+            continue;
+        }
+        if (range.material != currentMaterial) {
+            static const Material defaultMaterial;
+            const Material& material = range.material >= 0 ? obj.materials[range.material] : defaultMaterial;
+            stateCache.set(uniforms.ka, glm::value_ptr(material.ka));
+            stateCache.set(uniforms.kd, glm::value_ptr(material.kd));
+            stateCache.set(uniforms.ks, glm::value_ptr(material.ks));
+            currentMaterial = range.material;
+        }
+
+        // A faixa é conferida contra o buffer; só a parte que existe é desenhada
+        GLsizei count = drawStats.recordDraw(obj.meshStats, range.first, range.count, instances);
+        if (count == 0)
+            continue;
+        // No geometryPool a malha começa em firstIndex e os seus índices em baseVertex
+        GLvoid* offset = (GLvoid*)(((size_t)obj.firstIndex + range.first) * indexSize);
+        if (instances > 0 && obj.nIndices > 0)
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, count, obj.indexType, offset, instances, obj.baseVertex);
+        else if (instances > 0)
+            glDrawArraysInstanced(GL_TRIANGLES, range.first, count, instances);
+        else if (obj.nIndices > 0)
+            glDrawElementsBaseVertex(GL_TRIANGLES, count, obj.indexType, offset, obj.baseVertex);
+        else
+            glDrawArrays(GL_TRIANGLES, range.first, count);
+    }
+}
+
+void requireTextureMips() {
+    // Diâmetro projetado da esfera envolvente de cada objeto (usa a matriz de modelo e o
+    // recorte do último frame desenhado); objetos fora do tronco não pedem nada
+    float pixelsPerUnit = HEIGHT / (2.0f * tan(glm::radians(FIELD_OF_VIEW) / 2.0f));
+    glm::vec3 front = glm::normalize(cameraFront);
+    for (size_t i = 0; i < objects.size(); i++) {
+        const Object& obj = objects[i];
+        if (obj.textureStream < 0 || (i < objectVisible.size() && !objectVisible[i])) {
+            continue;
+        }
+        glm::vec3 center = glm::vec3(obj.model * glm::vec4(0.5f * (obj.boundsMin + obj.boundsMax), 1.0f));
+        float maxScale = std::max(std::abs(obj.scale.x), std::max(std::abs(obj.scale.y), std::abs(obj.scale.z)));
+        float radius = 0.5f * glm::length(obj.boundsMax - obj.boundsMin) * maxScale;
+        float depth = glm::dot(center - cameraPos, front);
+        if (depth + radius <= 0.1f) {
+            continue;
+        }
+        float projectedPixels = depth > radius ? 2.0f * radius / depth * pixelsPerUnit : (float)HEIGHT;
+        textureStreamer.require(obj.textureStream, projectedPixels);
     }
 }
 
@@ -395,6 +1302,71 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
     cameraFront = glm::normalize(front);
 }
 
+void mouse_button_callback(GLFWwindow* window, int button, int action, int /*mods*/) {
+    // Com o cursor habilitado (tecla H), o clique seleciona o objeto sob o cursor
+    if (!cursorEnabled || button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) {
+        return;
+    }
+
+    double xpos, ypos;
+    int windowWidth, windowHeight;
+    glfwGetCursorPos(window, &xpos, &ypos);
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    if (windowWidth <= 0 || windowHeight <= 0) {
+        return;
+    }
+
+    int picked = pickObject(2.0f * (float)xpos / windowWidth - 1.0f, 1.0f - 2.0f * (float)ypos / windowHeight);
+    if (picked >= 0) {
+        selectedObjectIndex = picked;
+        cout << "Objeto " << picked << " selecionado" << endl;
+    }
+}
+
+int pickObject(float ndcX, float ndcY) {
+    // Raio da câmera pelo ponto da tela: o ponto desprojetado nos planos perto e longe
+    glm::mat4 toWorld = glm::inverse(frameUniforms.values().viewProjection);
+    glm::vec4 nearPoint = toWorld * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = toWorld * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 end = glm::vec3(farPoint) / farPoint.w;
+    float length = glm::length(end - origin);
+    glm::vec3 direction = (end - origin) / length;
+
+    // Teste fino na caixa do modelo, com o raio levado às coordenadas do modelo (a matriz é
+    // afim: a distância ao longo do raio continua a mesma do mundo)
+    auto hitsModelBox = [&](int index, float& distance) {
+        const Object& obj = objects[index];
+        glm::mat4 toModel = glm::inverse(obj.model);
+        glm::vec3 modelOrigin = glm::vec3(toModel * glm::vec4(origin, 1.0f));
+        glm::vec3 modelDirection = glm::vec3(toModel * glm::vec4(direction, 0.0f));
+        float hit = intersectRay({ obj.boundsMin, obj.boundsMax }, modelOrigin, 1.0f / modelDirection, length);
+        if (hit < 0.0f) {
+            return false;
+        }
+        distance = hit;
+        return true;
+    };
+
+    if (useBVH) {
+        return objectBVH.raycast(origin, direction, length, hitsModelBox).object;
+    }
+
+    // Sem a BVH, todos os objetos
+    int closestObject = -1;
+    float closest = length;
+    glm::vec3 inverseDirection = 1.0f / direction;
+    for (int i = 0; i < (int)objects.size(); i++) {
+        const Object& obj = objects[i];
+        float distance = intersectRay(Aabb::transformed(obj.model, obj.boundsMin, obj.boundsMax), origin, inverseDirection, closest);
+        if (distance >= 0.0f && hitsModelBox(i, distance) && distance <= closest) {
+            closest = distance;
+            closestObject = i;
+        }
+    }
+    return closestObject;
+}
+
 
 void loadSceneConfig(string filePATH){
     std::ifstream inputFile(filePATH);
@@ -407,13 +1379,200 @@ void loadSceneConfig(string filePATH){
 	nlohmann::json jsonSceneConfig;
     inputFile >> jsonSceneConfig;
 
+    // Cache de malhas processadas (padrão: ligado)
+    useMeshCache = jsonSceneConfig.value("meshCache", true);
+
+    // Otimização das malhas: "none", "vertexCache" ou "overdraw" (cada objeto pode sobrescrever)
+    meshOptimization = meshOptimizationFromString(jsonSceneConfig.value("meshOptimization", "vertexCache"));
+
+    // Níveis de detalhe por malha, contando a completa (padrão: 4; 1 desliga; cada objeto pode
+    // sobrescrever), erro máximo na tela em pixels (padrão: 1) e margem para trocar por um
+    // nível mais simples (padrão: 0.25)
+    lodLevels = std::min(std::max(jsonSceneConfig.value("lodLevels", MAX_MESH_LODS), 1), MAX_MESH_LODS);
+    lodErrorPixels = jsonSceneConfig.value("lodErrorPixels", 1.0f);
+    lodHysteresis = jsonSceneConfig.value("lodHysteresis", 0.25f);
+
+    // Texturas comprimidas (KTX2 gerado com --bake-textures) no lugar das imagens, quando atualizadas
+    textureCache.setUseCompressed(jsonSceneConfig.value("compressedTextures", true));
+
+    // Mipmaps das imagens não comprimidas: "box" ou "kaiser" (gerados na CPU e guardados
+    // no arquivo .mips) ou "gpu" (glGenerateMipmap)
+    std::string mipmapFilter = jsonSceneConfig.value("mipmapFilter", "box");
+    textureCache.setCpuMipmaps(mipmapFilter != "gpu", mipFilterFromString(mipmapFilter));
+
+    // Lado máximo das imagens (padrão: 0, sem limite); as maiores são reduzidas na carga
+    maxTextureSize = jsonSceneConfig.value("maxTextureSize", 0);
+
+    // Texturas carregadas em segundo plano (padrão: ligado) e bytes enviados por frame
+    streamTextures = jsonSceneConfig.value("textureStreaming", true);
+    textureUploadBudget = jsonSceneConfig.value("textureUploadBudgetKB", 4096) * size_t(1024);
+
+    // Texturas carregadas em segundo plano começam só com os níveis pequenos; os maiores
+    // chegam conforme o tamanho na tela, até o orçamento de memória de vídeo (padrão: ligado, 64 MB)
+    streamMips = jsonSceneConfig.value("mipStreaming", true);
+    textureMemoryBudget = jsonSceneConfig.value("textureMemoryBudgetMB", 64) * size_t(1024 * 1024);
+    textureStreamer.setMipStreaming(streamMips, textureMemoryBudget);
+
+    // Arrays de textura (padrão: desligado; as texturas deixam de ser carregadas em segundo
+    // plano) e lado máximo das imagens nos arrays (0: tamanho original)
+    useTextureArrays = jsonSceneConfig.value("textureArrays", false);
+    textureArrays.setMaxSize(jsonSceneConfig.value("textureArrayMaxSize", 0));
+
+    // Desenho instanciado dos objetos com a mesma malha, materiais e textura (padrão: ligado)
+    useInstancing = jsonSceneConfig.value("instancing", true);
+    instanceGroupsDirty = true;
+
+    // Malhas no pool de geometria e a cena em envios indiretos (padrão: ambos ligados; o
+    // desenho indireto tem precedência sobre o instanciado e precisa do pool e do
+    // glMultiDrawElementsIndirect)
+    useGeometryPool = jsonSceneConfig.value("geometryPool", true);
+    useMultiDrawIndirect = useGeometryPool && hasMultiDrawIndirect() && jsonSceneConfig.value("multiDrawIndirect", true);
+
+    // Recorte pelo tronco de visão (padrão: ligado), hierárquico pela BVH (padrão: ligado)
+    useFrustumCulling = jsonSceneConfig.value("frustumCulling", true);
+    useBVH = jsonSceneConfig.value("bvh", true);
+
+    // Ordem dos desenhos por objeto pela chave da fila (padrão: ligado; desligado, a ordem do JSON)
+    sortDraws = jsonSceneConfig.value("sortDraws", true);
+
     // Carregar objetos
+    // Leitura e parsing do .obj, decodificação da textura e leitura do .mtl rodam nas
+    // threads de trabalho; a criação dos buffers e texturas fica nesta thread, que tem
+    // o contexto OpenGL. Os objetos são enviados (e adicionados) na ordem do JSON.
+    // Cada imagem, malha e .mtl é lida uma única vez, mesmo que vários objetos a usem;
+    // os objetos com a mesma malha compartilham os buffers na GPU.
+    // Com "textureStreaming" as texturas não seguram a carga: ficam com o textureStreamer
     if (jsonSceneConfig.contains("objects")) {
+        struct PendingTexture
+        {
+            std::string file;
+            SamplerSettings sampler;
+            DecodedImage image;
+            CompressedImage compressed; //KTX2 ao lado da imagem, se estiver atualizado
+            MipChain mips; //cadeia de mipmaps gerada na CPU (ou lida do .mips)
+            bool found = false;
+            std::shared_future<void> task;
+        };
+
+        struct PendingMesh
+        {
+            std::string file;
+            PreparedMesh mesh;
+            bool loaded = false;
+            int object = -1; //índice em objects do objeto que enviou os buffers
+            std::shared_future<void> task;
+        };
+
+        struct PendingMaterials
+        {
+            std::string file;
+            std::vector<Material> materials;
+            bool loaded = false;
+            std::shared_future<void> task;
+        };
+
+        struct PendingObject
+        {
+            Object obj;
+            std::string objFile, mtlFile, textureFile;
+            std::shared_ptr<PendingMesh> mesh;
+            std::shared_ptr<PendingMaterials> materials;
+            std::shared_ptr<PendingTexture> texture;
+            SamplerSettings sampler;
+            bool streamed = false; //textura pedida ao textureStreamer
+            bool copy = false; //gerado por "copies" (sem mensagens próprias na carga)
+        };
+        std::unordered_map<std::string, std::shared_ptr<PendingTexture>> pendingTextures;
+        std::unordered_map<std::string, std::shared_ptr<PendingMesh>> pendingMeshes;
+        std::unordered_map<std::string, std::shared_ptr<PendingMaterials>> pendingMaterials;
+
+        ThreadPool& pool = defaultThreadPool();
+        std::cout << "Carregando objetos com " << pool.size() + 1 << " threads" << std::endl;
+
+        std::vector<std::unique_ptr<PendingObject>> pendingObjects;
         for (const auto& objData : jsonSceneConfig["objects"]) {
-            std::string objFile = objData["objFile"];
+            pendingObjects.push_back(std::make_unique<PendingObject>());
+            PendingObject* pending = pendingObjects.back().get();
+
+            pending->objFile = objData["objFile"];
+            pending->mtlFile = objData["mtlFile"];
+
+            // Parâmetros de amostragem opcionais: "textureWrap" e "textureFilter"
+            SamplerSettings sampler;
+            sampler.wrapS = sampler.wrapT = textureWrapFromString(objData.value("textureWrap", "repeat"));
+            applyTextureFilter(objData.value("textureFilter", "linear"), sampler);
+            sampler.maxSize = objData.value("maxTextureSize", maxTextureSize);
             std::string textureFile = objData["textureFile"];
-            std::string mtlFile = objData["mtlFile"];
-            
+            pending->textureFile = textureFile;
+            pending->sampler = sampler;
+            pending->streamed = streamTextures && !useTextureArrays && !textureCache.contains(textureFile, sampler);
+            if (!pending->streamed) {
+                std::string textureKey = TextureCache::key(textureFile, sampler);
+                std::shared_ptr<PendingTexture>& texture = pendingTextures[textureKey];
+                if (!texture) {
+                    texture = std::make_shared<PendingTexture>();
+                    texture->file = textureFile;
+                    texture->sampler = sampler;
+                    PendingTexture* decoding = texture.get();
+                    // O textureCache só é consultado aqui, na thread principal: ela insere no
+                    // cache enquanto as decodificações seguintes ainda rodam
+                    bool cached = textureCache.contains(textureFile, sampler);
+                    bool useCompressed = textureCache.usesCompressed();
+                    bool useCpuMipmaps = useTextureArrays || (textureCache.usesCpuMipmaps() && sampler.mipmaps);
+                    MipFilter filter = textureCache.mipFilter();
+                    texture->task = pool.submit([decoding, cached, useCompressed, useCpuMipmaps, filter] {
+                        decoding->found = std::filesystem::exists(decoding->file);
+                        if (decoding->found && !cached) {
+                            int maxSize = decoding->sampler.maxSize;
+                            bool compressed = useCompressed && loadCompressedTexture(decoding->file, decoding->compressed);
+                            if (compressed) {
+                                limitCompressedSize(decoding->compressed, maxSize);
+                            }
+                            // Os arrays são montados a partir da cadeia de mipmaps da CPU
+                            bool cpuMipmaps = !compressed && useCpuMipmaps &&
+                                prepareMipChain(decoding->file, filter, decoding->mips, maxSize);
+                            if (!compressed && !cpuMipmaps && decodeImage(decoding->file, decoding->image)) {
+                                limitImageSize(decoding->image, maxSize);
+                            }
+                        }
+                    }).share();
+                }
+                pending->texture = texture;
+            }
+
+            OBJLoadOptions options;
+            options.indexed = objData.value("indexed", true);
+            VertexFormat format = vertexFormatFromString(objData.value("vertexFormat", "packed"));
+            MeshOptimization optimization = objData.contains("meshOptimization") ?
+                meshOptimizationFromString(objData["meshOptimization"]) : meshOptimization;
+            // Malhas sem índices não têm níveis de detalhe (o prepareMesh usa um só): a mesma
+            // chave para qualquer "lodLevels", senão dois pedidos iguais gravariam o mesmo cache
+            int levels = options.indexed ? std::min(std::max(objData.value("lodLevels", lodLevels), 1), MAX_MESH_LODS) : 1;
+
+            std::string meshKey = pending->objFile + "|" + std::to_string(options.indexed) + "|" +
+                std::to_string(format) + "|" + std::to_string(optimization) + "|" + std::to_string(levels);
+            std::shared_ptr<PendingMesh>& mesh = pendingMeshes[meshKey];
+            if (!mesh) {
+                mesh = std::make_shared<PendingMesh>();
+                mesh->file = pending->objFile;
+                PendingMesh* loading = mesh.get();
+                mesh->task = pool.submit([loading, options, optimization, format, levels] {
+                    loading->loaded = prepareMesh(loading->file, options, optimization, format, levels, useMeshCache, loading->mesh);
+                }).share();
+            }
+            pending->mesh = mesh;
+
+            std::shared_ptr<PendingMaterials>& materials = pendingMaterials[pending->mtlFile];
+            if (!materials) {
+                materials = std::make_shared<PendingMaterials>();
+                materials->file = pending->mtlFile;
+                PendingMaterials* loading = materials.get();
+                materials->task = pool.submit([loading] {
+                    loading->loaded = std::filesystem::exists(loading->file) && loadMTL(loading->file, loading->materials);
+                }).share();
+            }
+            pending->materials = materials;
+
             glm::vec3 position = glm::vec3(
                 objData["position"][0],
                 objData["position"][1],
@@ -432,9 +1591,8 @@ void loadSceneConfig(string filePATH){
                 objData["rotation"][2]
             );
 
-            // Criar objeto e configurar propriedades
-			Object obj;
-			obj.VAO = loadSimpleOBJ(objFile, obj.nVertices);
+            // Configurar propriedades do objeto (o .mtl preenche só os materiais)
+			Object& obj = pending->obj;
 			obj.model = glm::mat4(1); //matriz identidade 
 			obj.position = position;
 			obj.scale = scale;
@@ -459,24 +1617,133 @@ void loadSceneConfig(string filePATH){
 				obj.curveAngle = atan2(dir.y, dir.x) + glm::radians(-90.0f);
             }
 
+            // Cópias em grade: "copies": [nx, ny, nz], a cada "copySpacing": [dx, dy, dz] a partir
+            // da posição do objeto; todas compartilham malha, materiais e textura com ele
+            if (objData.contains("copies")) {
+                glm::ivec3 copies = glm::ivec3(objData["copies"][0], objData["copies"][1], objData["copies"][2]);
+                glm::vec3 spacing = glm::vec3(1.0f);
+                if (objData.contains("copySpacing")) {
+                    spacing = glm::vec3(objData["copySpacing"][0], objData["copySpacing"][1], objData["copySpacing"][2]);
+                }
+                PendingObject original = *pending;
+                for (int z = 0; z < copies.z; z++) {
+                    for (int y = 0; y < copies.y; y++) {
+                        for (int x = 0; x < copies.x; x++) {
+                            if (x == 0 && y == 0 && z == 0) {
+                                continue;
+                            }
+                            pendingObjects.push_back(std::make_unique<PendingObject>(original));
+                            pendingObjects.back()->obj.position += spacing * glm::vec3(x, y, z);
+                            pendingObjects.back()->copy = true;
+                        }
+                    }
+                }
+                std::cout << pending->objFile << ": " << std::max(1, copies.x * copies.y * copies.z) << " copia(s) na cena" << std::endl;
+            }
+        }
+
+        // Os pedidos ao textureStreamer entram na fila depois das malhas, para a carga
+        // da cena não esperar pelas decodificações
+        for (auto& pending : pendingObjects) {
+            if (pending->streamed && std::filesystem::exists(pending->textureFile)) {
+                pending->obj.textureRequest = textureStreamer.request(pending->textureFile, pending->sampler, textureCache);
+                pending->obj.textureStream = pending->obj.textureRequest;
+                pending->obj.texID = textureStreamer.placeholder();
+            }
+        }
+
+        // Envio para a GPU na ordem do JSON, à medida que cada objeto fica pronto.
+        // Com arrays de textura as imagens são só reunidas aqui e enviadas no fim, por grupo
+        size_t firstObject = objects.size();
+        size_t sharedMeshes = 0;
+        std::vector<int> arrayEntries;
+        for (auto& pending : pendingObjects) {
+            pending->mesh->task.get();
+            if (pending->texture) {
+                pending->texture->task.get();
+            }
+            pending->materials->task.get();
+
+            // As cópias só são anunciadas pelo objeto original
+            bool verbose = !pending->copy;
+            Object& obj = pending->obj;
+            PendingMesh& mesh = *pending->mesh;
+            if (mesh.object >= 0) {
+                // Malha já enviada por outro objeto: os buffers são compartilhados
+                shareMesh(objects[mesh.object], obj);
+                sharedMeshes++;
+            } else if (mesh.loaded) {
+                uploadMesh(pending->objFile, mesh.mesh, obj);
+                mesh.object = (int)objects.size();
+            } else if (verbose) {
+                cout << "Erro ao tentar ler o arquivo " << pending->objFile << endl;
+            }
 
-			if (std::filesystem::exists(textureFile)) {
-                int texWidth, texHeight;
-                obj.texID = loadTexture(textureFile, texWidth, texHeight);
-                std::cout << "Textura carregada para " << objFile << ": " << textureFile << std::endl;
+            int arrayEntry = -1;
+			if (obj.textureRequest >= 0) {
+                if (verbose) {
+                    std::cout << "Textura pedida para " << pending->objFile << ": " << pending->textureFile << " (em segundo plano)" << std::endl;
+                }
+            } else if (useTextureArrays && pending->texture && pending->texture->found) {
+                // Só a primeira referência à imagem leva os dados; as outras contam referências
+                PendingTexture& texture = *pending->texture;
+                arrayEntry = texture.compressed.levels.empty() ?
+                    textureArrays.add(texture.file, texture.sampler, texture.mips) :
+                    textureArrays.add(texture.file, texture.sampler, texture.compressed);
+                obj.texID = 0;
+                if (verbose) {
+                    std::cout << "Textura carregada para " << pending->objFile << ": " << texture.file << " (array)" << std::endl;
+                }
+            } else if (pending->texture && pending->texture->found) {
+                PendingTexture& texture = *pending->texture;
+                // A primeira aquisição envia a imagem; as seguintes reaproveitam a textura
+                if (!texture.compressed.levels.empty()) {
+                    obj.texID = textureCache.acquire(texture.file, texture.sampler, texture.compressed);
+                } else if (!texture.mips.levels.empty()) {
+                    obj.texID = textureCache.acquire(texture.file, texture.sampler, texture.mips);
+                } else {
+                    obj.texID = textureCache.acquire(texture.file, texture.sampler, texture.image);
+                }
+                if (verbose) {
+                    std::cout << "Textura carregada para " << pending->objFile << ": " << texture.file << std::endl;
+                }
             } else {
-                std::cerr << "Textura não encontrada para " << objFile << std::endl;
+                if (verbose) {
+                    std::cerr << "Textura não encontrada para " << pending->objFile << std::endl;
+                }
                 obj.texID = 0; // Identificador inválido para textura
             }
 
-            if (std::filesystem::exists(mtlFile)) {
-				loadMTL(mtlFile, obj);
-            } else {
-                std::cerr << "Arquivo MTL não encontrado para " << objFile << std::endl;
+            obj.materials = pending->materials->materials;
+            if (verbose && pending->materials->loaded) {
+                cout << "Arquivo .mtl lido" << endl;
+            } else if (verbose) {
+                std::cerr << "Arquivo MTL não encontrado para " << pending->objFile << std::endl;
             }
+            bindMaterials(obj);
 			
             // Adiciona o objeto ao vetor
             objects.push_back(obj);
+            arrayEntries.push_back(arrayEntry);
+        }
+
+        if (useTextureArrays) {
+            textureArrays.build(MAX_TEXTURE_ARRAYS, textureCache);
+            for (size_t i = 0; i < arrayEntries.size(); i++) {
+                if (arrayEntries[i] < 0) {
+                    continue;
+                }
+                Object& obj = objects[firstObject + i];
+                const TextureArrays::Placement& placement = textureArrays.placement(arrayEntries[i]);
+                obj.textureArray = placement.array;
+                obj.textureLayer = placement.layer;
+                obj.texID = placement.texture;
+            }
+            textureArrays.report(std::cout);
+        }
+
+        if (sharedMeshes > 0) {
+            std::cout << sharedMeshes << " objeto(s) reaproveitam a malha de outro objeto" << std::endl;
         }
     }
 
@@ -516,6 +1783,12 @@ void loadSceneConfig(string filePATH){
         );
     }
 
+    size_t geometryBytes = 0;
+    for (const Object& obj : objects) {
+        geometryBytes += obj.geometryBytes;
+    }
+    std::cout << "Geometria da cena na GPU: " << geometryBytes / 1024 << " KB (VBO + EBO)" << std::endl;
+    textureCache.report(std::cout);
     std::cout << "Cena carregada com sucesso a partir de " << filePATH << std::endl;
 }
 
@@ -524,7 +1797,7 @@ void loadObjectsFromFolder(string objFolderPath, string textureFolderPath, strin
         if (entry.path().extension() == ".obj") {
             // Cria um novo objeto para cada arquivo .obj
             Object obj;
-            obj.VAO = loadSimpleOBJ(entry.path().string(), obj.nVertices);
+            loadSimpleOBJ(entry.path().string(), obj);
 			obj.model = glm::mat4(1); //matriz identidade 
 			//obj.scale = 1.0f; // Escala inicial do objeto para exibir
 
@@ -552,8 +1825,7 @@ void loadObjectsFromFolder(string objFolderPath, string textureFolderPath, strin
             }
 
 			if (std::filesystem::exists(texturePath)) {
-                int texWidth, texHeight;
-                obj.texID = loadTexture(texturePath, texWidth, texHeight);
+                obj.texID = loadTexture(texturePath);
                 std::cout << "Textura carregada para " << entry.path().filename() << ": " << texturePath << std::endl;
             } else {
                 std::cerr << "Textura não encontrada para " << entry.path().filename() << std::endl;
@@ -563,11 +1835,12 @@ void loadObjectsFromFolder(string objFolderPath, string textureFolderPath, strin
 			// Busca o arquivo mtl correspondente
             std::string mtlPath = mtlFolderPath + "/" + baseName + ".mtl";
 
-            if (std::filesystem::exists(mtlPath)) {
-				loadMTL(mtlPath, obj);
+            if (std::filesystem::exists(mtlPath) && loadMTL(mtlPath, obj.materials)) {
+				cout << "Arquivo .mtl lido" << endl;
             } else {
                 std::cerr << "Arquivo MTL não encontrado para " << entry.path().filename() << std::endl;
             }
+            bindMaterials(obj);
 			
             // Adiciona o objeto ao vetor
             objects.push_back(obj);
@@ -576,207 +1849,188 @@ void loadObjectsFromFolder(string objFolderPath, string textureFolderPath, strin
 	std::cout << "Total de objetos carregados: " << objects.size() << std::endl;
 }
 
-int loadSimpleOBJ(string filePath, int &nVertices)
+bool loadSimpleOBJ(string filePath, Object &obj, bool indexed, VertexFormat format)
 {
-	vector <glm::vec3> vertices;
-	vector <glm::vec2> texCoords;
-	vector <glm::vec3> normals;
-	vector <GLfloat> vBuffer;
-
-	glm::vec3 color = glm::vec3(1.0, 0.0, 0.0);
+	OBJLoadOptions options;
+	options.indexed = indexed;
 
-	ifstream arqEntrada;
-
-	arqEntrada.open(filePath.c_str());
-	if (arqEntrada.is_open())
+	PreparedMesh prepared;
+	if (!prepareMesh(filePath, options, meshOptimization, format, lodLevels, useMeshCache, prepared))
 	{
-		//Fazer o parsing
-		string line;
-		while (!arqEntrada.eof())
-		{
-			getline(arqEntrada,line);
-			istringstream ssline(line);
-			string word;
-			ssline >> word;
-			if (word == "v")
-			{
-				glm::vec3 vertice;
-				ssline >> vertice.x >> vertice.y >> vertice.z;
-				//cout << vertice.x << " " << vertice.y << " " << vertice.z << endl;
-				vertices.push_back(vertice);
-
-			}
-			if (word == "vt")
-			{
-				glm::vec2 vt;
-				ssline >> vt.s >> vt.t;
-				//cout << vertice.x << " " << vertice.y << " " << vertice.z << endl;
-				texCoords.push_back(vt);
+		cout << "Erro ao tentar ler o arquivo " << filePath << endl;
+		obj.VAO = 0;
+		obj.nVertices = 0;
+		obj.nIndices = 0;
+		return false;
+	}
 
-			}
-			if (word == "vn")
-			{
-				glm::vec3 normal;
-				ssline >> normal.x >> normal.y >> normal.z;
-				//cout << vertice.x << " " << vertice.y << " " << vertice.z << endl;
-				normals.push_back(normal);
+	uploadMesh(filePath, prepared, obj);
+	return true;
+}
 
-			}
-			else if (word == "f")
-			{
-				while (ssline >> word) 
-				{
-					int vi, ti, ni;
-					istringstream ss(word);
-    				std::string index;
-
-    				// Pega o índice do vértice
-    				std::getline(ss, index, '/');
-    				vi = std::stoi(index) - 1;  // Ajusta para índice 0
-
-    				// Pega o índice da coordenada de textura
-    				std::getline(ss, index, '/');
-    				ti = std::stoi(index) - 1;
-
-    				// Pega o índice da normal
-    				std::getline(ss, index);
-    				ni = std::stoi(index) - 1;
-
-					//Recuperando os vértices do indice lido
-					vBuffer.push_back(vertices[vi].x);
-					vBuffer.push_back(vertices[vi].y);
-					vBuffer.push_back(vertices[vi].z);
-					
-					//Atributo cor
-					vBuffer.push_back(color.r);
-					vBuffer.push_back(color.g);
-					vBuffer.push_back(color.b);
-
-					//Atributo coordenada de textura
-					vBuffer.push_back(texCoords[ti].s);
-					vBuffer.push_back(texCoords[ti].t);
-
-					//Atributo vetor normal
-					vBuffer.push_back(normals[ni].x);
-					vBuffer.push_back(normals[ni].y);
-					vBuffer.push_back(normals[ni].z);
-					
-        			
-        			// Exibindo os índices para verificação
-       				// std::cout << "v: " << vi << ", vt: " << ti << ", vn: " << ni << std::endl;
-    			}
-				
-			}
-		}
+void uploadMesh(const string& filePath, const PreparedMesh& prepared, Object &obj)
+{
+	double startTime = glfwGetTime();
 
-		arqEntrada.close();
+	if (prepared.cacheSaveFailed)
+	{
+		cout << "Nao foi possivel gravar o cache de " << filePath << endl;
+	}
 
+	const MeshLayout& layout = prepared.layout;
+	obj.nVertices = layout.vertexCount;
+	obj.nIndices = layout.indexCount;
+	obj.indexType = layout.indexType;
+	obj.firstIndex = 0;
+	obj.baseVertex = 0;
+	if (useGeometryPool)
+	{
+		// Subalocada em um bloco compartilhado: o VAO e os buffers são do geometryPool
+		GeometryPool::Allocation allocation = geometryPool.add(layout, prepared.vertexData, prepared.vertexBytes, prepared.indexData, prepared.indexBytes);
+		obj.VAO = allocation.vao;
+		obj.VBO = 0;
+		obj.EBO = 0;
+		obj.nIndices = allocation.indexCount;
+		obj.indexType = GL_UNSIGNED_INT;
+		obj.firstIndex = allocation.firstIndex;
+		obj.baseVertex = allocation.baseVertex;
+		obj.sharedMesh = true;
+	}
+	else
+	{
 		cout << "Gerando o buffer de geometria..." << endl;
 		GLuint VBO, VAO;
 
-	//Geração do identificador do VBO
-	glGenBuffers(1, &VBO);
-
-	//Faz a conexão (vincula) do buffer como um buffer de array
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		//Geração do identificador do VBO
+		glGenBuffers(1, &VBO);
 
-	//Envia os dados do array de floats para o buffer da OpenGl
-	glBufferData(GL_ARRAY_BUFFER, vBuffer.size() * sizeof(GLfloat), vBuffer.data(), GL_STATIC_DRAW);
+		//Faz a conexão (vincula) do buffer como um buffer de array
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
-	//Geração do identificador do VAO (Vertex Array Object)
-	glGenVertexArrays(1, &VAO);
-
-	// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
-	// e os ponteiros para os atributos 
-	glBindVertexArray(VAO);
-	
-	//Para cada atributo do vertice, criamos um "AttribPointer" (ponteiro para o atributo), indicando: 
-	// Localização no shader * (a localização dos atributos devem ser correspondentes no layout especificado no vertex shader)
-	// Numero de valores que o atributo tem (por ex, 3 coordenadas xyz) 
-	// Tipo do dado
-	// Se está normalizado (entre zero e um)
-	// Tamanho em bytes 
-	// Deslocamento a partir do byte zero 
-	
-	//Atributo posição (x, y, z)
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
+		//Envia os dados do array de vértices para o buffer da OpenGl
+		glBufferData(GL_ARRAY_BUFFER, prepared.vertexBytes, prepared.vertexData, GL_STATIC_DRAW);
 
-	//Atributo cor (r, g, b)
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(3*sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
+		//Geração do identificador do VAO (Vertex Array Object)
+		glGenVertexArrays(1, &VAO);
 
-	//Atributo coordenada de textura - s, t
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(6*sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
+		// Vincula (bind) o VAO primeiro, e em seguida  conecta e seta o(s) buffer(s) de vértices
+		// e os ponteiros para os atributos (localizações conforme o layout do phong.vs)
+		glBindVertexArray(VAO);
+		setupVertexAttributes(prepared.layout);
 
-	//Atributo vetor normal - x, y, z
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (GLvoid*)(8*sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-
-	// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice 
-	// atualmente vinculado - para que depois possamos desvincular com segurança
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+		obj.EBO = 0;
+		if (prepared.indexBytes > 0)
+		{
+			// O buffer de índices fica registrado no VAO (não desvincular antes do VAO!)
+			glGenBuffers(1, &obj.EBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, obj.EBO);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, prepared.indexBytes, prepared.indexData, GL_STATIC_DRAW);
+		}
 
-	// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
-	glBindVertexArray(0);
+		// Observe que isso é permitido, a chamada para glVertexAttribPointer registrou o VBO como o objeto de buffer de vértice 
+		// atualmente vinculado - para que depois possamos desvincular com segurança
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	nVertices = vBuffer.size() / 2;
-	return VAO;
+		// Desvincula o VAO (é uma boa prática desvincular qualquer buffer ou array para evitar bugs medonhos)
+		glBindVertexArray(0);
 
+		obj.VAO = VAO;
+		obj.VBO = VBO;
 	}
-	else
+	obj.posScale = layout.posScale;
+	obj.posOffset = layout.posOffset;
+	obj.boundsMin = layout.boundsMin;
+	obj.boundsMax = layout.boundsMax;
+	obj.sphereCenter = layout.sphereCenter;
+	obj.sphereRadius = layout.sphereRadius;
+	obj.geometryBytes = prepared.vertexBytes + prepared.indexBytes;
+	obj.meshStats = drawStats.registerMesh(filePath, layout, prepared.vertexBytes, prepared.indexData, prepared.indexBytes);
+
+	// Faixas de desenho de cada nível de detalhe; os materiais são associados por nome em bindMaterials
+	obj.drawRanges.clear();
+	obj.lodCount = 1 + (int)layout.lods.size();
+	for (int lod = 0; lod < obj.lodCount; lod++)
 	{
-		cout << "Erro ao tentar ler o arquivo " << filePath << endl;
-		return -1;
+		obj.lodError[lod] = lod == 0 ? 0.0f : layout.lods[lod - 1].error;
+		for (const SubMesh& submesh : lod == 0 ? layout.submeshes : layout.lods[lod - 1].submeshes)
+		{
+			DrawRange range;
+			range.materialName = submesh.material;
+			range.lod = lod;
+			range.first = (GLint)submesh.first;
+			range.count = (GLsizei)submesh.count;
+			obj.drawRanges.push_back(range);
+		}
 	}
-}
-
-GLuint loadTexture(string filePath, int &width, int &height)
-{
-	GLuint texID; // id da textura a ser carregada
-
-	// Gera o identificador da textura na memória
-	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
 
-	// Ajuste dos parâmetros de wrapping e filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Carregamento da imagem usando a função stbi_load da biblioteca stb_image
-	int nrChannels;
-
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-	if (data)
+	size_t floatBytes = (size_t)(layout.indexCount > 0 ? layout.indexCount : obj.nVertices) * OBJ_FLOATS_PER_VERTEX * sizeof(GLfloat);
+	cout << filePath << ": " << obj.nVertices << " vertices, " << layout.indexCount << " indices, "
+		<< drawStats.mesh(obj.meshStats).triangleCount << " triangulos, "
+		<< prepared.vertexBytes / 1024 << " KB VBO + " << prepared.indexBytes / 1024 << " KB EBO"
+		<< " (buffer original de floats: " << floatBytes / 1024 << " KB), "
+		<< (prepared.fromCache ? "cache" : "parsing") << " em " << 1000.0 * prepared.seconds << " ms"
+		<< ", envio em " << 1000.0 * (glfwGetTime() - startTime) << " ms, "
+		<< layout.submeshes.size() << " material(is), pico RSS do processo "
+		<< prepared.peakRSS / (1024 * 1024) << " MB" << endl;
+
+	if (layout.indexCount > 0)
 	{
-		if (nrChannels == 3) // jpg, bmp
+		cout << "    cache de vertices: ";
+		if (prepared.hasOriginalStats)
 		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+			cout << "ACMR " << prepared.originalStats.acmr << " -> " << prepared.stats.acmr
+				<< ", ATVR " << prepared.originalStats.atvr << " -> " << prepared.stats.atvr << endl;
 		}
-		else // assume que é 4 canais png
+		else
 		{
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+			cout << "ACMR " << prepared.stats.acmr << ", ATVR " << prepared.stats.atvr << endl;
 		}
-		glGenerateMipmap(GL_TEXTURE_2D);
 	}
-	else
+
+	if (!layout.lods.empty())
 	{
-		std::cout << "Failed to load texture " << filePath << std::endl;
+		cout << "    niveis de detalhe: " << drawStats.mesh(obj.meshStats).triangleCount;
+		for (const MeshLod& lod : layout.lods)
+			cout << " -> " << lod.count / 3;
+		cout << " triangulos (erro";
+		for (size_t l = 0; l < layout.lods.size(); l++)
+			cout << (l == 0 ? " " : ", ") << 100.0f * layout.lods[l].error << "%";
+		cout << " do raio)" << endl;
 	}
+}
 
-	stbi_image_free(data);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
+void shareMesh(const Object& source, Object& obj)
+{
+	// Mesmos buffers e faixas de desenho; os materiais são associados depois, em bindMaterials
+	obj.VAO = source.VAO;
+	obj.VBO = source.VBO;
+	obj.EBO = source.EBO;
+	obj.nVertices = source.nVertices;
+	obj.nIndices = source.nIndices;
+	obj.indexType = source.indexType;
+	obj.firstIndex = source.firstIndex;
+	obj.baseVertex = source.baseVertex;
+	obj.posScale = source.posScale;
+	obj.posOffset = source.posOffset;
+	obj.boundsMin = source.boundsMin;
+	obj.boundsMax = source.boundsMax;
+	obj.sphereCenter = source.sphereCenter;
+	obj.sphereRadius = source.sphereRadius;
+	obj.lodCount = source.lodCount;
+	std::copy(source.lodError, source.lodError + MAX_MESH_LODS, obj.lodError);
+	obj.geometryBytes = 0;
+	obj.meshStats = source.meshStats;
+	obj.drawRanges = source.drawRanges;
+	obj.sharedMesh = true;
+}
 
-	return texID;
+GLuint loadTexture(string filePath)
+{
+	// Decodifica e envia só na primeira vez; depois conta mais uma referência
+	return textureCache.acquire(filePath);
 }
 
-void loadMTL(string filePath, Object &obj)
+bool loadMTL(string filePath, std::vector<Material> &materials)
 {
 	ifstream arqEntrada;
 
@@ -791,32 +2045,56 @@ void loadMTL(string filePath, Object &obj)
 			istringstream ssline(line);
 			string word;
 			ssline >> word;
+			if (word == "newmtl")
+			{
+				Material material;
+				ssline >> material.name;
+				materials.push_back(material);
+			}
+			if (materials.empty())
+			{
+				continue;
+			}
 			if (word == "Kd")
 			{
-				glm::vec3 kValue;
-				ssline >> kValue.x >> kValue.y >> kValue.z;
-				obj.kd = (kValue.x + kValue.y + kValue.z) / 3.0f;
-
+				ssline >> materials.back().kd.x >> materials.back().kd.y >> materials.back().kd.z;
 			}
 			if (word == "Ka")
 			{
-				glm::vec3 kValue;
-				ssline >> kValue.x >> kValue.y >> kValue.z;
-				obj.ka = (kValue.x + kValue.y + kValue.z) / 3.0f;
-
+				ssline >> materials.back().ka.x >> materials.back().ka.y >> materials.back().ka.z;
 			}
 			if (word == "Ks")
 			{
-				glm::vec3 kValue;
-				ssline >> kValue.x >> kValue.y >> kValue.z;
-				obj.ks = (kValue.x + kValue.y + kValue.z) / 3.0f;
+				ssline >> materials.back().ks.x >> materials.back().ks.y >> materials.back().ks.z;
 			}
 		}
 
 		arqEntrada.close();
+		return true;
+	}
+	return false;
+}
 
-		cout << "Arquivo .mtl lido" << endl;
+void bindMaterials(Object &obj)
+{
+	// Associa cada faixa ao material de mesmo nome (se não houver, usa o padrão)
+	for (DrawRange& range : obj.drawRanges)
+	{
+		range.material = -1;
+		for (size_t i = 0; i < obj.materials.size(); i++)
+		{
+			if (obj.materials[i].name == range.materialName)
+			{
+				range.material = (int)i;
+				break;
+			}
+		}
 	}
+
+	// Faixas ordenadas por nível e material: uma troca de material por material em cada nível
+	std::stable_sort(obj.drawRanges.begin(), obj.drawRanges.end(), [](const DrawRange& a, const DrawRange& b) {
+		return a.lod != b.lod ? a.lod < b.lod : a.material < b.material;
+	});
 }
 
 std::vector<glm::vec3> generateInfiniteControlPoints(int numPoints)
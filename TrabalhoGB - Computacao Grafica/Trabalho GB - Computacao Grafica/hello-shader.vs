@@ -3,14 +3,23 @@ layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
 
 uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
+
+//Dados do frame (FrameUniforms): câmera, projeção e luz, compartilhados entre os programas
+layout (std140) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 lightPos;
+	vec4 lightColor;
+};
 
 out vec4 finalColor;
 
 void main()
 {
 	//...pode ter mais linhas de código aqui!
-	gl_Position = projection * view * model * vec4(position, 1.0);
+	gl_Position = viewProjection * model * vec4(position, 1.0);
 	finalColor = vec4(color, 1.0);
 }
\ No newline at end of file
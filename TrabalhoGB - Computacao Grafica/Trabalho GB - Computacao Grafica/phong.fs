@@ -1,46 +1,67 @@
 #version 430
 
-in vec3 finalColor;
 in vec2 texCoord;
 in vec3 scaledNormal;
 in vec3 fragPos;
+flat in float layer;
+flat in int material;
 
-//Propriedades da superficie
-uniform float ka, kd, ks, q;
+//Propriedades da superficie (coeficientes do material, por canal); nos desenhos
+//indiretos vêm da tabela de materiais (três texels por material: ka, kd, ks)
+uniform vec3 ka, kd, ks;
+uniform float q;
+uniform samplerBuffer materialTable;
 
-//Propriedades da fonte de luz
-uniform vec3 lightPos, lightColor;
-
-//Propriedades da câmera
-uniform vec3 cameraPos;
+//Dados do frame (FrameUniforms): câmera, projeção e luz, compartilhados entre os programas
+layout (std140) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 lightPos;
+	vec4 lightColor;
+};
 
 out vec4 color;
 //Buffer da textura
 uniform sampler2D texBuffer;
 
+//Arrays de textura (unidades 1 a 8): com textureArray >= 0 a cor vem da camada
+//layer do array (textureLayer ou a da instância), e não do texBuffer
+uniform sampler2DArray textureArrays[8];
+uniform int textureArray;
+
 void main()
 {
 
+    vec3 matKa = ka, matKd = kd, matKs = ks;
+    if (material >= 0) {
+        matKa = texelFetch(materialTable, 3 * material).rgb;
+        matKd = texelFetch(materialTable, 3 * material + 1).rgb;
+        matKs = texelFetch(materialTable, 3 * material + 2).rgb;
+    }
+
     //Coeficiente luz ambiente
-    vec3 ambient = ka * lightColor;
+    vec3 ambient = matKa * lightColor.rgb;
 
 
     //Coeficiente reflexão difusa
     vec3 diffuse;
     vec3 N = normalize(scaledNormal);
-    vec3 L = normalize(lightPos - fragPos);
+    vec3 L = normalize(lightPos.xyz - fragPos);
     float diff = max(dot(N,L),0.0);
-    diffuse = kd * diff * lightColor;
+    diffuse = matKd * diff * lightColor.rgb;
 
     //Coeficiente reflexão especular
     vec3 specular;
     vec3 R = normalize(reflect(-L,N));
-    vec3 V = normalize(cameraPos - fragPos);
+    vec3 V = normalize(cameraPos.xyz - fragPos);
     float spec = max(dot(R,V),0.0);
     spec = pow(spec,q);
-    specular = ks * spec * lightColor;
+    specular = matKs * spec * lightColor.rgb;
 
-    vec4 texColor = texture(texBuffer,texCoord);
+    vec4 texColor = textureArray >= 0 ? texture(textureArrays[textureArray], vec3(texCoord, layer)) : texture(texBuffer,texCoord);
     vec3 result = (ambient + diffuse) * vec3(texColor) + specular;
 
     color = vec4(result,1.0);
@@ -1,25 +1,50 @@
 #version 430
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 color;
 layout (location = 2) in vec2 texc;
 layout (location = 3) in vec3 normal;
 
 uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
+
+//Desenho instanciado (ou indireto): matriz de modelo, desquantização, camada do array
+//de textura e material vêm de cada instância (InstanceBuffer), e não dos uniforms
+uniform bool instanced;
+layout (location = 4) in mat4 instanceModel;
+layout (location = 8) in vec4 instanceScale;   //xyz: posScale, w: camada
+layout (location = 9) in vec4 instanceOffset;  //xyz: posOffset, w: material (-1: ka, kd, ks)
+uniform float textureLayer;
+
+//Dados do frame (FrameUniforms): câmera, projeção e luz, compartilhados entre os programas
+layout (std140) uniform FrameData
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPos;
+	vec4 lightPos;
+	vec4 lightColor;
+};
+
+//Desquantização da posição: no formato compacto a posição chega normalizada
+//em [0,1] dentro da caixa envolvente da malha (no formato float: escala 1, deslocamento 0)
+uniform vec3 posScale;
+uniform vec3 posOffset;
 
 //Variáveis que irão para o fragment shader
-out vec3 finalColor;
 out vec2 texCoord;
 out vec3 scaledNormal;
 out vec3 fragPos;
+flat out float layer;
+flat out int material;
 
 void main()
 {
 	//...pode ter mais linhas de código aqui!
-	gl_Position = projection * view * model * vec4(position, 1.0);
-	finalColor = color;
+	vec3 localPos = instanced ? instanceOffset.xyz + instanceScale.xyz * position : posOffset + posScale * position;
+	mat4 objectModel = instanced ? instanceModel : model;
+	gl_Position = viewProjection * objectModel * vec4(localPos, 1.0);
     texCoord = vec2(texc.s, 1 - texc.t);
-    fragPos = vec3(model * vec4(position, 1.0));
-    scaledNormal = vec3(model * vec4(normal, 1.0));
+    fragPos = vec3(objectModel * vec4(localPos, 1.0));
+    scaledNormal = vec3(objectModel * vec4(normal, 1.0));
+    layer = instanced ? instanceScale.w : textureLayer;
+    material = instanced ? int(instanceOffset.w) : -1;
 }
\ No newline at end of file